@@ -1,159 +1,260 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
-
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances,
+                                     ReplacerType replacer_type)
     : pool_size_(pool_size), disk_manager_(disk_manager) {
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    free_list_.emplace_back(i);
+  ASSERT(num_instances > 0 && num_instances <= pool_size, "Invalid number of buffer pool instances.");
+  // 余下的 frame 分给前几个 instance
+  for (size_t i = 0; i < num_instances; i++) {
+    size_t instance_size = pool_size / num_instances + (i < pool_size % num_instances ? 1 : 0);
+    instances_.push_back(new BufferPoolManagerInstance(instance_size, num_instances, i, disk_manager_, replacer_type));
   }
 }
 
 BufferPoolManager::~BufferPoolManager() {
-  for (auto page : page_table_) {
-    FlushPage(page.first);
+  StopFlusher();
+  for (auto instance : instances_) {
+    delete instance;
   }
-  delete[] pages_;
-  delete replacer_;
 }
 
-
 Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-    if (page_id >= MAX_VALID_PAGE_ID){
-        return nullptr;
+  if (page_id < 0 || page_id >= MAX_VALID_PAGE_ID) {
+    return nullptr;
+  }
+  return GetInstance(page_id)->FetchPage(page_id);
+}
+
+Page *BufferPoolManager::NewPage(page_id_t &page_id) {
+  page_id = AllocatePage();
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  Page *page = GetInstance(page_id)->NewPage(page_id);
+  if (page == nullptr) {
+    // 对应的 instance 已满，归还刚分配的页
+    DeallocatePage(page_id);
+    page_id = INVALID_PAGE_ID;
+  }
+  return page;
+}
+
+Page *BufferPoolManager::NewPage(page_id_t &page_id, PageExtent *extent) {
+  if (extent->next_page_id_ == extent->end_page_id_) {
+    size_t run_size = extent->run_size_ == 0 ? DEFAULT_EXTENT_MIN_PAGES
+                                             : std::min<size_t>(extent->run_size_ * 2, DEFAULT_EXTENT_MAX_PAGES);
+    page_id_t first_page_id = AllocateExtent(run_size);
+    if (first_page_id == INVALID_PAGE_ID) {
+      return NewPage(page_id);
     }
-    if (page_table_.find(page_id) != page_table_.end()){
-        frame_id_t new_frame = page_table_[page_id];
-        pages_[new_frame].pin_count_++;
-        replacer_->Pin(new_frame);
-        return &(pages_[new_frame]);
+    extent->next_page_id_ = first_page_id;
+    extent->end_page_id_ = first_page_id + static_cast<page_id_t>(run_size);
+    extent->run_size_ = run_size;
+  }
+  Page *page = GetInstance(extent->next_page_id_)->NewPage(extent->next_page_id_);
+  if (page == nullptr) {
+    // 页仍留在 extent 中，下次再用
+    page_id = INVALID_PAGE_ID;
+    return nullptr;
+  }
+  page_id = extent->next_page_id_++;
+  return page;
+}
+
+page_id_t BufferPoolManager::AllocateExtent(size_t count) {
+  return disk_manager_->AllocatePages(count);
+}
+
+void BufferPoolManager::ReleaseExtent(PageExtent *extent) {
+  for (; extent->next_page_id_ != extent->end_page_id_; extent->next_page_id_++) {
+    DeallocatePage(extent->next_page_id_);
+  }
+}
+
+size_t BufferPoolManager::PrefetchPages(const vector<page_id_t> &page_ids) {
+  vector<vector<page_id_t>> instance_pages(instances_.size());
+  for (auto page_id : page_ids) {
+    if (page_id >= 0 && page_id < MAX_VALID_PAGE_ID) {
+      instance_pages[static_cast<uint32_t>(page_id) % instances_.size()].push_back(page_id);
+    }
+  }
+  vector<vector<BufferPoolManagerInstance::ReservedFrame>> reserved(instances_.size());
+  vector<pair<page_id_t, char *>> reads;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (instance_pages[i].empty()) {
+      continue;
+    }
+    instances_[i]->ReserveFrames(instance_pages[i], &reserved[i]);
+    for (auto &frame : reserved[i]) {
+      reads.emplace_back(frame.page_id_, frame.data_);
     }
-    if (!free_list_.empty()){
-        frame_id_t new_frame = free_list_.front();
-        free_list_.pop_front();
-        latch_.lock();
-        disk_manager_->ReadPage(page_id,pages_[new_frame].GetData());
-        latch_.unlock();
-        pages_[new_frame].pin_count_ = 1;
-        pages_[new_frame].page_id_ = page_id;
-        page_table_.erase(pages_[new_frame].page_id_);
-        // 添加新映射
-        page_table_.insert({page_id,new_frame});
-        return &(pages_[new_frame]);
+  }
+  if (reads.empty()) {
+    return 0;
+  }
+  sort(reads.begin(), reads.end());
+  vector<page_id_t> failed;
+  disk_manager_->ReadPages(reads, io_queue_depth_, &failed);
+  for (auto page_id : failed) {
+    for (auto &frame : reserved[static_cast<uint32_t>(page_id) % instances_.size()]) {
+      frame.read_failed_ = frame.read_failed_ || frame.page_id_ == page_id;
     }
-    else{
-        frame_id_t new_frame;
-        bool isSuccess = replacer_->Victim(&new_frame);
-        if (!isSuccess)return nullptr;
-        if (pages_[new_frame].IsDirty()){
-            latch_.lock();
-            disk_manager_->WritePage(pages_[new_frame].GetPageId(),pages_[new_frame].GetData());
-            latch_.unlock();
-            pages_[new_frame].is_dirty_=false;
-        }
-        latch_.lock();
-        disk_manager_->ReadPage(page_id,pages_[new_frame].GetData());
-        latch_.unlock();
-        pages_[new_frame].pin_count_ = 1;
-        pages_[new_frame].page_id_ = page_id;
-        page_table_.erase(pages_[new_frame].page_id_);
-        page_table_.insert({page_id,new_frame});
-        return &(pages_[new_frame]);
+  }
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (!reserved[i].empty()) {
+      instances_[i]->PublishFrames(reserved[i]);
     }
+  }
+  return reads.size() - failed.size();
+}
 
-  return nullptr;
+void BufferPoolManager::ReadAhead(ReadAheadState *state, page_id_t page_id, const NextPagesFunc &next_pages) {
+  bool sequential = false;
+  if (read_ahead_ && state->last_page_id_ != INVALID_PAGE_ID) {
+    vector<page_id_t> next_page_ids;
+    next_pages(state->last_page_id_, 1, &next_page_ids);
+    sequential = !next_page_ids.empty() && next_page_ids.front() == page_id;
+  }
+  state->last_page_id_ = page_id;
+  if (!sequential) {
+    state->window_ = 0;
+    state->ahead_ = 0;
+    state->last_prefetched_id_ = INVALID_PAGE_ID;
+    return;
+  }
+  if (state->ahead_ > 0) {
+    state->ahead_--;
+  }
+  // 已预读的页还够用，等扫描接近窗口的后半段再发起下一批
+  if (state->window_ != 0 && state->ahead_ >= state->window_ / 2) {
+    return;
+  }
+  size_t window = state->window_ == 0 ? DEFAULT_READ_AHEAD_MIN_PAGES
+                                      : std::min<size_t>(state->window_ * 2, DEFAULT_READ_AHEAD_MAX_PAGES);
+  window = std::min(window, GetReadAheadBudget());
+  state->window_ = window;
+  if (window == 0) {
+    return;
+  }
+  // 从已预读的最后一页之后接着取，只取对象自己的页
+  vector<page_id_t> page_ids;
+  next_pages(state->ahead_ == 0 ? page_id : state->last_prefetched_id_, window, &page_ids);
+  if (page_ids.empty()) {
+    return;
+  }
+  PrefetchPages(page_ids);
+  state->ahead_ += page_ids.size();
+  state->last_prefetched_id_ = page_ids.back();
 }
 
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-    frame_id_t new_frame;
-    if (!free_list_.empty()){
-        page_id = AllocatePage();
-        if (page_id == INVALID_PAGE_ID) {
-            return nullptr;
-        }
-        new_frame = free_list_.front();
-        free_list_.pop_front();
-    }
-    else{
-        bool isSuccess = replacer_->Victim(&new_frame);
-        if (!isSuccess)return nullptr;
-        page_id = AllocatePage();
-        //这一步要放在后面isSuccess的后面，不然有问题
-        if (page_id == INVALID_PAGE_ID) {
-            return nullptr;
-        }
-        if (pages_[new_frame].IsDirty()){
-            latch_.lock();
-            disk_manager_->WritePage(pages_[new_frame].GetPageId(),pages_[new_frame].GetData());
-            latch_.unlock();
-            pages_[new_frame].is_dirty_=false;
-        }
-        page_table_.erase(pages_[new_frame].page_id_);
-    }
-    pages_[new_frame].ResetMemory();
-    page_table_[page_id] = new_frame;
-    pages_[new_frame].pin_count_ = 1;
-    pages_[new_frame].page_id_ = page_id;
-    return &(pages_[new_frame]);
+size_t BufferPoolManager::GetReadAheadBudget() {
+  size_t budget = 0;
+  for (auto instance : instances_) {
+    budget += instance->GetReadAheadBudget();
+  }
+  return budget;
 }
 
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
-    frame_id_t delete_frame;
-    if (page_table_.find(page_id)==page_table_.end()){
-        DeallocatePage(page_id);
-        return true;
-    }
-    else{
-        delete_frame = page_table_[page_id];
-        if (pages_[delete_frame].pin_count_!=0){
-            return false;
-        }
-        else{
-            pages_[delete_frame].ResetMemory();
-            pages_[delete_frame].page_id_ = INVALID_PAGE_ID;
-            pages_[delete_frame].is_dirty_ = false;
-            page_table_.erase(page_id);
-            replacer_->Unpin(delete_frame);
-            free_list_.push_back(delete_frame);
-            DeallocatePage(page_id);
-            return true;
-        }
-    }
+  if (page_id < 0) {
+    return false;
+  }
+  if (!GetInstance(page_id)->DeletePage(page_id)) {
+    return false;
+  }
+  DeallocatePage(page_id);
+  return true;
 }
 
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-    if (page_table_.find(page_id)==page_table_.end()){
-        return false;
-    }
-    else{
-        frame_id_t unpin_frame = page_table_[page_id];
-        if (pages_[unpin_frame].pin_count_==0)return true;
-        pages_[unpin_frame].pin_count_--;
-        if (pages_[unpin_frame].pin_count_==0){
-            replacer_->Unpin(unpin_frame);
-        }
-        return true;
+  if (page_id < 0) {
+    return false;
+  }
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool BufferPoolManager::FlushPage(page_id_t page_id) {
+  if (page_id < 0) {
+    return false;
+  }
+  return GetInstance(page_id)->FlushPage(page_id);
+}
+
+void BufferPoolManager::StartFlusher(chrono::milliseconds interval, double high_watermark, double low_watermark) {
+  ASSERT(low_watermark <= high_watermark, "Invalid dirty page watermarks.");
+  std::scoped_lock<std::mutex> lock(flusher_latch_);
+  if (flusher_running_) {
+    return;
+  }
+  flush_interval_ = interval;
+  high_watermark_ = high_watermark;
+  low_watermark_ = low_watermark;
+  flusher_running_ = true;
+  flusher_ = thread(&BufferPoolManager::FlusherLoop, this);
+}
+
+void BufferPoolManager::StopFlusher() {
+  {
+    std::scoped_lock<std::mutex> lock(flusher_latch_);
+    if (!flusher_running_) {
+      return;
     }
+    flusher_running_ = false;
+  }
+  flusher_cv_.notify_all();
+  flusher_.join();
 }
 
+void BufferPoolManager::FlusherLoop() {
+  unique_lock<mutex> lock(flusher_latch_);
+  while (flusher_running_) {
+    flusher_cv_.wait_for(lock, flush_interval_, [this]() { return !flusher_running_; });
+    if (!flusher_running_) {
+      break;
+    }
+    auto high = static_cast<size_t>(high_watermark_ * pool_size_);
+    auto low = static_cast<size_t>(low_watermark_ * pool_size_);
+    lock.unlock();
+    if (GetDirtyCount() >= high) {
+      FlushDirtyPages(low);
+    }
+    disk_manager_->FlushMetadata();
+    lock.lock();
+  }
+}
 
-bool BufferPoolManager::FlushPage(page_id_t page_id) {
-    if (page_table_.find(page_id)==page_table_.end()){
-        return false;
+size_t BufferPoolManager::FlushDirtyPages(size_t target) {
+  vector<page_id_t> page_ids;
+  for (auto instance : instances_) {
+    instance->GetUnpinnedDirtyPages(&page_ids);
+  }
+  // 按页号顺序写回，尽量让磁盘写变成顺序写
+  sort(page_ids.begin(), page_ids.end());
+  size_t dirty = GetDirtyCount();
+  size_t written = 0;
+  for (auto page_id : page_ids) {
+    if (dirty <= target) {
+      break;
     }
-    else{
-        frame_id_t flush_frame = page_table_[page_id];
-        latch_.lock();
-        disk_manager_->WritePage(pages_[flush_frame].GetPageId(),pages_[flush_frame].GetData());
-        latch_.unlock();
-        return true;
+    if (GetInstance(page_id)->FlushUnpinnedPage(page_id)) {
+      dirty--;
+      written++;
     }
-  return false;
+  }
+  return written;
+}
+
+size_t BufferPoolManager::GetDirtyCount() {
+  size_t dirty = 0;
+  for (auto instance : instances_) {
+    dirty += instance->GetDirtyCount();
+  }
+  return dirty;
 }
 
 page_id_t BufferPoolManager::AllocatePage() {
@@ -172,11 +273,8 @@ bool BufferPoolManager::IsPageFree(page_id_t page_id) {
 // Only used for debug
 bool BufferPoolManager::CheckAllUnpinned() {
   bool res = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ != 0) {
-      res = false;
-      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
-    }
+  for (auto instance : instances_) {
+    res = instance->CheckAllUnpinned() && res;
   }
   return res;
-}
\ No newline at end of file
+}
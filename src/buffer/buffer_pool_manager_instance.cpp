@@ -0,0 +1,326 @@
+#include "buffer/buffer_pool_manager_instance.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances,
+                                                     uint32_t instance_index, DiskManager *disk_manager,
+                                                     ReplacerType replacer_type)
+    : pool_size_(pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      disk_manager_(disk_manager) {
+  ASSERT(num_instances_ > 0 && instance_index_ < num_instances_, "Invalid buffer pool instance index.");
+  pages_ = new Page[pool_size_];
+  io_states_ = new FrameIOState[pool_size_];
+  replacer_ = Replacer::Create(replacer_type, pool_size_);
+  for (size_t i = 0; i < pool_size_; i++) {
+    free_list_.emplace_back(i);
+  }
+}
+
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  FlushAllPages();
+  delete[] pages_;
+  delete[] io_states_;
+  delete replacer_;
+}
+
+frame_id_t BufferPoolManagerInstance::ReserveFrame(page_id_t page_id, page_id_t *victim_page_id) {
+  frame_id_t frame_id;
+  *victim_page_id = INVALID_PAGE_ID;
+  if (!free_list_.empty()) {
+    frame_id = free_list_.front();
+    free_list_.pop_front();
+  } else {
+    if (!replacer_->Victim(&frame_id)) {
+      return INVALID_FRAME_ID;
+    }
+    Page &victim = pages_[frame_id];
+    // 必须在覆盖 page_id_ 之前删除旧映射
+    page_table_.erase(victim.page_id_);
+    if (victim.is_dirty_) {
+      *victim_page_id = victim.page_id_;
+      evicting_.emplace(victim.page_id_, frame_id);
+    }
+  }
+  Page &page = pages_[frame_id];
+  SetDirty(page, false);
+  page.page_id_ = page_id;
+  page.pin_count_ = 1;
+  page_table_[page_id] = frame_id;
+  io_states_[frame_id].in_progress_ = true;
+  return frame_id;
+}
+
+void BufferPoolManagerInstance::PublishFrame(frame_id_t frame_id, page_id_t victim_page_id) {
+  if (victim_page_id != INVALID_PAGE_ID) {
+    evicting_.erase(victim_page_id);
+  }
+  io_states_[frame_id].in_progress_ = false;
+  io_states_[frame_id].cv_.notify_all();
+}
+
+void BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id) {
+  if (--pages_[frame_id].pin_count_ != 0) {
+    return;
+  }
+  if (pages_[frame_id].page_id_ == INVALID_PAGE_ID) {
+    free_list_.push_back(frame_id);
+  } else {
+    replacer_->Unpin(frame_id);
+  }
+}
+
+void BufferPoolManagerInstance::WaitForIO(unique_lock<mutex> &lock, frame_id_t frame_id) {
+  io_states_[frame_id].cv_.wait(lock, [&]() { return !io_states_[frame_id].in_progress_; });
+}
+
+Page *BufferPoolManagerInstance::FetchPage(page_id_t page_id) {
+  if (page_id < 0 || page_id >= MAX_VALID_PAGE_ID) {
+    return nullptr;
+  }
+  ASSERT(static_cast<uint32_t>(page_id) % num_instances_ == instance_index_, "Page routed to wrong instance.");
+  unique_lock<mutex> lock(latch_);
+  while (true) {
+    auto iter = page_table_.find(page_id);
+    if (iter != page_table_.end()) {
+      // 命中；若该页仍在读入，只在这个 frame 上等待
+      frame_id_t frame_id = iter->second;
+      pages_[frame_id].pin_count_++;
+      replacer_->Pin(frame_id);
+      WaitForIO(lock, frame_id);
+      if (pages_[frame_id].page_id_ == page_id) {
+        return &pages_[frame_id];
+      }
+      // 预读失败，frame 已不再对应该页，重新查找
+      UnpinFrame(frame_id);
+      continue;
+    }
+    // 该页作为脏 victim 正在写回，写完之前不能从磁盘读旧数据
+    auto evict_iter = evicting_.find(page_id);
+    if (evict_iter == evicting_.end()) {
+      break;
+    }
+    WaitForIO(lock, evict_iter->second);
+  }
+  page_id_t victim_page_id;
+  frame_id_t frame_id = ReserveFrame(page_id, &victim_page_id);
+  if (frame_id == INVALID_FRAME_ID) {
+    return nullptr;
+  }
+  Page &page = pages_[frame_id];
+  lock.unlock();
+  if (victim_page_id != INVALID_PAGE_ID) {
+    disk_manager_->WritePage(victim_page_id, page.GetData());
+  }
+  disk_manager_->ReadPage(page_id, page.GetData());
+  lock.lock();
+  PublishFrame(frame_id, victim_page_id);
+  return &page;
+}
+
+Page *BufferPoolManagerInstance::NewPage(page_id_t page_id) {
+  unique_lock<mutex> lock(latch_);
+  page_id_t victim_page_id;
+  frame_id_t frame_id = ReserveFrame(page_id, &victim_page_id);
+  if (frame_id == INVALID_FRAME_ID) {
+    return nullptr;
+  }
+  Page &page = pages_[frame_id];
+  lock.unlock();
+  if (victim_page_id != INVALID_PAGE_ID) {
+    disk_manager_->WritePage(victim_page_id, page.GetData());
+  }
+  page.ResetMemory();
+  lock.lock();
+  PublishFrame(frame_id, victim_page_id);
+  return &page;
+}
+
+void BufferPoolManagerInstance::ReserveFrames(const vector<page_id_t> &page_ids, vector<ReservedFrame> *reserved) {
+  vector<pair<page_id_t, const char *>> victims;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (auto page_id : page_ids) {
+      if (page_table_.find(page_id) != page_table_.end() || evicting_.find(page_id) != evicting_.end()) {
+        continue;
+      }
+      page_id_t victim_page_id;
+      frame_id_t frame_id = ReserveFrame(page_id, &victim_page_id);
+      if (frame_id == INVALID_FRAME_ID) {
+        break;
+      }
+      char *data = pages_[frame_id].GetData();
+      reserved->push_back({page_id, frame_id, victim_page_id, data});
+      if (victim_page_id != INVALID_PAGE_ID) {
+        victims.emplace_back(victim_page_id, data);
+      }
+    }
+  }
+  vector<page_id_t> failed;
+  if (victims.empty() || disk_manager_->WritePages(victims, DEFAULT_IO_QUEUE_DEPTH, &failed)) {
+    return;
+  }
+  // 写回失败的 victim 仍是 frame 中唯一的新数据，把 frame 还给它并保持脏页，不再用它预读
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto kept = reserved->begin();
+  for (auto &frame : *reserved) {
+    if (frame.victim_page_id_ == INVALID_PAGE_ID ||
+        std::find(failed.begin(), failed.end(), frame.victim_page_id_) == failed.end()) {
+      *kept++ = frame;
+      continue;
+    }
+    Page &page = pages_[frame.frame_id_];
+    page_table_.erase(frame.page_id_);
+    page.page_id_ = frame.victim_page_id_;
+    page_table_[frame.victim_page_id_] = frame.frame_id_;
+    SetDirty(page, true);
+    PublishFrame(frame.frame_id_, frame.victim_page_id_);
+    UnpinFrame(frame.frame_id_);
+  }
+  reserved->erase(kept, reserved->end());
+}
+
+void BufferPoolManagerInstance::PublishFrames(const vector<ReservedFrame> &reserved) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (auto &frame : reserved) {
+    if (frame.read_failed_) {
+      // 帧中不是该页的内容，不能当作缓存；等待者醒来后会重新读
+      Page &page = pages_[frame.frame_id_];
+      page_table_.erase(frame.page_id_);
+      page.ResetMemory();
+      page.page_id_ = INVALID_PAGE_ID;
+    }
+    PublishFrame(frame.frame_id_, frame.victim_page_id_);
+    UnpinFrame(frame.frame_id_);
+  }
+}
+
+bool BufferPoolManagerInstance::DeletePage(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto iter = page_table_.find(page_id);
+  if (iter == page_table_.end()) {
+    return true;
+  }
+  frame_id_t frame_id = iter->second;
+  Page &page = pages_[frame_id];
+  if (page.pin_count_ != 0) {
+    return false;
+  }
+  page.ResetMemory();
+  page.page_id_ = INVALID_PAGE_ID;
+  SetDirty(page, false);
+  page_table_.erase(iter);
+  replacer_->Remove(frame_id);
+  free_list_.push_back(frame_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto iter = page_table_.find(page_id);
+  if (iter == page_table_.end()) {
+    return false;
+  }
+  Page &page = pages_[iter->second];
+  if (is_dirty) {
+    SetDirty(page, true);
+  }
+  if (page.pin_count_ == 0) {
+    return true;
+  }
+  if (--page.pin_count_ == 0) {
+    replacer_->Unpin(iter->second);
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushPage(page_id_t page_id) {
+  unique_lock<mutex> lock(latch_);
+  auto iter = page_table_.find(page_id);
+  if (iter == page_table_.end()) {
+    return false;
+  }
+  FlushFrame(lock, iter->second);
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushUnpinnedPage(page_id_t page_id) {
+  unique_lock<mutex> lock(latch_);
+  auto iter = page_table_.find(page_id);
+  if (iter == page_table_.end()) {
+    return false;
+  }
+  Page &page = pages_[iter->second];
+  if (page.pin_count_ != 0 || !page.is_dirty_) {
+    return false;
+  }
+  FlushFrame(lock, iter->second);
+  return true;
+}
+
+void BufferPoolManagerInstance::FlushFrame(unique_lock<mutex> &lock, frame_id_t frame_id) {
+  // pin 住该页，写盘期间不持有 latch_
+  Page &page = pages_[frame_id];
+  page.pin_count_++;
+  replacer_->Pin(frame_id);
+  WaitForIO(lock, frame_id);
+  if (page.page_id_ == INVALID_PAGE_ID) {
+    // 预读失败，frame 已被清空
+    UnpinFrame(frame_id);
+    return;
+  }
+  SetDirty(page, false);
+  lock.unlock();
+  disk_manager_->WritePage(page.page_id_, page.GetData());
+  lock.lock();
+  UnpinFrame(frame_id);
+}
+
+void BufferPoolManagerInstance::FlushAllPages() {
+  vector<page_id_t> page_ids;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (auto &entry : page_table_) {
+      page_ids.push_back(entry.first);
+    }
+  }
+  for (auto page_id : page_ids) {
+    FlushPage(page_id);
+  }
+}
+
+size_t BufferPoolManagerInstance::GetDirtyCount() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return num_dirty_;
+}
+
+void BufferPoolManagerInstance::GetUnpinnedDirtyPages(vector<page_id_t> *page_ids) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (auto &entry : page_table_) {
+    Page &page = pages_[entry.second];
+    if (page.is_dirty_ && page.pin_count_ == 0 && !io_states_[entry.second].in_progress_) {
+      page_ids->push_back(entry.first);
+    }
+  }
+}
+
+size_t BufferPoolManagerInstance::GetReadAheadBudget() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return free_list_.size() + replacer_->Size() / 4;
+}
+
+// Only used for debug
+bool BufferPoolManagerInstance::CheckAllUnpinned() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  bool res = true;
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (pages_[i].pin_count_ != 0) {
+      res = false;
+      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
+    }
+  }
+  return res;
+}
@@ -0,0 +1,51 @@
+#include "buffer/clock_replacer.h"
+
+CLOCKReplacer::CLOCKReplacer(size_t num_pages)
+    : capacity(num_pages), in_replacer(num_pages, 0), reference_bit(num_pages, 0) {}
+
+CLOCKReplacer::~CLOCKReplacer() = default;
+
+bool CLOCKReplacer::Victim(frame_id_t *frame_id) {
+  if (clock_size == 0) {
+    return false;
+  }
+  // 最多转两圈：第一圈清掉访问位，第二圈一定能找到
+  while (true) {
+    size_t current = clock_hand;
+    clock_hand = (clock_hand + 1) % capacity;
+    if (!in_replacer[current]) {
+      continue;
+    }
+    if (reference_bit[current]) {
+      reference_bit[current] = 0;
+      continue;
+    }
+    in_replacer[current] = 0;
+    clock_size--;
+    *frame_id = static_cast<frame_id_t>(current);
+    return true;
+  }
+}
+
+void CLOCKReplacer::Pin(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= capacity || !in_replacer[frame_id]) {
+    return;
+  }
+  in_replacer[frame_id] = 0;
+  clock_size--;
+}
+
+void CLOCKReplacer::Unpin(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= capacity) {
+    return;
+  }
+  reference_bit[frame_id] = 1;
+  if (!in_replacer[frame_id]) {
+    in_replacer[frame_id] = 1;
+    clock_size++;
+  }
+}
+
+size_t CLOCKReplacer::Size() {
+  return clock_size;
+}
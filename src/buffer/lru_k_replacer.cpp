@@ -0,0 +1,50 @@
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k)
+    : num_pages_(num_pages), k_(k), history_(num_pages * k, 0), access_count_(num_pages, 0),
+      evictable_(num_pages, false) {
+  ASSERT(k_ > 0, "LRU-K requires k > 0.");
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  auto &queue = history_queue_.empty() ? cache_queue_ : history_queue_;
+  if (queue.empty()) {
+    return false;
+  }
+  *frame_id = queue.begin()->second;
+  queue.erase(queue.begin());
+  evictable_[*frame_id] = false;
+  access_count_[*frame_id] = 0;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= num_pages_ || !evictable_[frame_id]) {
+    return;
+  }
+  QueueOf(frame_id).erase({EvictionKey(frame_id), frame_id});
+  evictable_[frame_id] = false;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= num_pages_ || evictable_[frame_id]) {
+    return;
+  }
+  history_[frame_id * k_ + access_count_[frame_id] % k_] = current_timestamp_++;
+  access_count_[frame_id]++;
+  QueueOf(frame_id).emplace(EvictionKey(frame_id), frame_id);
+  evictable_[frame_id] = true;
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  Pin(frame_id);
+  if (frame_id >= 0 && static_cast<size_t>(frame_id) < num_pages_) {
+    access_count_[frame_id] = 0;
+  }
+}
+
+size_t LRUKReplacer::Size() {
+  return history_queue_.size() + cache_queue_.size();
+}
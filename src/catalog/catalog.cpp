@@ -77,8 +77,10 @@ CatalogManager::CatalogManager(BufferPoolManager *buffer_pool_manager, LockManag
       auto table_meta_page = buffer_pool_manager_->FetchPage(iter.second);
       TableMetadata *table_metadata = nullptr;
       TableMetadata::DeserializeFrom(table_meta_page->GetData(), table_metadata);
+      buffer_pool_manager_->UnpinPage(iter.second, false);
       table_names_[table_metadata->GetTableName()] = table_metadata->GetTableId();//设置table_names
-      TableHeap *table_heap = TableHeap::Create(buffer_pool_manager_, table_metadata->GetFirstPageId(), table_metadata->GetSchema(),log_manager_, lock_manager_);//创建table_heap
+      TableHeap *table_heap = TableHeap::Create(buffer_pool_manager_, table_metadata->GetFirstPageId(), table_metadata->GetSchema(),
+                                                log_manager_, lock_manager_, table_metadata->GetHeapMeta());//创建table_heap
       auto table_info = TableInfo::Create();
       table_info->Init(table_metadata, table_heap);
       tables_[table_metadata->GetTableId()] = table_info;
@@ -90,6 +92,7 @@ CatalogManager::CatalogManager(BufferPoolManager *buffer_pool_manager, LockManag
     auto index_meta_page = buffer_pool_manager_->FetchPage(iter.second);
     IndexMetadata *index_meta_data = nullptr;
     IndexMetadata::DeserializeFrom(index_meta_page->GetData(), index_meta_data);
+    buffer_pool_manager_->UnpinPage(iter.second, false);
     index_names_[tables_[index_meta_data->GetTableId()]->GetTableName()][index_meta_data->GetIndexName()] = index_meta_data->GetIndexId();
     IndexInfo *index_info = IndexInfo::Create();
     index_info->Init(index_meta_data, tables_[index_meta_data->GetTableId()], buffer_pool_manager_);
@@ -107,6 +110,7 @@ CatalogManager::CatalogManager(BufferPoolManager *buffer_pool_manager, LockManag
 }
 
 CatalogManager::~CatalogManager() {
+  FlushTableHeapMeta();
   FlushCatalogMetaPage();
   delete catalog_meta_;
   for (auto iter : tables_) {
@@ -133,7 +137,8 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
   auto table_heap = TableHeap::Create(buffer_pool_manager_, schema_copy,txn, log_manager_, lock_manager_);
   table_page_id = table_heap ->GetFirstPageId();
   // 创建 TableMetadata
-  TableMetadata *table_meta = TableMetadata::Create(table_id, table_name, table_page_id, schema_copy);
+  TableMetadata *table_meta =
+      TableMetadata::Create(table_id, table_name, table_page_id, schema_copy, table_heap->GetHeapMeta());
 
   // 分配元数据页面
   Page *meta_page = buffer_pool_manager_->NewPage(meta_page_id);
@@ -142,21 +147,11 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
     return DB_FAILED;
   }
 
-  // 分配表数据页面
-  Page *table_page = buffer_pool_manager_->NewPage(table_page_id);
-  if (table_page == nullptr) {
-    delete schema_copy;
-    buffer_pool_manager_->UnpinPage(meta_page_id, false);
-    return DB_FAILED;
-  }
-
   // 序列化元数据
   table_meta->SerializeTo(meta_page->GetData());
-  // 初始化 TableInfo
-  TableHeap* tableheap ;
-  tableheap = tableheap -> Create(buffer_pool_manager_, schema_copy, nullptr,nullptr,nullptr);
+  // 初始化 TableInfo，必须使用元数据中记录的那个 table heap
   table_info = TableInfo::Create();
-  table_info->Init(table_meta, tableheap);
+  table_info->Init(table_meta, table_heap);
   // 更新目录数据结构
   table_names_[table_name] = table_id;
   tables_[table_id] = table_info;
@@ -165,7 +160,6 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
   if (catalog_meta_page == nullptr) {
     delete schema_copy;
     buffer_pool_manager_->UnpinPage(meta_page_id, false);
-    buffer_pool_manager_->UnpinPage(table_page_id, false);
     return DB_FAILED;
   }
   catalog_meta_->table_meta_pages_[table_id] = meta_page_id;
@@ -175,7 +169,6 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
 
   // 释放页面
   buffer_pool_manager_->UnpinPage(meta_page_id, true);
-  buffer_pool_manager_->UnpinPage(table_page_id, true);
 
   return DB_SUCCESS;
 }
@@ -210,7 +203,7 @@ dberr_t CatalogManager::GetTables(vector<TableInfo *> &tables) const {
  */
 dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string &index_name,
   const std::vector<std::string> &index_keys, Txn *txn, IndexInfo *&index_info,
-  const string &index_type) {
+  const string &index_type, bool unique) {
 //table是否存在
     auto table = table_names_.find(table_name);
     if (table == table_names_.end()) {
@@ -244,15 +237,35 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
     page_id_t index_page_id, meta_page_id = 0;
     Page *meta_page = buffer_pool_manager_->NewPage(meta_page_id);
     Page *index_page = buffer_pool_manager_->NewPage(index_page_id);
-    IndexMetadata *index_meta = IndexMetadata::Create(index_id, index_name, table_id, key_map);
+    IndexMetadata *index_meta = IndexMetadata::Create(index_id, index_name, table_id, key_map, unique);
     index_meta->SerializeTo(meta_page->GetData());
     //更新index_info
     index_info->Init(index_meta, table_info, buffer_pool_manager_);
-    Row key;
-    for (auto it = table_info->GetTableHeap()->Begin(nullptr); it != table_info->GetTableHeap()->End(); it++) {
-      auto row = *it;
-      row.GetKeyFromRow(table_info->GetSchema(), index_info->GetIndexKeySchema(), key);
-      index_info->GetIndex()->InsertEntry(key, row.GetRowId(), txn);
+    // 一次扫描取出所有键，交给索引排序后自底向上建树
+    auto it = table_info->GetTableHeap()->Begin(nullptr);
+    auto end = table_info->GetTableHeap()->End();
+    auto next_entry = [&](Row &key, RowId &row_id) {
+      for (; it != end; ++it) {
+        const TupleView &view = it.GetTupleView();
+        if (view.IsValid()) {
+          view.Project(index_info->GetIndexKeySchema(), &key);
+          row_id = it.GetRowId();
+          ++it;
+          return true;
+        }
+      }
+      return false;
+    };
+    dberr_t result = index_info->GetIndex()->BulkLoad(next_entry, txn);
+    if (result != DB_SUCCESS) {
+      // 已有的行放不进这个索引，撤销建到一半的索引
+      delete index_info;
+      index_info = nullptr;
+      buffer_pool_manager_->UnpinPage(meta_page_id, false);
+      buffer_pool_manager_->DeletePage(meta_page_id);
+      buffer_pool_manager_->UnpinPage(index_page_id, false);
+      buffer_pool_manager_->DeletePage(index_page_id);
+      return result;
     }
     //init index
     index_names_[table_name][index_name] = index_id;
@@ -342,6 +355,26 @@ dberr_t CatalogManager::DropIndex(const string &table_name, const string &index_
   return DB_SUCCESS;
 }
 
+dberr_t CatalogManager::VacuumTable(const std::string &table_name, VacuumStats *stats, Txn *txn) {
+  TableInfo *table_info = nullptr;
+  if (GetTable(table_name, table_info) != DB_SUCCESS) {
+    return DB_TABLE_NOT_EXIST;
+  }
+  std::vector<IndexInfo *> indexes;
+  GetTableIndexes(table_name, indexes);
+  Schema *schema = table_info->GetSchema();
+  table_info->GetTableHeap()->Vacuum(stats, txn, [&](Row &row, const RowId &old_rid) {
+    // 元组搬到了新位置，索引项随之更新
+    for (auto index_info : indexes) {
+      Row key_row;
+      row.GetKeyFromRow(schema, index_info->GetIndexKeySchema(), key_row);
+      index_info->GetIndex()->RemoveEntry(key_row, old_rid, txn);
+      index_info->GetIndex()->InsertEntry(key_row, row.GetRowId(), txn);
+    }
+  });
+  return DB_SUCCESS;
+}
+
 /**
  * TODO: Student Implement
  */
@@ -350,6 +383,27 @@ dberr_t CatalogManager::FlushCatalogMetaPage() const {
   return DB_FAILED;
 }
 
+dberr_t CatalogManager::FlushTableHeapMeta() {
+  dberr_t result = DB_SUCCESS;
+  for (auto iter : catalog_meta_->table_meta_pages_) {
+    auto table_iter = tables_.find(iter.first);
+    if (table_iter == tables_.end()) {
+      continue;
+    }
+    TableMetadata *table_meta = table_iter->second->GetTableMeta();
+    TableHeapMeta heap_meta = table_iter->second->GetTableHeap()->GetHeapMeta();
+    auto page = buffer_pool_manager_->FetchPage(iter.second);
+    if (page == nullptr) {
+      result = DB_FAILED;
+      continue;
+    }
+    table_meta->SetHeapMeta(heap_meta);
+    table_meta->SerializeTo(page->GetData());
+    buffer_pool_manager_->UnpinPage(iter.second, true);
+  }
+  return result;
+}
+
 /**
  * TODO: Student Implement
  */
@@ -363,7 +417,8 @@ dberr_t CatalogManager::LoadTable(const table_id_t table_id, const page_id_t pag
   if (table_metadata == nullptr) {
     return DB_FAILED;
   }
-  auto table_heap = TableHeap::Create(buffer_pool_manager_, table_metadata->GetFirstPageId(), table_metadata->GetSchema(), log_manager_, lock_manager_);
+  auto table_heap = TableHeap::Create(buffer_pool_manager_, table_metadata->GetFirstPageId(), table_metadata->GetSchema(),
+                                      log_manager_, lock_manager_, table_metadata->GetHeapMeta());
   auto table_info = TableInfo::Create();
   table_info->Init(table_metadata, table_heap);
   tables_[table_id] = table_info;
@@ -1,12 +1,12 @@
 #include "catalog/indexes.h"
 
 IndexMetadata::IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                             const std::vector<uint32_t> &key_map)
-    : index_id_(index_id), index_name_(index_name), table_id_(table_id), key_map_(key_map) {}
+                             const std::vector<uint32_t> &key_map, bool unique)
+    : index_id_(index_id), index_name_(index_name), table_id_(table_id), key_map_(key_map), unique_(unique) {}
 
 IndexMetadata *IndexMetadata::Create(const index_id_t index_id, const string &index_name, const table_id_t table_id,
-                                     const vector<uint32_t> &key_map) {
-  return new IndexMetadata(index_id, index_name, table_id, key_map);
+                                     const vector<uint32_t> &key_map, bool unique) {
+  return new IndexMetadata(index_id, index_name, table_id, key_map, unique);
 }
 
 uint32_t IndexMetadata::SerializeTo(char *buf) const {
@@ -35,6 +35,9 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
     MACH_WRITE_UINT32(buf, col_index);
     buf += 4;
   }
+  // 记的是“不唯一”，这个字段出现之前写下的元数据在这里读到 0，仍是唯一索引
+  MACH_WRITE_UINT32(buf, unique_ ? 0 : 1);
+  buf += 4;
   ASSERT(buf - p == ofs, "Unexpected serialize size.");
   return ofs;
 }
@@ -45,7 +48,7 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
 uint32_t IndexMetadata::GetSerializedSize() const {
   return sizeof(INDEX_METADATA_MAGIC_NUM) + sizeof(index_id_t) + sizeof(index_name_.length())
          + index_name_.length() + sizeof(table_id_t) + sizeof(key_map_.size())
-         + key_map_.size() * sizeof(uint32_t) - 8;
+         + key_map_.size() * sizeof(uint32_t) + sizeof(uint32_t) - 8;
 }
 
 uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
@@ -78,23 +81,18 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
     buf += 4;
     key_map.push_back(key_index);
   }
+  // uniqueness
+  bool unique = MACH_READ_UINT32(buf) == 0;
+  buf += 4;
   // allocate space for index meta data
-  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map);
+  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map, unique);
   return buf - p;
 }
 
 Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const string &index_type) {
-  size_t max_size = 0;
-  uint32_t column_cnt = key_schema_->GetColumns().size();
-  size_t size_bitmap = (column_cnt % 8) ? column_cnt / 8 + 1 : column_cnt / 8;
-  // column_cnt + bitmap
-  max_size += 4 + sizeof(unsigned char) * size_bitmap;
-  for (auto col : key_schema_->GetColumns()) {
-    // length of char column
-    if(col->GetType() == TypeId::kTypeChar)
-      max_size += 4;
-    max_size += col->GetLength();
-  }
+  // 键按保序编码存放：每列一个空值标记字节加定长的值，非唯一索引末尾再加 RowId
+  bool unique = meta_data_->IsUnique();
+  size_t max_size = KeyManager::GetEncodedSize(key_schema_) + (unique ? 0 : KeyManager::ROW_ID_SUFFIX_SIZE);
 
   if (index_type == "bptree") {
     if (max_size <= 8)
@@ -114,5 +112,5 @@ Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const stri
   } else {
     return nullptr;
   }
-  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager);
+  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager, unique);
 }
@@ -5,7 +5,7 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
   uint32_t ofs = GetSerializedSize();
   ASSERT(ofs <= PAGE_SIZE, "Failed to serialize table info.");
   // magic num
-  MACH_WRITE_UINT32(buf, TABLE_METADATA_MAGIC_NUM);
+  MACH_WRITE_UINT32(buf, TABLE_METADATA_HEAP_MAGIC_NUM);
   //printf("magic_num: %u\n", TABLE_METADATA_MAGIC_NUM);
   buf += 4;
   // table id
@@ -19,6 +19,15 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
   // table heap root page id
   MACH_WRITE_TO(page_id_t, buf, root_page_id_);
   buf += 4;
+  // table heap summary
+  MACH_WRITE_TO(page_id_t, buf, heap_meta_.free_space_map_page_id_);
+  buf += 4;
+  MACH_WRITE_TO(page_id_t, buf, heap_meta_.last_page_id_);
+  buf += 4;
+  MACH_WRITE_UINT32(buf, heap_meta_.page_count_);
+  buf += 4;
+  MACH_WRITE_TO(uint64_t, buf, heap_meta_.free_space_);
+  buf += 8;
   // table schema
   int tmp = schema_->SerializeTo(buf);
   //printf("tmp: %d,schema_->GetSerializedSize(): %d\n", tmp, schema_->GetSerializedSize());
@@ -33,8 +42,9 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
  * TODO: Student Implement
  */
 uint32_t TableMetadata::GetSerializedSize() const {
-  return sizeof(TABLE_METADATA_MAGIC_NUM) + sizeof(table_id_t) + 4
-  + table_name_.length() + sizeof(page_id_t) + schema_->GetSerializedSize();
+  return sizeof(TABLE_METADATA_HEAP_MAGIC_NUM) + sizeof(table_id_t) + 4
+  + table_name_.length() + sizeof(page_id_t) + sizeof(page_id_t) * 2 + sizeof(uint32_t) + sizeof(uint64_t)
+  + schema_->GetSerializedSize();
 }
 
 /**
@@ -49,7 +59,8 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
   // magic num
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
-  ASSERT(magic_num == TABLE_METADATA_MAGIC_NUM, "Failed to deserialize table info.");
+  ASSERT(magic_num == TABLE_METADATA_MAGIC_NUM || magic_num == TABLE_METADATA_HEAP_MAGIC_NUM,
+         "Failed to deserialize table info.");
   // table id
   table_id_t table_id = MACH_READ_FROM(table_id_t, buf);
   buf += 4;
@@ -61,11 +72,23 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
   // table heap root page id
   page_id_t root_page_id = MACH_READ_FROM(page_id_t, buf);
   buf += 4;
+  // table heap summary, absent in metadata of older versions
+  TableHeapMeta heap_meta;
+  if (magic_num == TABLE_METADATA_HEAP_MAGIC_NUM) {
+    heap_meta.free_space_map_page_id_ = MACH_READ_FROM(page_id_t, buf);
+    buf += 4;
+    heap_meta.last_page_id_ = MACH_READ_FROM(page_id_t, buf);
+    buf += 4;
+    heap_meta.page_count_ = MACH_READ_UINT32(buf);
+    buf += 4;
+    heap_meta.free_space_ = MACH_READ_FROM(uint64_t, buf);
+    buf += 8;
+  }
   // table schema
   TableSchema *schema = nullptr;
   buf += TableSchema::DeserializeFrom(buf, schema);
   // allocate space for table metadata
-  table_meta = new TableMetadata(table_id, table_name, root_page_id, schema);
+  table_meta = new TableMetadata(table_id, table_name, root_page_id, schema, heap_meta);
   return buf - p;
 }
 
@@ -75,10 +98,15 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
  * @param heap Memory heap passed by TableInfo
  */
 TableMetadata *TableMetadata::Create(table_id_t table_id, std::string table_name, page_id_t root_page_id,
-                                     TableSchema *schema) {
+                                     TableSchema *schema, const TableHeapMeta &heap_meta) {
   // allocate space for table metadata
-  return new TableMetadata(table_id, table_name, root_page_id, schema);
+  return new TableMetadata(table_id, table_name, root_page_id, schema, heap_meta);
 }
 
-TableMetadata::TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema)
-    : table_id_(table_id), table_name_(table_name), root_page_id_(root_page_id), schema_(schema) {}
+TableMetadata::TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema,
+                             const TableHeapMeta &heap_meta)
+    : table_id_(table_id),
+      table_name_(table_name),
+      root_page_id_(root_page_id),
+      schema_(schema),
+      heap_meta_(heap_meta) {}
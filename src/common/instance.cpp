@@ -12,7 +12,8 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
   }
   // Initialize components
   disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_, DEFAULT_BUFFER_POOL_INSTANCES, ReplacerType::kLRUK);
+  bpm_->StartFlusher();
 
   // Allocate static page for db storage engine
   if (init) {
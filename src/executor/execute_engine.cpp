@@ -96,7 +96,7 @@ dberr_t ExecuteEngine::ExecutePlan(const AbstractPlanNodeRef &plan, std::vector<
     Row row{};
     while (executor->Next(&row, &rid)) {
       if (result_set != nullptr) {
-        result_set->push_back(row);
+        result_set->push_back(std::move(row));
       }
     }
   } catch (const exception &ex) {
@@ -241,6 +241,9 @@ void ExecuteEngine::ExecuteInformation(dberr_t result) {
     case DB_KEY_NOT_FOUND:
       cout << "Key not exists." << endl;
       break;
+    case DB_KEY_TOO_LONG:
+      cout << "Key longer than its index allows." << endl;
+      break;
     case DB_QUIT:
       cout << "Bye." << endl;
       break;
@@ -592,7 +595,8 @@ dberr_t ExecuteEngine::ExecuteCreateIndex(pSyntaxNode ast, ExecuteContext *conte
   auto CatalogManager = context->GetCatalog();
   auto Txn = context->GetTransaction();
   IndexInfo* IndexInfo_l;
-  auto result = CatalogManager->CreateIndex(TableName,IndexName,IndexLists,Txn,IndexInfo_l,"btree");
+  // 语法里没有 UNIQUE INDEX，CREATE INDEX 建的是允许重复键的二级索引；唯一约束由建表时的索引保证
+  auto result = CatalogManager->CreateIndex(TableName,IndexName,IndexLists,Txn,IndexInfo_l,"btree",false);
   return result;
 }
 
@@ -16,27 +16,92 @@ void InsertExecutor::Init() {
 }
 
 bool InsertExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
+    if (!batch_inserted_) {
+        InsertBatch();
+        batch_inserted_ = true;
+    }
+    // 每个插入成功的行对应一次 Next 返回 true
+    if (cursor_ < inserted_count_) {
+        cursor_++;
+        return true;
+    }
+    return false;
+}
+
+bool InsertExecutor::KeyExists(Row &insert_row) {
+    for (auto info: index_info_) {
+        if (!info->GetIndex()->IsUnique()) {
+            continue;  // 非唯一索引允许重复键
+        }
+        Row key_row;
+        insert_row.GetKeyFromRow(schema_, info->GetIndexKeySchema(), key_row);
+        std::vector<RowId> result;
+        if (!key_row.GetFields().empty() &&
+            info->GetIndex()->ScanKey(key_row, result, exec_ctx_->GetTransaction()) == DB_SUCCESS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void InsertExecutor::InsertBatch() {
+    // 取出子执行器的全部行，遇到已存在的键就整条语句失败，什么都不插入
+    std::vector<Row> rows;
     Row insert_row;
     RowId insert_rid;
-    if (child_executor_->Next(&insert_row, &insert_rid)) {
-        for (auto info: index_info_) {
-            Row key_row;
-            insert_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), key_row);
-            std::vector<RowId> result;
-            if (!key_row.GetFields().empty() &&
-                info->GetIndex()->ScanKey(key_row, result, exec_ctx_->GetTransaction()) == DB_SUCCESS) {
-                std::cout << "key already exists" << std::endl;
-                return false;
-            }
+    while (child_executor_->Next(&insert_row, &insert_rid)) {
+        if (KeyExists(insert_row)) {
+            throw std::logic_error("key already exists");
         }
-        if (table_info_->GetTableHeap()->InsertTuple(insert_row, exec_ctx_->GetTransaction())) {
-            Row key_row;
-            for (auto info: index_info_) {  // 更新索引
-                insert_row.GetKeyFromRow(schema_, info->GetIndexKeySchema(), key_row);
-                info->GetIndex()->InsertEntry(key_row, insert_row.GetRowId(), exec_ctx_->GetTransaction());
+        rows.push_back(insert_row);
+    }
+    if (rows.empty()) {
+        return;
+    }
+    auto txn = exec_ctx_->GetTransaction();
+    auto table_heap = table_info_->GetTableHeap();
+    std::string error;
+    if (!table_heap->BulkInsert(rows, txn)) {
+        error = "row too large for a page or buffer pool full";
+    }
+    // 失败时只有前面一部分行得到了 RowId
+    size_t inserted = 0;
+    while (inserted < rows.size() && rows[inserted].GetRowId().GetPageId() != INVALID_PAGE_ID) {
+        inserted++;
+    }
+    // 更新索引；某行的键在同一批中重复或过长时停下，indexed 记下该行已写入的索引数
+    size_t indexed_rows = 0;
+    size_t indexed = 0;
+    Row key_row;
+    for (; error.empty() && indexed_rows < inserted; indexed_rows++) {
+        dberr_t result = DB_SUCCESS;
+        for (indexed = 0; indexed < index_info_.size(); indexed++) {
+            auto info = index_info_[indexed];
+            rows[indexed_rows].GetKeyFromRow(schema_, info->GetIndexKeySchema(), key_row);
+            result = info->GetIndex()->InsertEntry(key_row, rows[indexed_rows].GetRowId(), txn);
+            if (result != DB_SUCCESS) {
+                break;
             }
-            return true;
         }
-  }
-  return false;
-}
\ No newline at end of file
+        if (indexed != index_info_.size()) {
+            error = result == DB_KEY_TOO_LONG ? "value too long for index " + index_info_[indexed]->GetIndexName()
+                                              : "key already exists";
+            break;
+        }
+    }
+    if (error.empty()) {
+        inserted_count_ = inserted;
+        return;
+    }
+    // 整条语句要么全部插入要么都不插入：撤销已写入的索引项和表堆中的每一行
+    for (size_t i = 0; i < inserted; i++) {
+        size_t row_indexed = i < indexed_rows ? index_info_.size() : (i == indexed_rows ? indexed : 0);
+        for (size_t j = 0; j < row_indexed; j++) {
+            rows[i].GetKeyFromRow(schema_, index_info_[j]->GetIndexKeySchema(), key_row);
+            index_info_[j]->GetIndex()->RemoveEntry(key_row, rows[i].GetRowId(), txn);
+        }
+        table_heap->MarkDelete(rows[i].GetRowId(), txn);
+        table_heap->ApplyDelete(rows[i].GetRowId(), txn);
+    }
+    throw std::logic_error(error);
+}
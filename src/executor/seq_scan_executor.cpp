@@ -40,7 +40,6 @@ void SeqScanExecutor::TupleTransfer(const Schema *table_schema, const Schema *ou
 
 void SeqScanExecutor::Init() {
   exec_ctx_->GetCatalog()->GetTable(plan_->GetTableName(), table_info_);
-  auto first_row = table_info_->GetTableHeap()->Begin(nullptr);
   iterator_ = (table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction()));
   schema_ = plan_->OutputSchema();
   is_schema_same_ = SchemaEqual(table_info_->GetSchema(), schema_);
@@ -48,22 +47,25 @@ void SeqScanExecutor::Init() {
 
 bool SeqScanExecutor::Next(Row *row, RowId *rid) {
   auto predicate = plan_->GetPredicate();
-  auto table_schema = table_info_->GetSchema();
-  while (iterator_ != table_info_->GetTableHeap()->End()) {
-    auto p_row = &(*iterator_);
-    if (predicate != nullptr) {
-      if (!predicate->Evaluate(p_row).CompareEquals(Field(kTypeInt, 1))) {
-        iterator_++;
-        continue;
-      }
+  auto end = table_info_->GetTableHeap()->End();
+  // 谓词直接在页内字节上求值，只有通过的记录才构造 Row
+  for (; iterator_ != end; ++iterator_) {
+    const TupleView &view = iterator_.GetTupleView();
+    if (!view.IsValid()) {
+      continue;
     }
-    *rid = iterator_->GetRowId();
+    if (predicate != nullptr && !predicate->Evaluate(view).CompareEquals(Field(kTypeInt, 1))) {
+      continue;
+    }
+    *rid = iterator_.GetRowId();
     if (!is_schema_same_) {
-      TupleTransfer(table_schema, schema_, p_row, row);
+      view.Project(schema_, row);
     } else {
-      *row = *p_row;
+      row->destroy();
+      view.ToRow(row);
     }
-    iterator_++;
+    row->SetRowId(*rid);
+    ++iterator_;
     return true;
   }
   return false;
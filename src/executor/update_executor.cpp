@@ -20,16 +20,23 @@ bool UpdateExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
   RowId src_rid;
   if (child_executor_->Next(&src_row, &src_rid)) {
     Row dest_row = GenerateUpdatedTuple(src_row);
+    Row src_key_row;
+    Row dest_key_row;
+    for (auto info : index_info_) {  // 先确认新值放得进每个索引，再改表堆
+      dest_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), dest_key_row);
+      if (!KeyManager::FitsKey(dest_key_row, info->GetIndexKeySchema())) {
+        throw std::logic_error("value too long for index " + info->GetIndexName());
+      }
+    }
     if (!table_info_->GetTableHeap()->UpdateTuple(dest_row, src_rid, txn_)) {
       return false;
     }
-    Row src_key_row;
-    Row dest_key_row;
     for (auto info : index_info_) {  // 更新索引
       src_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), src_key_row);
       dest_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), dest_key_row);
       info->GetIndex()->RemoveEntry(src_key_row, src_rid, txn_);
-      info->GetIndex()->InsertEntry(dest_key_row, src_rid, txn_);
+      // 行放不下原页时会被搬到别的页，要用更新后的 RowId
+      info->GetIndex()->InsertEntry(dest_key_row, dest_row.GetRowId(), txn_);
     }
     return true;
   }
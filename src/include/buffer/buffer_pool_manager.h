@@ -1,10 +1,16 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <list>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_pool_manager_instance.h"
 #include "buffer/lru_replacer.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
@@ -12,9 +18,41 @@
 
 using namespace std;
 
+/**
+ * Per-cursor read-ahead state, owned by the scan that calls BufferPoolManager::ReadAhead.
+ */
+struct ReadAheadState {
+  page_id_t last_page_id_{INVALID_PAGE_ID};        // page the cursor moved onto last time
+  page_id_t last_prefetched_id_{INVALID_PAGE_ID};  // last page read ahead so far
+  size_t ahead_{0};                                // pages read ahead that the cursor has not reached yet
+  size_t window_{0};                               // size of the last read-ahead batch, 0 if not sequential
+};
+
+/**
+ * Lists, into page_ids, up to count pages that follow page_id in the scanned object's own page order.
+ */
+using NextPagesFunc = std::function<void(page_id_t page_id, size_t count, vector<page_id_t> *page_ids)>;
+
+/**
+ * A run of contiguous pages reserved on disk by one growing table or index and handed out one by one by
+ * BufferPoolManager::NewPage(page_id, extent). Each new run is twice as long as the previous one, from
+ * DEFAULT_EXTENT_MIN_PAGES up to DEFAULT_EXTENT_MAX_PAGES.
+ */
+struct PageExtent {
+  page_id_t next_page_id_{INVALID_PAGE_ID};  // next unused page of the run
+  page_id_t end_page_id_{INVALID_PAGE_ID};   // one past the last page of the run
+  size_t run_size_{0};                       // length of the last reserved run
+};
+
+/**
+ * BufferPoolManager is split into num_instances independent BufferPoolManagerInstance partitions.
+ * A page id is always cached by instance page_id % num_instances, so concurrent requests for
+ * different pages only serialize on the latch of the instance they hash to.
+ */
 class BufferPoolManager {
  public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances = 1,
+                             ReplacerType replacer_type = ReplacerType::kLRU);
 
   ~BufferPoolManager();
 
@@ -26,12 +64,84 @@ class BufferPoolManager {
 
   Page *NewPage(page_id_t &page_id);
 
+  /**
+   * Like NewPage, but take the page from the contiguous run reserved in extent, reserving the next run when it
+   * is used up. Falls back to a single page when no extent has a long enough free run.
+   */
+  Page *NewPage(page_id_t &page_id, PageExtent *extent);
+
+  /**
+   * Reserve count pages with consecutive page ids on disk, without bringing them into the pool.
+   * @return the first page id of the run, INVALID_PAGE_ID if none is available
+   */
+  page_id_t AllocateExtent(size_t count);
+
+  /**
+   * Give the unused pages of extent back to the disk manager.
+   */
+  void ReleaseExtent(PageExtent *extent);
+
+  /**
+   * Read the pages of page_ids that are not resident into the pool as one batch of asynchronous reads,
+   * without pinning them. Stops reserving frames once an instance has nothing left to evict. Pages whose read
+   * fails are not cached, and neither is a page whose dirty victim could not be written back.
+   * @return number of pages read
+   */
+  size_t PrefetchPages(const vector<page_id_t> &page_ids);
+
+  /**
+   * Set how many reads a batch keeps in flight.
+   */
+  void SetIOQueueDepth(size_t queue_depth) { io_queue_depth_ = queue_depth; }
+
+  /**
+   * Tell the pool that a scan has moved onto page_id of an object whose pages are listed by next_pages. Once the
+   * scan is seen moving to the page that follows the previous one in that list, the pages after it are
+   * prefetched in batches, so only pages of the object itself are read. The window starts at
+   * DEFAULT_READ_AHEAD_MIN_PAGES, doubles each time the scan gets within half a window of the pages read so far,
+   * up to DEFAULT_READ_AHEAD_MAX_PAGES, and never exceeds GetReadAheadBudget(). Any other move resets it.
+   */
+  void ReadAhead(ReadAheadState *state, page_id_t page_id, const NextPagesFunc &next_pages);
+
+  /**
+   * @return how many frames read-ahead may take right now: every free frame plus a quarter of the evictable
+   *         ones, so that one scan cannot push out the whole cache in a single batch
+   */
+  size_t GetReadAheadBudget();
+
+  /**
+   * Enable or disable ReadAhead. Enabled by default.
+   */
+  void SetReadAhead(bool enable) { read_ahead_ = enable; }
+
   bool DeletePage(page_id_t page_id);
 
   bool IsPageFree(page_id_t page_id);
 
   bool CheckAllUnpinned();
 
+  /**
+   * Start the background flusher. Every interval it checks the dirty ratio of the pool; once the ratio
+   * reaches high_watermark, unpinned dirty pages are written back in page id order until it drops to
+   * low_watermark, so that foreground eviction mostly finds clean victims. The disk manager's modified
+   * allocation bitmaps are written back on every round as well.
+   */
+  void StartFlusher(chrono::milliseconds interval = chrono::milliseconds(DEFAULT_FLUSH_INTERVAL_MS),
+                    double high_watermark = DEFAULT_DIRTY_HIGH_WATERMARK,
+                    double low_watermark = DEFAULT_DIRTY_LOW_WATERMARK);
+
+  /**
+   * Stop the background flusher and wait for it to exit. No-op if it is not running.
+   */
+  void StopFlusher();
+
+  /** @return the number of dirty frames in the whole pool */
+  size_t GetDirtyCount();
+
+  size_t GetPoolSize() const { return pool_size_; }
+
+  size_t GetNumInstances() const { return instances_.size(); }
+
  private:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
@@ -43,16 +153,38 @@ class BufferPoolManager {
    */
   void DeallocatePage(page_id_t page_id);
 
-  frame_id_t TryToFindFreePage();
+  /**
+   * Body of the background flusher thread.
+   */
+  void FlusherLoop();
+
+  /**
+   * Write back unpinned dirty pages in page id order until at most target frames are dirty.
+   * @return number of pages written
+   */
+  size_t FlushDirtyPages(size_t target);
+
+  /**
+   * @return the instance responsible for page_id
+   */
+  BufferPoolManagerInstance *GetInstance(page_id_t page_id) {
+    return instances_[static_cast<uint32_t>(page_id) % instances_.size()];
+  }
 
  private:
-  size_t pool_size_;                                 // number of pages in buffer pool
-  Page *pages_;                                      // array of pages
-  DiskManager *disk_manager_;                        // pointer to the disk manager.
-  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
-  Replacer *replacer_;                               // to find an unpinned page for replacement
-  list<frame_id_t> free_list_;                       // to find a free page for replacement
-  recursive_mutex latch_;                            // to protect shared data structure
+  size_t pool_size_;                              // number of pages in buffer pool
+  DiskManager *disk_manager_;                     // pointer to the disk manager.
+  vector<BufferPoolManagerInstance *> instances_;  // partitions of the buffer pool
+  size_t io_queue_depth_{DEFAULT_IO_QUEUE_DEPTH};    // reads kept in flight by PrefetchPages
+  bool read_ahead_{true};                            // whether ReadAhead prefetches anything
+  // background flusher
+  thread flusher_;
+  mutex flusher_latch_;
+  condition_variable flusher_cv_;
+  bool flusher_running_{false};
+  chrono::milliseconds flush_interval_{DEFAULT_FLUSH_INTERVAL_MS};
+  double high_watermark_{DEFAULT_DIRTY_HIGH_WATERMARK};
+  double low_watermark_{DEFAULT_DIRTY_LOW_WATERMARK};
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
@@ -0,0 +1,177 @@
+#ifndef MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+#define MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "page/page.h"
+#include "storage/disk_manager.h"
+
+using namespace std;
+
+/**
+ * BufferPoolManagerInstance is one partition of the buffer pool. It caches the pages whose
+ * page_id % num_instances == instance_index and owns its own frames, page table, free list,
+ * replacer and latch, so threads working on different partitions never contend.
+ *
+ * Page allocation on disk is done by the owning BufferPoolManager; an instance only maps
+ * already allocated page ids onto its frames.
+ *
+ * Disk I/O never runs under latch_. A miss reserves a frame (pinned and marked I/O in progress),
+ * drops the latch, writes back the dirty victim and reads the page, then publishes the frame.
+ * Threads that want a page whose frame is still in flight sleep on that frame's condition
+ * variable only; hits on other pages proceed meanwhile.
+ */
+class BufferPoolManagerInstance {
+ public:
+  /**
+   * A frame reserved for a page that the caller reads itself, as part of a batch.
+   */
+  struct ReservedFrame {
+    page_id_t page_id_;
+    frame_id_t frame_id_;
+    page_id_t victim_page_id_;  // dirty page evicted from the frame, INVALID_PAGE_ID if none
+    char *data_;
+    bool read_failed_{false};   // set by the caller if reading the page failed
+  };
+
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, ReplacerType replacer_type = ReplacerType::kLRU);
+
+  ~BufferPoolManagerInstance();
+
+  /**
+   * Fetch the requested page, reading it from disk on a miss.
+   * @return pinned page, or nullptr if every frame is pinned
+   */
+  Page *FetchPage(page_id_t page_id);
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+  bool FlushPage(page_id_t page_id);
+
+  /**
+   * Write back page_id only if it is dirty and nobody holds a pin on it.
+   * @return true if the page was written
+   */
+  bool FlushUnpinnedPage(page_id_t page_id);
+
+  /**
+   * Write back every resident page of this instance.
+   */
+  void FlushAllPages();
+
+  /** @return the number of dirty frames in this instance */
+  size_t GetDirtyCount();
+
+  /**
+   * Append the ids of the dirty pages nobody holds a pin on to page_ids.
+   */
+  void GetUnpinnedDirtyPages(vector<page_id_t> *page_ids);
+
+  /**
+   * Bind a freshly allocated page id to a zeroed frame.
+   * @return pinned page, or nullptr if every frame is pinned
+   */
+  Page *NewPage(page_id_t page_id);
+
+  /**
+   * Reserve frames for the pages of page_ids that are not resident, so that the caller can read them in one
+   * batch. Reserved frames are pinned and marked I/O in progress, and their dirty victims are written back
+   * before returning. A victim whose write-back fails stays resident and dirty, and its frame is not reserved.
+   * Stops early once no frame can be evicted.
+   * @param[out] reserved the reserved frames, in the order of page_ids
+   */
+  void ReserveFrames(const vector<page_id_t> &page_ids, vector<ReservedFrame> *reserved);
+
+  /**
+   * Publish frames reserved by ReserveFrames after their pages have been read, and drop the reservation pins.
+   * Frames whose read failed are unmapped and freed instead, so the next FetchPage reads the page itself.
+   */
+  void PublishFrames(const vector<ReservedFrame> &reserved);
+
+  /**
+   * Drop page_id from this instance.
+   * @return false if the page is still pinned
+   */
+  bool DeletePage(page_id_t page_id);
+
+  /**
+   * @return free frames plus a quarter of the evictable frames, see BufferPoolManager::GetReadAheadBudget
+   */
+  size_t GetReadAheadBudget();
+
+  bool CheckAllUnpinned();
+
+  size_t GetPoolSize() const { return pool_size_; }
+
+ private:
+  /**
+   * Pick a frame from the free list or evict a victim, map page_id onto it, pin it and mark it
+   * I/O in progress. Must be called with latch_ held.
+   * @param victim_page_id set to the evicted page if it is dirty and still has to be written back,
+   *        INVALID_PAGE_ID otherwise
+   * @return INVALID_FRAME_ID if every frame is pinned
+   */
+  frame_id_t ReserveFrame(page_id_t page_id, page_id_t *victim_page_id);
+
+  /**
+   * Finish the I/O started by ReserveFrame and wake up the threads waiting on the frame.
+   * Must be called with latch_ held.
+   */
+  void PublishFrame(frame_id_t frame_id, page_id_t victim_page_id);
+
+  /**
+   * Drop one pin on frame_id. Once the last pin is gone, the frame goes back to the replacer, or to the free
+   * list if its read failed and it no longer holds a page. Must be called with latch_ held.
+   */
+  void UnpinFrame(frame_id_t frame_id);
+
+  /**
+   * Write frame_id back to disk. The frame stays pinned while latch_ is released for the write.
+   */
+  void FlushFrame(unique_lock<mutex> &lock, frame_id_t frame_id);
+
+  /**
+   * Set the dirty flag of page and keep num_dirty_ in sync. Must be called with latch_ held.
+   */
+  void SetDirty(Page &page, bool is_dirty) {
+    if (page.is_dirty_ != is_dirty) {
+      page.is_dirty_ = is_dirty;
+      is_dirty ? num_dirty_++ : num_dirty_--;
+    }
+  }
+
+  /**
+   * Block until no I/O is in progress on frame_id. latch_ is released while waiting.
+   */
+  void WaitForIO(unique_lock<mutex> &lock, frame_id_t frame_id);
+
+  /**
+   * Per-frame I/O state. Waiters sleep on the frame's own condition variable.
+   */
+  struct FrameIOState {
+    bool in_progress_{false};
+    condition_variable cv_;
+  };
+
+ private:
+  size_t pool_size_;                                 // number of pages in this instance
+  uint32_t num_instances_;                           // number of instances in the whole pool
+  uint32_t instance_index_;                          // index of this instance in the pool
+  Page *pages_;                                      // array of pages
+  DiskManager *disk_manager_;                        // pointer to the disk manager.
+  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
+  Replacer *replacer_;                               // to find an unpinned page for replacement
+  list<frame_id_t> free_list_;                       // to find a free page for replacement
+  FrameIOState *io_states_;                          // I/O state of each frame
+  unordered_map<page_id_t, frame_id_t> evicting_;    // dirty victims being written back, and their frame
+  size_t num_dirty_{0};                              // number of dirty frames
+  mutex latch_;                                      // to protect shared data structure
+};
+
+#endif  // MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
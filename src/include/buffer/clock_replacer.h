@@ -1,12 +1,7 @@
 #ifndef MINISQL_CLOCK_REPLACER_H
 #define MINISQL_CLOCK_REPLACER_H
 
-#include <algorithm>
-#include <list>
-#include <map>
-#include <mutex>
-#include <queue>
-#include <unordered_set>
+#include <cstdint>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -16,6 +11,9 @@ using namespace std;
 
 /**
  * CLOCKReplacer implements the clock replacement.
+ *
+ * Membership and reference bits live in flat arrays indexed by frame_id, allocated once in the
+ * constructor, so Pin and Unpin are O(1) and no operation allocates.
  */
 class CLOCKReplacer : public Replacer {
  public:
@@ -40,8 +38,10 @@ class CLOCKReplacer : public Replacer {
 
  private:
   size_t capacity;
-  list<frame_id_t> clock_list;               // replacer中可以被替换的数据页
-  map<frame_id_t, frame_id_t> clock_status;  // 数据页的存储状态
+  size_t clock_hand{0};           // 时钟指针
+  size_t clock_size{0};           // replacer中可以被替换的数据页数量
+  vector<uint8_t> in_replacer;    // 数据页是否可以被替换
+  vector<uint8_t> reference_bit;  // 数据页的访问位
 };
 
-#endif  // MINISQL_CLOCK_REPLACER_H
\ No newline at end of file
+#endif  // MINISQL_CLOCK_REPLACER_H
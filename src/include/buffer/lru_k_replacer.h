@@ -0,0 +1,74 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The backward k-distance of a frame is the time since its k-th most recent access. The victim is the
+ * frame with the largest backward k-distance; frames with fewer than k accesses have an infinite distance
+ * and are evicted first, oldest first access first. Pages touched once by a sequential scan therefore
+ * leave the pool before pages that are accessed repeatedly, such as B+ tree internal pages.
+ *
+ * An access is recorded each time a frame becomes evictable (Unpin).
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k number of accesses remembered for each frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = DEFAULT_LRU_K);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override = default;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  static constexpr size_t DEFAULT_LRU_K = 2;
+
+ private:
+  /**
+   * @return the k-th most recent access of frame_id, or its first access if it has fewer than k
+   */
+  uint64_t EvictionKey(frame_id_t frame_id) const {
+    size_t count = access_count_[frame_id];
+    return history_[frame_id * k_ + (count < k_ ? 0 : count % k_)];
+  }
+
+  /** @return the queue frame_id belongs to while it is evictable */
+  set<pair<uint64_t, frame_id_t>> &QueueOf(frame_id_t frame_id) {
+    return access_count_[frame_id] < k_ ? history_queue_ : cache_queue_;
+  }
+
+ private:
+  size_t num_pages_;
+  size_t k_;
+  uint64_t current_timestamp_{0};
+  vector<uint64_t> history_;                         // last k access timestamps of each frame, as a ring
+  vector<size_t> access_count_;                      // number of recorded accesses of each frame
+  vector<bool> evictable_;                           // whether each frame is currently in a queue
+  set<pair<uint64_t, frame_id_t>> history_queue_;    // evictable frames with less than k accesses
+  set<pair<uint64_t, frame_id_t>> cache_queue_;      // evictable frames with at least k accesses
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
@@ -5,6 +5,11 @@
 
 #include "common/config.h"
 
+/**
+ * Replacement policies a BufferPoolManager can be configured with.
+ */
+enum class ReplacerType { kLRU, kLRUK, kClock };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -14,6 +19,12 @@ class Replacer {
 
   virtual ~Replacer() = default;
 
+  /**
+   * Create a replacer of the given policy.
+   * @param num_pages the maximum number of frames the replacer will be required to store
+   */
+  static Replacer *Create(ReplacerType type, size_t num_pages);
+
   /**
    * Remove the victim frame as defined by the replacement policy.
    * @param[out] frame_id id of frame that was removed, nullptr if no victim was found
@@ -33,6 +44,12 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Forgets a frame whose page has been deleted, so that the next page placed in it starts without history.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
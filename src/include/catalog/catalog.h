@@ -82,9 +82,12 @@ class CatalogManager {
 
   dberr_t GetTables(std::vector<TableInfo *> &tables) const;
 
+  /**
+   * @param unique whether the index refuses duplicate keys; a non-unique index keeps every row of a key
+   */
   dberr_t CreateIndex(const std::string &table_name, const std::string &index_name,
                       const std::vector<std::string> &index_keys, Txn *txn, IndexInfo *&index_info,
-                      const string &index_type);
+                      const string &index_type, bool unique = true);
 
   dberr_t GetIndex(const std::string &table_name, const std::string &index_name, IndexInfo *&index_info) const;
 
@@ -94,11 +97,22 @@ class CatalogManager {
 
   dberr_t DropIndex(const std::string &table_name, const std::string &index_name);
 
+  /**
+   * Run TableHeap::Vacuum on a table and repoint its index entries at the tuples the pass moved.
+   */
+  dberr_t VacuumTable(const std::string &table_name, VacuumStats *stats, Txn *txn);
+
  private:
   dberr_t DropTable(table_id_t table_id);
 
   dberr_t FlushCatalogMetaPage() const;
 
+  /**
+   * Write the current heap summary of every table back to its table meta page, so that the next open needs no
+   * access to the heap itself.
+   */
+  dberr_t FlushTableHeapMeta();
+
   dberr_t LoadTable(const table_id_t table_id, const page_id_t page_id);
 
   dberr_t LoadIndex(const index_id_t index_id, const page_id_t page_id);
@@ -15,7 +15,7 @@ class IndexMetadata {
 
  public:
   static IndexMetadata *Create(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                               const std::vector<uint32_t> &key_map);
+                               const std::vector<uint32_t> &key_map, bool unique = true);
 
   uint32_t SerializeTo(char *buf) const;
 
@@ -33,11 +33,13 @@ class IndexMetadata {
 
   inline index_id_t GetIndexId() const { return index_id_; }
 
+  inline bool IsUnique() const { return unique_; }
+
  private:
   IndexMetadata() = delete;
 
   explicit IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                         const std::vector<uint32_t> &key_map);
+                         const std::vector<uint32_t> &key_map, bool unique);
 
  private:
   static constexpr uint32_t INDEX_METADATA_MAGIC_NUM = 344528;
@@ -45,6 +47,7 @@ class IndexMetadata {
   std::string index_name_;
   table_id_t table_id_;
   std::vector<uint32_t> key_map_; /** The mapping of index key to tuple key */
+  bool unique_;                   /** Whether the index refuses duplicate keys */
 };
 
 /**
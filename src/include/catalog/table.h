@@ -23,7 +23,7 @@ class TableMetadata {
    * will create new table schema and owned by mem heap
    */
   static TableMetadata *Create(table_id_t table_id, std::string table_name, page_id_t root_page_id,
-                               TableSchema *schema);
+                               TableSchema *schema, const TableHeapMeta &heap_meta = TableHeapMeta());
 
   inline table_id_t GetTableId() const { return table_id_; }
 
@@ -33,17 +33,29 @@ class TableMetadata {
 
   inline Schema *GetSchema() const { return schema_; }
 
+  inline const TableHeapMeta &GetHeapMeta() const { return heap_meta_; }
+
+  /**
+   * Replace the stored heap summary, the caller serializes the metadata again afterwards.
+   */
+  inline void SetHeapMeta(const TableHeapMeta &heap_meta) { heap_meta_ = heap_meta; }
+
  private:
   TableMetadata() = delete;
 
-  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema);
+  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema,
+                const TableHeapMeta &heap_meta);
 
  private:
+  // metadata written without the heap summary, before it was stored; such tables rebuild it when first modified
   static constexpr uint32_t TABLE_METADATA_MAGIC_NUM = 344528;
+  // metadata with the heap summary between the root page id and the schema
+  static constexpr uint32_t TABLE_METADATA_HEAP_MAGIC_NUM = 344529;
   table_id_t table_id_;
   std::string table_name_;
   page_id_t root_page_id_;
   Schema *schema_;
+  TableHeapMeta heap_meta_;
 };
 
 /**
@@ -73,6 +85,8 @@ class TableInfo {
 
   inline page_id_t GetRootPageId() const { return table_meta_->root_page_id_; }
 
+  inline TableMetadata *GetTableMeta() const { return table_meta_; }
+
  private:
   explicit TableInfo(){};
 
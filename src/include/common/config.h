@@ -15,6 +15,16 @@ static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index
 
 static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
 static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 8;  // default number of buffer pool partitions
+static constexpr int DEFAULT_IO_QUEUE_DEPTH = 32;         // reads/writes kept in flight by batched I/O
+static constexpr int DEFAULT_READ_AHEAD_MIN_PAGES = 4;   // first read-ahead window of a sequential scan
+static constexpr int DEFAULT_READ_AHEAD_MAX_PAGES = 64;  // largest read-ahead window of a sequential scan
+static constexpr int DEFAULT_EXTENT_MIN_PAGES = 8;      // first contiguous run reserved by a growing table or index
+static constexpr int DEFAULT_EXTENT_MAX_PAGES = 64;     // largest contiguous run reserved by a growing table or index
+static constexpr int DEFAULT_FLUSH_INTERVAL_MS = 50;      // how often the background flusher wakes up
+static constexpr double DEFAULT_DIRTY_HIGH_WATERMARK = 0.2;  // dirty ratio at which the flusher starts writing
+static constexpr double DEFAULT_DIRTY_LOW_WATERMARK = 0.05;  // dirty ratio at which the flusher stops writing
+static constexpr double DEFAULT_INDEX_FILL_FACTOR = 0.9;      // how full a bulk loaded index packs its pages
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
 static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
@@ -56,6 +56,19 @@ class ReaderWriterLatch {
     reader_count_++;
   }
 
+  /**
+   * Acquire a read latch only if that needs no waiting.
+   * @return whether the latch was acquired
+   */
+  bool TryRLock() {
+    std::lock_guard<mutex_t> guard(mutex_);
+    if (writer_entered_ || reader_count_ == MAX_READERS) {
+      return false;
+    }
+    reader_count_++;
+    return true;
+  }
+
   /**
    * Release a read latch.
    */
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "executor/execute_context.h"
@@ -39,12 +40,10 @@ class IndexScanExecutor : public AbstractExecutor {
   void TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row, Row *output_row);
 
  private:
-  vector<RowId> IndexScan(AbstractExpressionRef predicate);
-
   /** The sequential scan plan node to be executed */
   const IndexScanPlanNode *plan_;
   TableInfo *table_info_{};
-  vector<RowId> result_;
-  size_t cursor_ = 0;
+  /** Walks the index range lazily, one row per Next */
+  std::unique_ptr<IndexCursor> cursor_;
   bool is_schema_same_;
 };
\ No newline at end of file
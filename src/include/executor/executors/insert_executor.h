@@ -12,7 +12,9 @@
 /**
  * InsertExecutor executes an insert on a table.
  *
- * Inserted values are always pulled from a child executor.
+ * Inserted values are always pulled from a child executor. All rows of the statement are pulled at once and
+ * appended to the table heap with TableHeap::BulkInsert, so a multi-row VALUES list pays the per-row page
+ * access only once per page.
  */
 class InsertExecutor : public AbstractExecutor {
  public:
@@ -41,6 +43,17 @@ class InsertExecutor : public AbstractExecutor {
   /** @return The output schema for the insert */
   const Schema *GetOutputSchema() const override { return plan_->OutputSchema(); }
 
+ private:
+  /** @return true if the key of insert_row already exists in one of the indexes of the table */
+  bool KeyExists(Row &insert_row);
+
+  /**
+   * Insert every row of the child executor, or none of them. Sets inserted_count_ to the number of rows inserted.
+   * @throws std::logic_error, after undoing every row of the batch in the table heap and the indexes, if a row
+   *         cannot be inserted: its key already exists or is too long for an index, or the table heap refused it
+   */
+  void InsertBatch();
+
  private:
   /** The insert plan node to be executed*/
   const InsertPlanNode *plan_;
@@ -48,6 +61,9 @@ class InsertExecutor : public AbstractExecutor {
   TableInfo *table_info_{};
   const Schema *schema_{};
   std::vector<IndexInfo *> index_info_;
+  bool batch_inserted_{false};
+  size_t inserted_count_{0};
+  size_t cursor_{0};
 };
 
 #endif  // MINISQL_INSERT_EXECUTOR_H
@@ -8,7 +8,8 @@
 #include "planner/expressions/abstract_expression.h"
 
 /**
- * IndexScanPlanNode identifies a table that should be scanned with an optional predicate.
+ * IndexScanPlanNode reads the rows of a table whose keys in one index lie between a start and a stop key.
+ * Either key may bind only the leading columns of the index (see Index::ScanRange).
  */
 class IndexScanPlanNode : public AbstractPlanNode {
  public:
@@ -16,12 +17,19 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * Creates a new index scan plan node.
    * @param output the output format of this scan plan node
    * @param table_name The identifier of table to be scanned
+   * @param index The index to read the range from
+   * @param need_filter Whether rows in the range must still be checked against filter_predicate
    */
-  IndexScanPlanNode(const Schema *output, std::string table_name, std::vector<IndexInfo *> indexes, bool need_filter,
+  IndexScanPlanNode(const Schema *output, std::string table_name, IndexInfo *index, Row start_key,
+                    bool start_inclusive, Row stop_key, bool stop_inclusive, bool need_filter,
                     AbstractExpressionRef filter_predicate = nullptr)
       : AbstractPlanNode(output, {}),
         table_name_(std::move(table_name)),
-        indexes_(std::move(indexes)),
+        index_(index),
+        start_key_(std::move(start_key)),
+        start_inclusive_(start_inclusive),
+        stop_key_(std::move(stop_key)),
+        stop_inclusive_(stop_inclusive),
         need_filter_(need_filter),
         filter_predicate_(std::move(filter_predicate)) {}
 
@@ -36,10 +44,16 @@ class IndexScanPlanNode : public AbstractPlanNode {
   /** The table name */
   std::string table_name_;
 
-  /** The indexes*/
-  std::vector<IndexInfo *> indexes_;
+  /** The index */
+  IndexInfo *index_;
 
-  /** Whether there are indexes on all columns in the predicate*/
+  /** The range of keys to read, a bound without fields is open */
+  Row start_key_;
+  bool start_inclusive_;
+  Row stop_key_;
+  bool stop_inclusive_;
+
+  /** Whether the range covers only part of the predicate */
   bool need_filter_ = true;
 
   /** The predicate to filter in IndexScan.*/
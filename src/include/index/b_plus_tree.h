@@ -1,10 +1,15 @@
 #ifndef MINISQL_B_PLUS_TREE_H
 #define MINISQL_B_PLUS_TREE_H
 
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/txn.h"
 #include "index/index_iterator.h"
 #include "page/b_plus_tree_internal_page.h"
@@ -16,10 +21,17 @@
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys in the tree are unique; a non-unique BPlusTreeIndex makes them so by appending the RowId
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Concurrency uses latch crabbing on the page latches. root_latch_ guards root_page_id_: lookups and
+ * optimistic writes hold it shared until they latch the root page, and only the pessimistic path takes it
+ * exclusive. Lookups read-latch their way down, releasing the parent once the child is latched. Inserts and
+ * removes first try the optimistic path, which read-latches the internal pages and write-latches only the leaf;
+ * if the leaf would split or underflow they start over on the pessimistic path, which write-latches the whole
+ * path and releases every ancestor as soon as it reaches a node that the operation cannot split or merge.
  */
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage;
@@ -29,6 +41,9 @@ class BPlusTree {
   explicit BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &comparator,
                      int leaf_max_size = UNDEFINED_SIZE, int internal_max_size = UNDEFINED_SIZE);
 
+  // Give the pages reserved for future nodes back to the disk manager.
+  ~BPlusTree();
+
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
 
@@ -41,13 +56,27 @@ class BPlusTree {
   // return the value associated with a given key
   bool GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction = nullptr);
 
+  // Build an empty tree bottom-up from entries sorted by key, packing pages to fill_factor.
+  bool BulkLoad(const std::vector<std::pair<GenericKey *, RowId>> &entries, double fill_factor,
+                Txn *transaction = nullptr);
+
+  /**
+   * Visit the entries of one leaf under its read latch, from the first key greater than from (not less than
+   * from when inclusive) to the end of that leaf, until visit returns false. Nothing stays latched or pinned
+   * afterwards, so a scan that resumes from the last key it was shown sees every key once whatever writers do
+   * in between.
+   * @return false if the tree has no key past from
+   */
+  bool ScanLeaf(const GenericKey *from, bool inclusive,
+                const std::function<bool(const GenericKey *key, RowId value)> &visit);
+
   IndexIterator Begin();
 
   IndexIterator Begin(const GenericKey *key);
 
   IndexIterator End();
 
-  // expose for test purpose
+  // expose for test purpose; the returned leaf is pinned but not latched
   Page *FindLeafPage(const GenericKey *key, page_id_t page_id = INVALID_PAGE_ID, bool leftMost = false);
 
   // used to check whether all pages are unpinned
@@ -68,33 +97,72 @@ class BPlusTree {
   }
 
  private:
-  void StartNewTree(GenericKey *key, const RowId &value);
+  enum class Operation { kInsert, kRemove };
+
+  // 悲观写操作沿路径持有的写锁，以及操作结束后要删除的页
+  struct WriteSet {
+    bool root_locked_{false};
+    std::deque<Page *> pages_;  // 自上而下，都已 pin 住并加了写锁
+    std::vector<page_id_t> deleted_pages_;
+  };
+
+  // Latch the root page and crab down to the leaf with read latches. The leaf is returned pinned and
+  // read-latched, or write-latched if write_leaf is set; nullptr if the tree is empty.
+  Page *CrabToLeaf(const GenericKey *key, bool leftMost, bool write_leaf);
+
+  // Crab down to the leaf with write latches, keeping in write_set the pages that op may still change.
+  // The caller holds root_latch_ exclusively and the tree is not empty.
+  void CrabToLeafForWrite(const GenericKey *key, Operation op, WriteSet &write_set);
+
+  // Whether op on node cannot split it or make it underflow, so its ancestors can be released.
+  static bool IsSafe(BPlusTreePage *node, Operation op);
 
-  bool InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transaction = nullptr);
+  // Unlatch and unpin every page in write_set but the last one, and release root_latch_.
+  void ReleaseAncestors(WriteSet &write_set);
 
-  void InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction = nullptr);
+  // Unlatch and unpin all of write_set, release root_latch_ and delete the pages the operation emptied.
+  void ReleaseWriteSet(WriteSet &write_set);
 
-  LeafPage *Split(LeafPage *node, Txn *transaction);
+  bool InsertPessimistic(GenericKey *key, const RowId &value);
 
-  InternalPage *Split(InternalPage *node, Txn *transaction);
+  void RemovePessimistic(const GenericKey *key);
+
+  // NewPage from extent_, which concurrent splits share.
+  Page *NewTreePage(page_id_t &page_id);
+
+  // Delete pages no longer in the tree, along with earlier ones that were still pinned; keep the ones still
+  // pinned for the next call.
+  void DeletePages(const std::vector<page_id_t> &page_ids);
+
+  void StartNewTree(GenericKey *key, const RowId &value);
+
+  void InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node);
+
+  LeafPage *Split(LeafPage *node);
+
+  InternalPage *Split(InternalPage *node);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *&node, Txn *transaction = nullptr);
+  void CoalesceOrRedistribute(N *node, WriteSet &write_set);
 
-  bool Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
-                Txn *transaction = nullptr);
+  void Coalesce(InternalPage *neighbor_node, InternalPage *node, InternalPage *parent, int index,
+                WriteSet &write_set);
 
-  bool Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index,
-                Txn *transaction = nullptr);
+  void Coalesce(LeafPage *neighbor_node, LeafPage *node, InternalPage *parent, int index, WriteSet &write_set);
 
-  void Redistribute(LeafPage *neighbor_node, LeafPage *node, int index);
+  void Redistribute(LeafPage *neighbor_node, LeafPage *node, InternalPage *parent, int index);
 
-  void Redistribute(InternalPage *neighbor_node, InternalPage *node, int index);
+  void Redistribute(InternalPage *neighbor_node, InternalPage *node, InternalPage *parent, int index);
 
-  bool AdjustRoot(BPlusTreePage *node);
+  void AdjustRoot(BPlusTreePage *node, WriteSet &write_set);
 
   void UpdateRootPageId(int insert_record = 0);
 
+  // Number of entries per page when count entries are spread over as few pages of at most capacity entries
+  // filled to fill_factor as possible, but with more than min_size entries per page when the capacity allows
+  // and never fewer, unless they all fit in one; the sizes differ by at most one.
+  static std::vector<int> PackPages(int count, int capacity, int min_size, double fill_factor);
+
   /* Debug Routines for FREE!! */
   void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out, Schema *schema) const;
 
@@ -107,6 +175,10 @@ class BPlusTree {
   KeyManager processor_;
   int leaf_max_size_;
   int internal_max_size_;
+  PageExtent extent_;           // contiguous pages reserved for new nodes
+  std::vector<page_id_t> pending_deletes_;  // 合并掉时仍被 pin 住、还没删成的页
+  std::mutex extent_latch_;     // 保护 extent_ 和 pending_deletes_
+  ReaderWriterLatch root_latch_;  // 保护 root_page_id_
 };
 
 #endif  // MINISQL_B_PLUS_TREE_H
@@ -6,8 +6,15 @@
 #include "index/index.h"
 
 class BPlusTreeIndex : public Index {
+  friend class BPlusTreeIndexCursor;
+
  public:
-  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager);
+  /**
+   * @param key_size size of the tree's keys, which for a non-unique index includes the RowId suffix
+   * (see KeyManager)
+   */
+  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager,
+                 bool unique = true);
 
   dberr_t InsertEntry(const Row &key, RowId row_id, Txn *txn) override;
 
@@ -15,8 +22,18 @@ class BPlusTreeIndex : public Index {
 
   dberr_t ScanKey(const Row &key, std::vector<RowId> &result, Txn *txn, string compare_operator = "=") override;
 
+  std::unique_ptr<IndexCursor> OpenCursor(const Row &start, bool start_inclusive, const Row &stop,
+                                          bool stop_inclusive, Txn *txn) override;
+
   dberr_t Destroy() override;
 
+  /**
+   * Encode every key, sort them and build the tree bottom-up. In a unique index, of several entries with the
+   * same key only the first one produced is kept, as inserting them one by one would do.
+   */
+  dberr_t BulkLoad(const std::function<bool(Row &key, RowId &row_id)> &next, Txn *txn,
+                   double fill_factor = DEFAULT_INDEX_FILL_FACTOR) override;
+
   IndexIterator GetBeginIterator();
 
   IndexIterator GetBeginIterator(GenericKey *key);
@@ -24,10 +41,53 @@ class BPlusTreeIndex : public Index {
   IndexIterator GetEndIterator();
 
  protected:
+  /**
+   * Encode key into index_key; for a non-unique index also append row_id.
+   * @return false if a CHAR value of key is longer than its column, see KeyManager
+   */
+  bool EncodeKey(GenericKey *index_key, const Row &key, RowId row_id);
+
   // comparator for key
   KeyManager processor_;
   // container
   BPlusTree container_;
 };
 
+/**
+ * BPlusTreeIndexCursor starts at the first key of its range and follows the leaf chain until it passes the stop
+ * key. It copies the row ids of one leaf at a time under the leaf's read latch and resumes after the last key it
+ * read, so it holds no latch or pin between calls and writers may change the tree while it is open.
+ */
+class BPlusTreeIndexCursor : public IndexCursor {
+ public:
+  BPlusTreeIndexCursor(BPlusTreeIndex *index, const Row &start, bool start_inclusive, const Row &stop,
+                       bool stop_inclusive);
+
+  ~BPlusTreeIndexCursor() override;
+
+  bool Next(RowId *row_id) override;
+
+ private:
+  static GenericKey *EncodeBound(BPlusTreeIndex *index, const Row &bound);
+
+  // ScanLeaf 的回调：检查边界并把行号放进 buffer_，返回是否继续读这个叶子
+  bool Visit(const GenericKey *key, RowId row_id);
+
+  const KeyManager &processor_;
+  BPlusTree &container_;
+  GenericKey *start_key_;
+  GenericKey *stop_key_;
+  uint32_t start_size_;     // start 各列编码后的字节数，0 表示没有下界
+  uint32_t stop_size_;      // stop 各列编码后的字节数，0 表示没有上界
+  uint32_t bound_columns_;  // 两个边界里给出的列数，这些列为 NULL 的键不返回
+  bool start_inclusive_;
+  bool stop_inclusive_;
+  bool single_;  // 唯一索引上的完整键等值查找，最多一行
+  bool done_;
+  bool started_{false};        // last_key_ 是否有效
+  GenericKey *last_key_;       // 最后读到的键，下次从它之后继续
+  std::vector<RowId> buffer_;  // 从当前叶子读出、还没返回的行
+  size_t next_{0};
+};
+
 #endif  // MINISQL_B_PLUS_TREE_INDEX_H
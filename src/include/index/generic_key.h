@@ -1,7 +1,9 @@
 #ifndef MINISQL_GENERIC_KEY_H
 #define MINISQL_GENERIC_KEY_H
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 #include "record/field.h"
 #include "record/row.h"
@@ -11,64 +13,233 @@ class GenericKey {
   char data[0];  //generickey中的data已经是序列化之后的char* 了 
 };
 
+/**
+ * KeyManager encodes index keys so that their byte order is their key order, and CompareKeys is a single memcmp.
+ *
+ * Every column of the key schema takes a fixed number of bytes, so a key has no header and columns sit at fixed
+ * offsets:
+ *   - a null indicator byte, 0x00 for NULL and 0x01 otherwise, so NULL sorts before every value;
+ *   - INT: the value with its sign bit flipped, big-endian (4 bytes);
+ *   - FLOAT: the IEEE bits with the sign bit flipped for positives and all bits flipped for negatives,
+ *     big-endian (4 bytes);
+ *   - CHAR(n): the data zero-padded to n bytes, then its length big-endian (n + 4 bytes). Padding compares
+ *     below every byte, and the length then orders a string after its prefixes, as CompareStrings does.
+ * The value bytes of a NULL column are zero, so all NULLs of a column are equal.
+ *
+ * Keys of a non-unique index end with the RowId of their row (page id with its sign bit flipped, then slot
+ * number, both big-endian), which keeps every entry of the tree distinct and orders equal keys by RowId.
+ * SerializeFromKey leaves the RowId zero, below every real RowId, so a key fresh from SerializeFromKey is the
+ * lower bound of its duplicates.
+ *
+ * SerializeFromKey also takes a row with only the leading columns of the key. The columns it leaves out stay
+ * zero, i.e. NULL, so the result is the smallest key starting with those columns; ComparePrefix with
+ * GetPrefixSize of that many columns compares a key with it on those columns only.
+ *
+ * A CHAR value longer than its column (see Row) keeps its first n bytes and its real length. That key sorts
+ * right after every n-byte key it starts with and equals none of them, which is where the value falls among
+ * the keys that fit, so it still works as a scan bound; SerializeFromKey returns false so that it is not stored.
+ */
 class KeyManager {
  public: /**/
   [[nodiscard]] inline GenericKey *InitKey() const {
     return (GenericKey *)malloc(key_size_);  // remember delete
   }
 
-  inline void SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const {
+  /**
+   * @return number of bytes a key of key_schema takes once encoded
+   */
+  static uint32_t GetEncodedSize(const Schema *key_schema) {
+    uint32_t size = 0;
+    for (auto column : key_schema->GetColumns()) {
+      size += 1 + GetValueSize(column);
+    }
+    return size;
+  }
+
+  /**
+   * @return number of bytes the first column_count columns of a key take once encoded
+   */
+  inline uint32_t GetPrefixSize(uint32_t column_count) const {
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < column_count; i++) {
+      size += 1 + GetValueSize(key_schema_->GetColumn(i));
+    }
+    return size;
+  }
+
+  /**
+   * @return whether every CHAR value of key fits its column, i.e. whether SerializeFromKey gives a storable key
+   */
+  static bool FitsKey(const Row &key, const Schema *schema) {
+    for (uint32_t i = 0; i < key.GetFieldCount(); i++) {
+      const Column *column = schema->GetColumn(i);
+      const Field *field = key.GetField(i);
+      if (column->GetType() == TypeId::kTypeChar && !field->IsNull() && field->GetLength() > column->GetLength()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @return false if a CHAR value is longer than its column, so the key is only good as a scan bound
+   */
+  inline bool SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const {
+    ASSERT(key.GetFieldCount() <= schema->GetColumnCount(), "field nums not match.");
+    ASSERT(encoded_size_ <= (uint32_t)key_size_, "Index key size exceed max key size.");
     // initialize to 0
-    [[maybe_unused]] uint32_t size = key.GetSerializedSize(schema);
-    ASSERT(key.GetFieldCount() == schema->GetColumnCount(), "field nums not match.");
-    ASSERT(size <= (uint32_t)key_size_, "Index key size exceed max key size.");
     memset(key_buf->data, 0, key_size_);
-    key.SerializeTo(key_buf->data, schema);
+    auto *buf = reinterpret_cast<uint8_t *>(key_buf->data);
+    bool fits = true;
+    for (uint32_t i = 0; i < key.GetFieldCount(); i++) {
+      const Column *column = schema->GetColumn(i);
+      const Field *field = key.GetField(i);
+      uint32_t value_size = GetValueSize(column);
+      if (field->IsNull()) {
+        buf += 1 + value_size;
+        continue;
+      }
+      *buf++ = 1;
+      switch (column->GetType()) {
+        case TypeId::kTypeInt: {
+          int32_t v;
+          field->SerializeTo(reinterpret_cast<char *>(&v));
+          WriteBigEndian(buf, static_cast<uint32_t>(v) ^ 0x80000000u);
+          break;
+        }
+        case TypeId::kTypeFloat: {
+          float_t f;
+          field->SerializeTo(reinterpret_cast<char *>(&f));
+          if (f == 0) {
+            f = 0;  // -0.0 与 0.0 相等，编码也要相同
+          }
+          uint32_t bits;
+          memcpy(&bits, &f, sizeof(bits));
+          WriteBigEndian(buf, (bits & 0x80000000u) ? ~bits : bits ^ 0x80000000u);
+          break;
+        }
+        case TypeId::kTypeChar: {
+          uint32_t len = field->GetLength();
+          // 超长的值只存前 n 个字节，长度仍写真实长度，排在以这 n 个字节开头的键之后
+          fits = fits && len <= column->GetLength();
+          memcpy(buf, field->GetData(), std::min(len, column->GetLength()));
+          WriteBigEndian(buf + column->GetLength(), len);
+          break;
+        }
+        default:
+          ASSERT(false, "Unsupported key type.");
+      }
+      buf += value_size;
+    }
+    return fits;
   }
 
-  inline void DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const {
-    [[maybe_unused]] uint32_t ofs = key.DeserializeFrom(const_cast<char *>(key_buf->data), schema);
-    ASSERT(ofs <= (uint32_t)key_size_, "Index key size exceed max key size.");
+  /**
+   * Write row_id into the RowId suffix of key_buf. Only for keys of a non-unique index.
+   */
+  inline void SetRowId(GenericKey *key_buf, RowId row_id) const {
+    ASSERT(with_row_id_, "Key has no RowId suffix.");
+    auto *buf = reinterpret_cast<uint8_t *>(key_buf->data) + prefix_size_;
+    WriteBigEndian(buf, static_cast<uint32_t>(row_id.GetPageId()) ^ 0x80000000u);
+    WriteBigEndian(buf + sizeof(uint32_t), row_id.GetSlotNum());
   }
 
-  // compare
-  [[nodiscard]] inline int CompareKeys(const GenericKey *lhs, const GenericKey *rhs) const {
-    //    ASSERT(malloc_usable_size((void *)&lhs) == malloc_usable_size((void *)&rhs), "key size not match.");
-    uint32_t column_count = key_schema_->GetColumnCount();
-    Row lhs_key(INVALID_ROWID);
-    Row rhs_key(INVALID_ROWID);
-    DeserializeToKey(lhs, lhs_key, key_schema_);
-    DeserializeToKey(rhs, rhs_key, key_schema_);
-
+  /**
+   * @return whether any of the first column_count columns of key_buf is NULL
+   */
+  inline bool HasNull(const GenericKey *key_buf, uint32_t column_count) const {
+    auto *buf = reinterpret_cast<const uint8_t *>(key_buf->data);
     for (uint32_t i = 0; i < column_count; i++) {
-      Field *lhs_value = lhs_key.GetField(i);
-      Field *rhs_value = rhs_key.GetField(i);
-
-      if (lhs_value->CompareLessThan(*rhs_value) == CmpBool::kTrue) {
-        return -1;
+      if (*buf == 0) {
+        return true;
       }
+      buf += 1 + GetValueSize(key_schema_->GetColumn(i));
+    }
+    return false;
+  }
 
-      if (lhs_value->CompareGreaterThan(*rhs_value) == CmpBool::kTrue) {
-        return 1;
+  inline void DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const {
+    std::vector<Field> fields;
+    fields.reserve(schema->GetColumnCount());
+    auto *buf = reinterpret_cast<const uint8_t *>(key_buf->data);
+    for (auto column : schema->GetColumns()) {
+      bool is_null = (*buf++ == 0);
+      if (is_null) {
+        fields.emplace_back(column->GetType());
+      } else if (column->GetType() == TypeId::kTypeInt) {
+        fields.emplace_back(TypeId::kTypeInt, static_cast<int32_t>(ReadBigEndian(buf) ^ 0x80000000u));
+      } else if (column->GetType() == TypeId::kTypeFloat) {
+        uint32_t bits = ReadBigEndian(buf);
+        bits = (bits & 0x80000000u) ? bits ^ 0x80000000u : ~bits;
+        float_t f;
+        memcpy(&f, &bits, sizeof(f));
+        fields.emplace_back(TypeId::kTypeFloat, f);
+      } else {
+        uint32_t len = ReadBigEndian(buf + column->GetLength());
+        fields.emplace_back(TypeId::kTypeChar, reinterpret_cast<char *>(const_cast<uint8_t *>(buf)), len, true);
       }
+      buf += GetValueSize(column);
     }
-    // equals
-    return 0;
+    RowId rid = key.GetRowId();
+    key = Row(fields);
+    key.SetRowId(rid);
+  }
+
+  // compare
+  [[nodiscard]] inline int CompareKeys(const GenericKey *lhs, const GenericKey *rhs) const {
+    return memcmp(lhs->data, rhs->data, encoded_size_);
+  }
+
+  // compare the first prefix_size bytes only, see GetPrefixSize
+  [[nodiscard]] inline int ComparePrefix(const GenericKey *lhs, const GenericKey *rhs, uint32_t prefix_size) const {
+    return memcmp(lhs->data, rhs->data, prefix_size);
   }
 
   inline int GetKeySize() const { return key_size_; }
 
+  inline bool HasRowId() const { return with_row_id_; }
+
   KeyManager(const KeyManager &other) {
     this->key_schema_ = other.key_schema_;
     this->key_size_ = other.key_size_;
+    this->prefix_size_ = other.prefix_size_;
+    this->encoded_size_ = other.encoded_size_;
+    this->with_row_id_ = other.with_row_id_;
   }
 
   // constructor
-  KeyManager(Schema *key_schema, size_t key_size) : key_size_(key_size), key_schema_(key_schema) {}
+  KeyManager(Schema *key_schema, size_t key_size, bool with_row_id = false)
+      : key_size_(key_size),
+        key_schema_(key_schema),
+        prefix_size_(GetEncodedSize(key_schema)),
+        encoded_size_(prefix_size_ + (with_row_id ? ROW_ID_SUFFIX_SIZE : 0)),
+        with_row_id_(with_row_id) {}
+
+  static constexpr uint32_t ROW_ID_SUFFIX_SIZE = 2 * sizeof(uint32_t);  // 非唯一索引键末尾的 RowId
 
  private:
+  // 一列去掉空值标记后的字节数
+  static uint32_t GetValueSize(const Column *column) {
+    return column->GetType() == TypeId::kTypeChar ? column->GetLength() + sizeof(uint32_t) : sizeof(uint32_t);
+  }
+
+  static void WriteBigEndian(uint8_t *buf, uint32_t v) {
+    buf[0] = static_cast<uint8_t>(v >> 24);
+    buf[1] = static_cast<uint8_t>(v >> 16);
+    buf[2] = static_cast<uint8_t>(v >> 8);
+    buf[3] = static_cast<uint8_t>(v);
+  }
+
+  static uint32_t ReadBigEndian(const uint8_t *buf) {
+    return (static_cast<uint32_t>(buf[0]) << 24) | (static_cast<uint32_t>(buf[1]) << 16) |
+           (static_cast<uint32_t>(buf[2]) << 8) | static_cast<uint32_t>(buf[3]);
+  }
+
   int key_size_;
   Schema *key_schema_;
+  uint32_t prefix_size_;   // 各列编码后的字节数
+  uint32_t encoded_size_;  // 编码后键的实际字节数，其后到 key_size_ 为止都是 0
+  bool with_row_id_;       // 键末尾是否带 RowId（非唯一索引）
 };
 
 #endif  // MINISQL_GENERIC_KEY_H
@@ -1,15 +1,31 @@
 #ifndef MINISQL_INDEX_H
 #define MINISQL_INDEX_H
 
+#include <functional>
 #include <memory>
 
 #include "common/dberr.h"
 #include "concurrency/txn.h"
 #include "record/row.h"
 
+/**
+ * IndexCursor hands out the rows of an index range one at a time, in key order, reading the index as it goes.
+ */
+class IndexCursor {
+ public:
+  virtual ~IndexCursor() {}
+
+  /**
+   * @param[out] row_id the next row in the range
+   * @return false once the range is exhausted
+   */
+  virtual bool Next(RowId *row_id) = 0;
+};
+
 class Index {
  public:
-  explicit Index(index_id_t index_id, IndexSchema *key_schema) : index_id_(index_id), key_schema_(key_schema) {}
+  explicit Index(index_id_t index_id, IndexSchema *key_schema, bool unique = true)
+      : index_id_(index_id), key_schema_(key_schema), unique_(unique) {}
 
   virtual ~Index() {}
 
@@ -19,11 +35,59 @@ class Index {
 
   virtual dberr_t ScanKey(const Row &key, std::vector<RowId> &result, Txn *txn, string compare_operator = "=") = 0;
 
+  /**
+   * Open a cursor over the rows whose key lies between start and stop. A bound may give only the leading
+   * columns of the key, and a key is compared with it on those columns only; a bound with no fields leaves
+   * that side open. Keys with NULL in a bound column never match.
+   */
+  virtual std::unique_ptr<IndexCursor> OpenCursor(const Row &start, bool start_inclusive, const Row &stop,
+                                                  bool stop_inclusive, Txn *txn) = 0;
+
+  /**
+   * Append every row of the range OpenCursor would walk to result.
+   */
+  dberr_t ScanRange(const Row &start, bool start_inclusive, const Row &stop, bool stop_inclusive,
+                    std::vector<RowId> &result, Txn *txn) {
+    auto cursor = OpenCursor(start, start_inclusive, stop, stop_inclusive, txn);
+    size_t found = result.size();
+    RowId row_id;
+    while (cursor->Next(&row_id)) {
+      result.push_back(row_id);
+    }
+    return result.size() > found ? DB_SUCCESS : DB_KEY_NOT_FOUND;
+  }
+
   virtual dberr_t Destroy() = 0;
 
+  /**
+   * A unique index refuses a second entry for a key. A non-unique one keeps every (key, row id) pair, and
+   * ScanKey returns all rows of a key.
+   */
+  inline bool IsUnique() const { return unique_; }
+
+  /**
+   * Fill an empty index with the entries produced by next, which returns false once they run out.
+   * Indexes that can build themselves in one pass override this; the default inserts the entries one by one.
+   * @param fill_factor how full to pack the pages, for indexes that have pages
+   * @return DB_KEY_TOO_LONG, leaving the index empty or partly filled, if a key does not fit the index
+   */
+  virtual dberr_t BulkLoad(const std::function<bool(Row &key, RowId &row_id)> &next, Txn *txn,
+                           [[maybe_unused]] double fill_factor = DEFAULT_INDEX_FILL_FACTOR) {
+    Row key;
+    RowId row_id;
+    while (next(key, row_id)) {
+      // 唯一索引里重复的键照常跳过
+      if (InsertEntry(key, row_id, txn) == DB_KEY_TOO_LONG) {
+        return DB_KEY_TOO_LONG;
+      }
+    }
+    return DB_SUCCESS;
+  }
+
  protected:
   index_id_t index_id_;
   IndexSchema *key_schema_;
+  bool unique_;
 };
 
 #endif  // MINISQL_INDEX_H
@@ -3,6 +3,11 @@
 
 #include "page/b_plus_tree_leaf_page.h"
 
+/**
+ * IndexIterator walks the leaf chain with the leaf it stands on pinned. It only latches a leaf while reading it,
+ * so the entry it returns may change under a concurrent writer; it is meant for tests and debugging, and range
+ * scans that run alongside writers go through BPlusTreeIndexCursor.
+ */
 class IndexIterator {
   using LeafPage = BPlusTreeLeafPage;
 
@@ -28,6 +33,7 @@ class IndexIterator {
 
  private:
   page_id_t current_page_id{INVALID_PAGE_ID};
+  Page *frame{nullptr};  // page 所在的缓冲池页，加锁用
   LeafPage *page{nullptr};
   int item_index{0};
   BufferPoolManager *buffer_pool_manager{nullptr};
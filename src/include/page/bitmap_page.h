@@ -15,11 +15,19 @@ class BitmapPage {
   static constexpr size_t GetMaxSupportedSize() { return 8 * MAX_CHARS; }
 
   /**
+   * Allocate the first free page at or after the next_free_page_ hint, wrapping around the extent.
    * @param page_offset Index in extent of the page allocated.
    * @return true if successfully allocate a page.
    */
   bool AllocatePage(uint32_t &page_offset);
 
+  /**
+   * Allocate count consecutive free pages, taking the lowest run that fits.
+   * @param page_offset Index in extent of the first page of the run.
+   * @return false if no run of count free pages exists in the extent.
+   */
+  bool AllocateRun(uint32_t count, uint32_t &page_offset);
+
   /**
    * @return true if successfully de-allocate a page.
    */
@@ -40,9 +48,19 @@ class BitmapPage {
    */
   bool IsPageFreeLow(uint32_t byte_index, uint8_t bit_index) const;
 
+  /**
+   * @return the word_index-th 64-bit word of bytes, bit i of the word being page word_index * 64 + i
+   */
+  uint64_t LoadWord(uint32_t word_index) const;
+
   /** Note: need to update if modify page structure. */
   static constexpr size_t MAX_CHARS = PageSize - 2 * sizeof(uint32_t);
 
+  /** bytes is scanned 64 bits at a time when looking for a free page */
+  static constexpr uint32_t WORD_BITS = 64;
+  static constexpr uint32_t NUM_WORDS = MAX_CHARS * 8 / WORD_BITS;
+  static_assert(MAX_CHARS % sizeof(uint64_t) == 0, "bitmap must consist of whole 64-bit words");
+
  private:
   /** The space occupied by all members of the class should be equal to the PageSize */
   [[maybe_unused]] uint32_t page_allocated_;
@@ -0,0 +1,58 @@
+#ifndef MINISQL_FREE_SPACE_MAP_PAGE_H
+#define MINISQL_FREE_SPACE_MAP_PAGE_H
+
+#include <utility>
+
+#include "common/config.h"
+
+/**
+ * One page of a table heap's free space map. It records, for a run of heap pages in chain order, how many bytes
+ * each of them has left. The pages of one map are linked into a list. An entry whose page id is INVALID_PAGE_ID
+ * belongs to a page that has been removed from the heap.
+ *
+ * Format (size in byte):
+ *  ------------------------------------------------------------------------------------------
+ * | NextPageId (4) | EntryCount (4) | Page_1 id (4) | Page_1 free space (4) | ... |
+ *  ------------------------------------------------------------------------------------------
+ */
+class FreeSpaceMapPage {
+ public:
+  void Init() {
+    next_page_id_ = INVALID_PAGE_ID;
+    count_ = 0;
+  }
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  uint32_t GetCount() const { return count_; }
+
+  bool IsFull() const { return count_ >= MAX_ENTRY_COUNT; }
+
+  /**
+   * Append an entry for heap page page_id.
+   * @return index of the new entry, or -1 if the page is full
+   */
+  int Append(page_id_t page_id, uint32_t free_space);
+
+  page_id_t PageIdAt(uint32_t index) const { return entries_[index].first; }
+
+  uint32_t FreeSpaceAt(uint32_t index) const { return entries_[index].second; }
+
+  void SetFreeSpaceAt(uint32_t index, uint32_t free_space) { entries_[index].second = free_space; }
+
+  void RemoveAt(uint32_t index) {
+    entries_[index].first = INVALID_PAGE_ID;
+    entries_[index].second = 0;
+  }
+
+  static constexpr uint32_t MAX_ENTRY_COUNT = (PAGE_SIZE - 8) / 8;
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t count_;
+  std::pair<page_id_t, uint32_t> entries_[0];
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_PAGE_H
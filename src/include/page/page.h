@@ -16,6 +16,7 @@
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class BufferPoolManagerInstance;
 
  public:
   DISALLOW_COPY(Page)
@@ -47,6 +48,9 @@ class Page {
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
 
+  /** Acquire the page read latch if that needs no waiting. @return whether it was acquired */
+  inline bool TryRLatch() { return rwlatch_.TryRLock(); }
+
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
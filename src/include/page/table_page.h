@@ -18,6 +18,7 @@
  **/
 
 #include <cstring>
+#include <vector>
 
 #include "common/macros.h"
 #include "common/rowid.h"
@@ -62,6 +63,29 @@ class TablePage : public Page {
 
   bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
 
+  /**
+   * Collect the slot numbers of all live tuples, in slot order. The caller holds at least the read latch.
+   */
+  void GetLiveSlots(std::vector<uint32_t> *slots);
+
+  /**
+   * @return the serialized bytes of the tuple in slot_num, read in place, or nullptr if the slot is empty or
+   *         the tuple is marked deleted
+   */
+  const char *GetTupleData(uint32_t slot_num) {
+    if (slot_num >= GetTupleCount() || IsDeleted(GetTupleSize(slot_num))) {
+      return nullptr;
+    }
+    return GetData() + GetTupleOffsetAtSlot(slot_num);
+  }
+
+  /**
+   * Defragment the page: drop the empty slots at the end of the slot directory and pack the tuples against the
+   * end of the page. Live and marked-deleted tuples keep their slot numbers, so no RowId changes.
+   * @return number of bytes reclaimed
+   */
+  uint32_t Compact();
+
  private:
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
 
@@ -7,6 +7,8 @@
   int yyerror(char* error);
 %}
 
+%define api.header.include {"parser/minisql_yacc.h"}
+
 %union {
 	pSyntaxNode syntax_node;
 }
@@ -26,7 +28,7 @@
 %type <syntax_node> sql_trx_begin sql_trx_commit sql_trx_rollback
 %type <syntax_node> sql_select select_columns column_values column_value operator
 %type <syntax_node> connector where_conditions where_condition
-%type <syntax_node> sql_insert sql_delete sql_update update_values update_value
+%type <syntax_node> sql_insert value_rows value_row sql_delete sql_update update_values update_value
 %type <syntax_node> sql_quit sql_exec_file
 
 %%
@@ -289,12 +291,27 @@ operator:
   ;
 
 sql_insert:
-  INSERT INTO IDENTIFIER VALUES '(' column_values ')' {
+  INSERT INTO IDENTIFIER VALUES value_rows {
     $$ = CreateSyntaxNode(kNodeInsert, NULL);
     SyntaxNodeAddChildren($$, $3);
-    pSyntaxNode col_val_node = CreateSyntaxNode(kNodeColumnValues, NULL);
-    SyntaxNodeAddChildren(col_val_node, $6);
-    SyntaxNodeAddChildren($$, col_val_node);
+    SyntaxNodeAddChildren($$, $5);
+  }
+  ;
+
+value_rows:
+  value_rows ',' value_row {
+    $$ = $1;
+    SyntaxNodeAddSibling($$, $3);
+  }
+  | value_row {
+    $$ = $1;
+  }
+  ;
+
+value_row:
+  '(' column_values ')' {
+    $$ = CreateSyntaxNode(kNodeColumnValues, NULL);
+    SyntaxNodeAddChildren($$, $2);
   }
   ;
 
@@ -10,6 +10,7 @@
 
 #include "record/row.h"
 #include "record/schema.h"
+#include "record/tuple_view.h"
 
 class AbstractExpression;
 using AbstractExpressionRef = std::shared_ptr<AbstractExpression>;
@@ -36,6 +37,12 @@ class AbstractExpression {
   /** @return The field obtained by evaluating the row */
   virtual Field Evaluate(const Row *row) const = 0;
 
+  /**
+   * Evaluate against a tuple read in place. CHAR fields taken from the view point into the page, so the
+   * result must be used before the page is unpinned.
+   */
+  virtual Field Evaluate(const TupleView &view) const = 0;
+
   /**
    * Returns the field obtained by evaluating a JOIN.
    * @param left_row The left row
@@ -18,6 +18,8 @@ class ConstantValueExpression : public AbstractExpression {
 
   Field Evaluate(const Row *row) const override { return Field(val_); }
 
+  Field Evaluate([[maybe_unused]] const TupleView &view) const override { return Field(val_); }
+
   Field EvaluateJoin(const Row *left_row, const Row *right_row) const override { return Field(val_); }
 
   const Field val_;
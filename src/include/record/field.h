@@ -75,12 +75,27 @@ class Field {
     }
   }
 
+  // move constructor, takes over the CHAR data of other
+  Field(Field &&other) noexcept
+      : value_(other.value_),
+        type_id_(other.type_id_),
+        len_(other.len_),
+        is_null_(other.is_null_),
+        manage_data_(other.manage_data_) {
+    other.manage_data_ = false;
+  }
+
   // copy
   Field &operator=(Field &other) {
     Swap(*this, other);
     return *this;
   }
 
+  Field &operator=(Field &&other) noexcept {
+    Swap(*this, other);
+    return *this;
+  }
+
   inline bool IsNull() const { return is_null_; }
 
   inline uint32_t GetLength() const { return Type::GetInstance(type_id_)->GetLength(*this); }
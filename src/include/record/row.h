@@ -11,15 +11,18 @@
 
 /**
  *  Row format:
- * -------------------------------------------
- * | Header | Field-1 | ... | Field-N |
- * -------------------------------------------
- *  Header format:
- * --------------------------------------------
- * | Field Nums | Null bitmap |
- * -------------------------------------------
- *
- *
+ * ---------------------------------------------------------
+ * | Null bitmap | Slot-1 | ... | Slot-N | Tail (optional) |
+ * ---------------------------------------------------------
+ *  The layout of the fixed part depends only on the schema (Schema::GetColumnOffset), so column k is read at
+ *  a constant offset without decoding columns 0..k-1. Null fields keep their slot, zero filled.
+ *  INT/FLOAT slot: the 4 byte value.
+ *  CHAR(n) slot:
+ * ---------------------------------------------------
+ * | Length (4) | Data, max(n, 4) bytes, zero padded |
+ * ---------------------------------------------------
+ *  A value longer than n (declared lengths are not enforced everywhere) keeps its data in the tail instead, and
+ *  the first 4 data bytes of the slot hold its offset from the start of the row.
  */
 class Row {
  public:
@@ -27,23 +30,14 @@ class Row {
    * Row used for insert
    * Field integrity should check by upper level
    */
-  Row(std::vector<Field> &fields) {
-    // deep copy
-    for (auto &field : fields) {
-      fields_.push_back(new Field(field));
-    }
-  }
+  Row(const std::vector<Field> &fields) { CopyFields(fields); }
 
   void destroy() {
-    if (!fields_.empty()) {
-      for (auto field : fields_) {
-        delete field;
-      }
-      fields_.clear();
-    }
+    fields_.clear();
+    chars_.reset();
   }
 
-  ~Row() { destroy(); };
+  ~Row() = default;
 
   /**
    * Row used for deserialize
@@ -58,26 +52,26 @@ class Row {
   /**
    * Row copy function, deep copy
    */
-  Row(const Row &other) {
-    destroy();
-    rid_ = other.rid_;
-    for (auto &field : other.fields_) {
-      fields_.push_back(new Field(*field));
-    }
-  }
+  Row(const Row &other) : rid_(other.rid_) { CopyFields(other.fields_); }
+
+  /**
+   * Row move function, takes over the fields and their data without copying
+   */
+  Row(Row &&other) noexcept = default;
 
   /**
    * Assign operator, deep copy
    */
   Row &operator=(const Row &other) {
-    destroy();
-    rid_ = other.rid_;
-    for (auto &field : other.fields_) {
-      fields_.push_back(new Field(*field));
+    if (this != &other) {
+      rid_ = other.rid_;
+      CopyFields(other.fields_);
     }
     return *this;
   }
 
+  Row &operator=(Row &&other) noexcept = default;
+
   /**
    * Note: Make sure that bytes write to buf is equal to GetSerializedSize()
    */
@@ -94,22 +88,57 @@ class Row {
 
   void GetKeyFromRow(const Schema *schema, const Schema *key_schema, Row &key_row);
 
+  /**
+   * Locate the data of a non-null CHAR field in a serialized row.
+   * @param buf start of the serialized row
+   * @param idx position of the CHAR column in schema
+   * @param[out] len length of the value
+   */
+  static inline const char *GetCharData(const char *buf, const Schema *schema, uint32_t idx, uint32_t *len) {
+    const char *slot = buf + schema->GetColumnOffset(idx);
+    *len = MACH_READ_UINT32(slot);
+    if (*len > schema->GetColumn(idx)->GetLength()) {
+      return buf + MACH_READ_UINT32(slot + sizeof(uint32_t));
+    }
+    return slot + sizeof(uint32_t);
+  }
+
   inline const RowId GetRowId() const { return rid_; }
 
   inline void SetRowId(RowId rid) { rid_ = rid; }
 
-  inline std::vector<Field *> &GetFields() { return fields_; }
+  inline const std::vector<Field> &GetFields() const { return fields_; }
 
   inline Field *GetField(uint32_t idx) const {
     ASSERT(idx < fields_.size(), "Failed to access field");
-    return fields_[idx];
+    return const_cast<Field *>(&fields_[idx]);
   }
 
   inline size_t GetFieldCount() const { return fields_.size(); }
 
  private:
+  /**
+   * Replace the fields of this row by copies of fields, with all their CHAR data in one buffer.
+   */
+  void CopyFields(const std::vector<Field> &fields);
+
+  /**
+   * Append a field that borrows the CHAR data of field; OwnCharData must run before the data goes away.
+   */
+  void AppendBorrowed(const Field &field);
+
+  /**
+   * Copy the CHAR data every field points at into a single buffer owned by the row, and repoint the fields.
+   */
+  void OwnCharData();
+
   RowId rid_{};
-  std::vector<Field *> fields_; /** Make sure that all field ptr are destructed*/
+  /**
+   * Fields are stored inline. CHAR fields do not manage their data, it lives in chars_, so a row costs at most
+   * two allocations however many columns it has, and moving it costs none.
+   */
+  std::vector<Field> fields_;
+  std::unique_ptr<char[]> chars_;
 };
 
 #endif  // MINISQL_ROW_H
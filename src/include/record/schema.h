@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <vector>
@@ -13,7 +14,9 @@
 class Schema {
  public:
   explicit Schema(const std::vector<Column *> columns, bool is_manage_ = true)
-      : columns_(std::move(columns)), is_manage_(is_manage_) {}
+      : columns_(std::move(columns)), is_manage_(is_manage_) {
+    ComputeRowLayout();
+  }
 
   ~Schema() {
     if (is_manage_) {
@@ -39,6 +42,26 @@ class Schema {
 
   inline uint32_t GetColumnCount() const { return static_cast<uint32_t>(columns_.size()); }
 
+  /** @return size of the null bitmap at the start of a serialized row, see row.h */
+  inline uint32_t GetNullBitmapSize() const { return (GetColumnCount() + 7) / 8; }
+
+  /** @return offset of the fixed-width slot of column column_index in a serialized row */
+  inline uint32_t GetColumnOffset(const uint32_t column_index) const { return column_offsets_[column_index]; }
+
+  /** @return size of a serialized row without tail data: null bitmap plus every column slot */
+  inline uint32_t GetFixedRowSize() const { return fixed_row_size_; }
+
+  /**
+   * @return size of the slot a column takes in a serialized row. A CHAR(n) slot holds a 4 byte length and n
+   *         inline bytes, at least 4 so that an overflowing value can keep its tail offset there.
+   */
+  static uint32_t GetColumnSlotSize(const Column *column) {
+    if (column->GetType() == TypeId::kTypeChar) {
+      return sizeof(uint32_t) + std::max(column->GetLength(), static_cast<uint32_t>(sizeof(uint32_t)));
+    }
+    return Type::GetTypeSize(column->GetType());
+  }
+
   /**
    * Shallow copy schema, only used in index
    *
@@ -81,9 +104,14 @@ class Schema {
   static uint32_t DeserializeFrom(char *buf, Schema *&schema);
 
  private:
+  /** Lay the column slots out one after another behind the null bitmap. */
+  void ComputeRowLayout();
+
   static constexpr uint32_t SCHEMA_MAGIC_NUM = 200715;
   std::vector<Column *> columns_;
   bool is_manage_ = false; /** if false, don't need to delete pointer to column */
+  std::vector<uint32_t> column_offsets_;  // 每列定长槽在序列化行中的偏移
+  uint32_t fixed_row_size_{0};             // 空值位图加上所有定长槽的大小
 };
 
 using IndexSchema = Schema;
@@ -0,0 +1,59 @@
+#ifndef MINISQL_TUPLE_VIEW_H
+#define MINISQL_TUPLE_VIEW_H
+
+
+#include "common/macros.h"
+#include "record/field.h"
+#include "record/row.h"
+#include "record/schema.h"
+
+/**
+ * TupleView reads the fields of a serialized row (see the format in row.h) in place, without building a Row.
+ *
+ * The view does not own the bytes it points at; whoever hands them out (e.g. TableIterator) keeps the page
+ * pinned while the view is in use. Every column sits at an offset fixed by the schema, so reading one column
+ * costs the same whatever its position.
+ */
+class TupleView {
+ public:
+  TupleView() = default;
+
+  /**
+   * Point the view at another serialized row.
+   */
+  void Reset(const char *data, const Schema *schema) {
+    data_ = data;
+    schema_ = schema;
+  }
+
+  inline bool IsValid() const { return data_ != nullptr; }
+
+  inline uint32_t GetFieldCount() const { return schema_->GetColumnCount(); }
+
+  inline bool IsNull(uint32_t idx) const {
+    ASSERT(idx < GetFieldCount(), "Failed to access field");
+    return (data_[idx / 8] & (1 << (idx % 8))) != 0;
+  }
+
+  /**
+   * CHAR fields point into the viewed bytes (manage_data = false), so the returned field must not outlive
+   * the pin on the page. Pass copy_data to get a field that owns its data.
+   */
+  Field GetField(uint32_t idx, bool copy_data = false) const;
+
+  /**
+   * Deserialize the whole row into row, which must be empty.
+   */
+  void ToRow(Row *row) const;
+
+  /**
+   * Build row from the columns of output_schema only, looked up by Column::GetTableInd.
+   */
+  void Project(const Schema *output_schema, Row *row) const;
+
+ private:
+  const char *data_{nullptr};
+  const Schema *schema_{nullptr};
+};
+
+#endif  // MINISQL_TUPLE_VIEW_H
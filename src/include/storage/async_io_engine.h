@@ -0,0 +1,73 @@
+#ifndef MINISQL_ASYNC_IO_ENGINE_H
+#define MINISQL_ASYNC_IO_ENGINE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "common/config.h"
+
+/**
+ * AsyncIOEngine keeps a batch of page transfers in flight on one file descriptor using Linux native AIO
+ * (io_setup / io_submit / io_getevents). Requests are submitted up to queue_depth at a time and the queue is
+ * refilled as completions are reaped, so a batch of N pages costs roughly N / queue_depth device round trips
+ * instead of N.
+ *
+ * Native AIO is only asynchronous for files opened with O_DIRECT; on a buffered file io_submit completes the
+ * transfer inline, which is still correct. Where AIO is unavailable (non-Linux, or io_setup refused) the engine
+ * falls back to sequential pread/pwrite.
+ */
+class AsyncIOEngine {
+ public:
+  /**
+   * One page transfer. For reads, bytes beyond the end of file are zero-filled.
+   */
+  struct Request {
+    uint64_t offset_;
+    char *data_;
+    bool is_write_;
+    bool failed_{false};  // set by Execute if the transfer failed
+  };
+
+  /**
+   * @param fd file descriptor all requests go to
+   * @param direct_io whether fd is opened with O_DIRECT, in which case unaligned buffers go through bounce pages
+   */
+  AsyncIOEngine(int fd, bool direct_io);
+
+  ~AsyncIOEngine();
+
+  /**
+   * Run all requests, keeping up to queue_depth of them in flight, and return once every one has completed.
+   * If io_getevents fails, the AIO context is destroyed, which waits out the requests in flight, and the engine
+   * redoes them and runs everything after synchronously from then on.
+   * @return false if any transfer failed; the failed ones have failed_ set
+   */
+  bool Execute(std::vector<Request> &requests, size_t queue_depth);
+
+  /** @return whether requests are really submitted through native AIO */
+  bool IsAsync() const { return aio_context_ != 0; }
+
+  /** upper bound of queue_depth */
+  static constexpr size_t MAX_QUEUE_DEPTH = 128;
+
+ private:
+  /**
+   * Run requests one by one with pread/pwrite.
+   */
+  bool ExecuteSync(std::vector<Request> &requests);
+
+  /**
+   * Run one request with pread/pwrite, using bounce as the aligned page if it needs one.
+   * @return false, setting failed_, on an I/O error or a short transfer, except a read that reaches the end of
+   *         file
+   */
+  bool ExecuteOne(Request &request, char *bounce);
+
+ private:
+  int fd_;
+  bool direct_io_;
+  unsigned long aio_context_{0};  // aio_context_t, 0 if native AIO is unavailable
+  char *bounce_pages_{nullptr};   // MAX_QUEUE_DEPTH aligned pages for O_DIRECT transfers of unaligned buffers
+};
+
+#endif  // MINISQL_ASYNC_IO_ENGINE_H
@@ -2,15 +2,17 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
 #include <iostream>
 #include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/async_io_engine.h"
 
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
@@ -19,15 +21,27 @@
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
+ *
+ * The meta page and the free page bitmaps are kept in memory: allocation only flips bits there, and the modified
+ * pages are written back together by FlushMetadata() and Close().
+ *
+ * Pages are transferred with positional pread/pwrite on a raw file descriptor, so concurrent reads do not share a
+ * file cursor and need no latch. The file size is cached instead of being stat()-ed on every read. With direct_io
+ * the file is opened with O_DIRECT (falling back to buffered I/O where the file system refuses it) and transfers
+ * bypass the kernel page cache, going through an aligned bounce buffer when the caller's buffer is not aligned.
  */
 class DiskManager {
  public:
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false);
 
   ~DiskManager() {
     if (!closed) {
       Close();
     }
+    delete aio_engine_;
+    for (auto bitmap : bitmaps_) {
+      free(bitmap);
+    }
   }
 
   /**
@@ -42,12 +56,38 @@ class DiskManager {
    */
   void WritePage(page_id_t logical_page_id, const char *page_data);
 
+  /**
+   * Read a batch of pages through the asynchronous I/O engine, keeping up to queue_depth reads in flight.
+   * Returns once every page has been read into its buffer. ReadPage is the synchronous single-page form.
+   * @param pages pairs of logical page id and destination buffer
+   * @param[out] failed if given, the pages whose read failed are appended to it
+   * @return false if any read failed
+   */
+  bool ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages, size_t queue_depth = DEFAULT_IO_QUEUE_DEPTH,
+                 std::vector<page_id_t> *failed = nullptr);
+
+  /**
+   * Write a batch of pages through the asynchronous I/O engine, keeping up to queue_depth writes in flight.
+   * @param pages pairs of logical page id and source buffer
+   * @param[out] failed if given, the pages whose write failed are appended to it
+   * @return false if any write failed
+   */
+  bool WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages,
+                  size_t queue_depth = DEFAULT_IO_QUEUE_DEPTH, std::vector<page_id_t> *failed = nullptr);
+
   /**
    * Get next free page from disk
    * @return logical page id of allocated page
    */
   page_id_t AllocatePage();
 
+  /**
+   * Allocate count pages with consecutive logical page ids, all inside one extent so that they are also
+   * physically contiguous.
+   * @return logical page id of the first page of the run, INVALID_PAGE_ID if no extent has such a run
+   */
+  page_id_t AllocatePages(uint32_t count);
+
   /**
    * Free this page and reset bit map
    */
@@ -58,6 +98,11 @@ class DiskManager {
    */
   bool IsPageFree(page_id_t logical_page_id);
 
+  /**
+   * Write the meta page and the modified bitmap pages back to disk as one batch.
+   */
+  void FlushMetadata();
+
   /**
    * Shut down the disk manager and close all the file resources.
    */
@@ -69,13 +114,26 @@ class DiskManager {
    */
   char *GetMetaData() { return meta_data_; }
 
+  /**
+   * @return whether the file is actually opened with O_DIRECT
+   */
+  bool IsDirectIO() const { return direct_io_; }
+
+  /**
+   * @return number of pages read through ReadPage and ReadPages so far
+   */
+  size_t GetNumReads() const { return num_reads_; }
+
   static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
 
+  /** buffer and offset alignment required by O_DIRECT */
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
  private:
   /**
-   * Helper function to get disk file size
+   * Open the database file, creating it and its parent directories if needed
    */
-  int GetFileSize(const std::string &file_name);
+  void OpenFile(bool direct_io);
 
   /**
    * Read physical page from disk
@@ -87,19 +145,46 @@ class DiskManager {
    */
   void WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
 
+  /**
+   * Advance the cached file size to cover a page written at offset
+   */
+  void ExtendFileSize(uint64_t offset);
+
+  /**
+   * @return the cached bitmap page of extent_id, read from disk on first use. Must be called with db_io_latch_ held.
+   */
+  BitmapPage<PAGE_SIZE> *GetBitmap(uint32_t extent_id);
+
+  /**
+   * @return physical page id of the bitmap page of extent_id
+   */
+  static page_id_t BitmapPhysicalId(uint32_t extent_id) { return 1 + extent_id * (1 + BITMAP_SIZE); }
+
   /**
    * Map logical page id to physical page id
    */
   page_id_t MapPageId(page_id_t logical_page_id);
 
  private:
-  // stream to write db file
-  std::fstream db_io_;
+  // file descriptor of db file
+  int db_fd_{-1};
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  bool direct_io_{false};
+  // cached size of db file in bytes
+  std::atomic<uint64_t> file_size_{0};
+  // pages read through ReadPage and ReadPages
+  std::atomic<size_t> num_reads_{0};
+  // protects the meta page and the bitmap pages; page reads and writes do not need it
   std::recursive_mutex db_io_latch_;
+  // batched page I/O, one batch at a time
+  AsyncIOEngine *aio_engine_{nullptr};
+  std::mutex aio_latch_;
   bool closed{false};
-  char meta_data_[PAGE_SIZE];
+  alignas(DIRECT_IO_ALIGNMENT) char meta_data_[PAGE_SIZE];
+  // bitmap pages stay resident once read and are only written back by FlushMetadata, indexed by extent id
+  std::vector<char *> bitmaps_;
+  std::vector<bool> bitmap_dirty_;
+  bool meta_dirty_{false};
 };
 
 #endif
\ No newline at end of file
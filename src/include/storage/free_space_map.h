@@ -0,0 +1,116 @@
+#ifndef MINISQL_FREE_SPACE_MAP_H
+#define MINISQL_FREE_SPACE_MAP_H
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "page/free_space_map_page.h"
+
+/**
+ * FreeSpaceMap tracks how much room every page of a table heap has left, so that an insert can find a page with
+ * enough space without looking at the heap.
+ *
+ * The map is persisted in a list of FreeSpaceMapPage, one entry per heap page in chain order, and mirrored in
+ * memory as buckets of BUCKET_WIDTH bytes. FindPage looks only at buckets whose every page is large enough, so a
+ * lookup costs at most NUM_BUCKETS set lookups regardless of the heap size. An entry is only rewritten on disk
+ * when its page moves to another bucket, which is all FindPage depends on, so most inserts do not touch the map
+ * pages at all.
+ *
+ * If the buffer pool cannot supply a map page, the call that needed it returns false. A map whose pages could not
+ * be created or read at all is not loaded: FindPage finds nothing and every change fails, so the heap reports the
+ * inserts that would need it as failed instead of losing track of pages.
+ */
+class FreeSpaceMap {
+ public:
+  /**
+   * Create an empty map with its first page; the map is not loaded if that page cannot be allocated.
+   */
+  explicit FreeSpaceMap(BufferPoolManager *buffer_pool_manager);
+
+  /**
+   * Open the map whose first page is first_page_id, reading the whole list of map pages; the map is not loaded if
+   * one of them cannot be fetched.
+   */
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id);
+
+  /**
+   * Record a page appended to the heap chain.
+   * @return false, recording nothing, if the map page to hold the entry cannot be fetched or allocated
+   */
+  bool AddPage(page_id_t page_id, uint32_t free_space);
+
+  /**
+   * Record the current free space of a heap page. The entry in memory always changes, so FindPage sees it; if
+   * its map page cannot be fetched the stored entry is rewritten by a later Update.
+   * @return false if the page is unknown or the stored entry could not be rewritten
+   */
+  bool Update(page_id_t page_id, uint32_t free_space);
+
+  /**
+   * Forget a page unlinked from the heap chain. Its entry stays behind as a hole so that the remaining entries
+   * keep chain order.
+   * @return false, forgetting nothing, if the page is unknown or its map page cannot be fetched
+   */
+  bool RemovePage(page_id_t page_id);
+
+  /**
+   * @return a heap page with at least size bytes free, preferring the fullest and then the lowest such page,
+   *         or INVALID_PAGE_ID if there is none
+   */
+  page_id_t FindPage(uint32_t size) const;
+
+  /**
+   * Append to page_ids up to count heap pages that follow page_id in chain order; nothing if page_id is unknown.
+   */
+  void GetNextPages(page_id_t page_id, size_t count, std::vector<page_id_t> *page_ids) const;
+
+  /**
+   * Delete the map pages. The map must not be used afterwards.
+   */
+  void Destroy();
+
+  /** @return whether the map pages were created or read, see the class comment */
+  bool IsLoaded() const { return !map_pages_.empty(); }
+
+  /** @return the first map page, INVALID_PAGE_ID if it could not be created */
+  page_id_t GetFirstPageId() const { return first_page_id_; }
+
+  /** @return the last heap page recorded, i.e. the tail of the chain */
+  page_id_t GetLastPageId() const { return last_page_id_; }
+
+  size_t GetPageCount() const { return entries_.size(); }
+
+  /** @return free bytes summed over all heap pages */
+  uint64_t GetTotalFreeSpace() const { return total_free_space_; }
+
+  static constexpr uint32_t BUCKET_WIDTH = 128;
+  static constexpr uint32_t NUM_BUCKETS = PAGE_SIZE / BUCKET_WIDTH + 1;
+
+ private:
+  struct Entry {
+    uint32_t map_index_;          // index of the map page holding the entry
+    uint32_t slot_;               // index of the entry in that map page
+    uint32_t free_space_;         // free space as last reported
+    uint32_t stored_free_space_;  // free space as last written to the map page
+  };
+
+  static uint32_t BucketOf(uint32_t free_space) { return free_space / BUCKET_WIDTH; }
+
+  /** @return index of the entry in chain_ */
+  static size_t PositionOf(const Entry &entry) {
+    return static_cast<size_t>(entry.map_index_) * FreeSpaceMapPage::MAX_ENTRY_COUNT + entry.slot_;
+  }
+
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t first_page_id_{INVALID_PAGE_ID};
+  std::vector<page_id_t> map_pages_;                // map pages in list order
+  std::unordered_map<page_id_t, Entry> entries_;    // heap page id -> its entry
+  std::vector<page_id_t> chain_;                    // heap pages in chain order, INVALID_PAGE_ID where removed
+  std::vector<std::set<page_id_t>> buckets_;        // heap pages by free space bucket
+  page_id_t last_page_id_{INVALID_PAGE_ID};
+  uint64_t total_free_space_{0};
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_H
@@ -1,13 +1,59 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <functional>
+#include <mutex>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
 #include "page/header_page.h"
 #include "page/table_page.h"
 #include "recovery/log_manager.h"
-#include <map>
+#include "storage/free_space_map.h"
 #include "storage/table_iterator.h"
+
+/**
+ * Summary of a table heap stored in the table's meta page, so that the heap opens without reading any of its pages.
+ */
+struct TableHeapMeta {
+  page_id_t free_space_map_page_id_{INVALID_PAGE_ID};  // first page of the free space map
+  page_id_t last_page_id_{INVALID_PAGE_ID};            // tail of the page chain
+  uint32_t page_count_{0};                             // number of pages in the chain
+  uint64_t free_space_{0};                             // free bytes summed over all pages
+};
+
+/**
+ * Space usage of a table heap, used to tell how bloated it is.
+ */
+struct TableHeapStats {
+  uint32_t page_count_{0};        // pages in the chain
+  uint32_t tuple_count_{0};       // live tuples
+  uint32_t dead_tuple_count_{0};  // tuples marked deleted but not yet removed
+  uint32_t empty_slot_count_{0};  // slots left behind by removed tuples
+  uint64_t live_bytes_{0};        // bytes of live tuples
+  uint64_t dead_bytes_{0};        // bytes of tuples marked deleted
+  uint64_t free_bytes_{0};        // free space summed over all pages
+
+  /** @return the fraction of the heap's pages not holding live tuples */
+  double GetBloatRatio() const {
+    if (page_count_ == 0) {
+      return 0;
+    }
+    return 1.0 - static_cast<double>(live_bytes_) / (static_cast<double>(page_count_) * PAGE_SIZE);
+  }
+};
+
+/**
+ * What a TableHeap::Vacuum pass did.
+ */
+struct VacuumStats {
+  uint32_t dead_tuples_removed_{0};  // marked deleted tuples physically removed
+  uint32_t tuples_moved_{0};         // tuples moved out of sparse pages
+  uint32_t pages_freed_{0};          // emptied pages returned to the disk manager
+  uint64_t bytes_reclaimed_{0};      // space reclaimed by removing tuples and compacting pages
+};
+
 class TableHeap {
   friend class TableIterator;
 
@@ -17,12 +63,24 @@ class TableHeap {
     return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
   }
 
+  /**
+   * Open an existing table heap in constant time. The free space map named by heap_meta is only read when the
+   * heap is first modified or a scan reads ahead; without one the page chain is walked to build it on the first
+   * modification, and scans do not read ahead.
+   */
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+                           LogManager *log_manager, LockManager *lock_manager,
+                           const TableHeapMeta &heap_meta = TableHeapMeta()) {
+    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager, heap_meta);
   }
 
-  ~TableHeap() {}
+  ~TableHeap() {
+    for (page_id_t page_id : unlinked_pages_) {
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+    buffer_pool_manager_->ReleaseExtent(&extent_);
+    delete free_space_map_;
+  }
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
@@ -32,6 +90,17 @@ class TableHeap {
    */
   bool InsertTuple(Row &row, Txn *txn);
 
+  /**
+   * Append rows at the end of the table. The tail page stays pinned and latched while rows are packed into it,
+   * and the free space map is updated once per filled page instead of once per row. Free space in earlier pages
+   * is not reused.
+   * @param[in/out] rows Rows to insert, the rid assigned to each row is wrapped in it, e.g. for index maintenance
+   * @param[in] txn The recovery performing the insert
+   * @return true iff every row is inserted; false if a row is too large (then nothing is inserted) or the buffer
+   *         pool is full (then the rows before the failing one are inserted)
+   */
+  bool BulkInsert(std::vector<Row> &rows, Txn *txn);
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
    * @param[in] rid Resource id of the tuple of delete
@@ -81,8 +150,33 @@ class TableHeap {
       buffer_pool_manager_->UnpinPage(old_page_id, false);
       buffer_pool_manager_->DeletePage(old_page_id);
     }
+    GetFreeSpaceMap()->Destroy();
   }
 
+  /**
+   * Walk the heap and collect its space usage.
+   */
+  void GetStats(TableHeapStats *stats);
+
+  /**
+   * Reclaim the space of the heap in place. Every page gets its marked-deleted tuples removed and is compacted.
+   * The live tuples of sparse pages (at most VACUUM_SPARSE_BYTES of tuples) are then moved into fuller pages,
+   * from the tail of the chain on, and pages left empty are unlinked and returned to the disk manager. The
+   * first page is never freed. An emptied page that is still pinned, e.g. by a TableIterator, is only unlinked;
+   * it is returned and counted in stats by a later pass, once nobody holds it.
+   *
+   * Only one page (plus the target of a move) is latched at a time, so the table stays usable during the pass.
+   * Marked deletes are treated as committed; do not vacuum while a transaction that may roll back a delete is
+   * active.
+   * @param on_move called for every moved tuple with the row, which carries its new RowId, and its old RowId,
+   *        e.g. to update the indexes of the table
+   */
+  void Vacuum(VacuumStats *stats, Txn *txn,
+              const std::function<void(Row &row, const RowId &old_rid)> &on_move = nullptr);
+
+  /** pages holding at most this many bytes of tuples are emptied by Vacuum if possible */
+  static constexpr uint32_t VACUUM_SPARSE_BYTES = PAGE_SIZE / 4;
+
   /**
    * Free table heap and release storage in disk file
    */
@@ -103,6 +197,23 @@ class TableHeap {
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * @return the id of the first page of the free space map of this table
+   */
+  inline page_id_t GetFreeSpaceMapPageId() { return GetFreeSpaceMap()->GetFirstPageId(); }
+
+  /**
+   * @return the summary to store in the table's meta page; taken from the free space map if it has been loaded,
+   *         otherwise the summary the heap was opened with
+   */
+  TableHeapMeta GetHeapMeta();
+
+  /**
+   * Append to page_ids up to count pages that follow page_id in the chain, for read-ahead. The free space map is
+   * read if it is stored but not loaded yet; a heap without a stored map lists nothing rather than walk the chain.
+   */
+  void GetNextPages(page_id_t page_id, size_t count, std::vector<page_id_t> *page_ids);
+
  private:
   /**
    * create table heap and initialize first page
@@ -113,33 +224,58 @@ class TableHeap {
         schema_(schema),
         log_manager_(log_manager),
         lock_manager_(lock_manager) {
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
-    page->Init(first_page_id_, INVALID_PAGE_ID, log_manager_, txn);
-    page_free_space_[first_page_id_] = page->GetFreeSpaceRemaining();
+    free_space_map_ = new FreeSpaceMap(buffer_pool_manager_);
+    auto page = AppendPage(txn);
+    first_page_id_ = page->GetTablePageId();
     buffer_pool_manager_->UnpinPage(first_page_id_, true);
   };
 
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
+                     LogManager *log_manager, LockManager *lock_manager, const TableHeapMeta &heap_meta)
       : buffer_pool_manager_(buffer_pool_manager),
         first_page_id_(first_page_id),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-    assert(page != nullptr);
-    page_free_space_[first_page_id_] = page->GetFreeSpaceRemaining();
-    auto next_page_id = page->GetNextPageId();
-    buffer_pool_manager_->UnpinPage(first_page_id_, false);
-    // fill page_free_space_
-    while (next_page_id != INVALID_PAGE_ID) {
-      page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-      assert(page != nullptr);
-      page_free_space_[next_page_id] = page->GetFreeSpaceRemaining();
-      next_page_id = page->GetNextPageId();
-      buffer_pool_manager_->UnpinPage(next_page_id, false);
-    }
-  }
+        lock_manager_(lock_manager),
+        last_page_id_(heap_meta.last_page_id_),
+        heap_meta_(heap_meta) {}
+
+  /**
+   * @return the free space map, reading it (or building it from the page chain) on first use
+   */
+  FreeSpaceMap *GetFreeSpaceMap();
+
+  /**
+   * GetFreeSpaceMap without taking free_space_latch_, which the caller holds.
+   * @param build whether to build a map from the page chain if none is stored
+   * @return the map, nullptr if none is stored and build is false
+   */
+  FreeSpaceMap *LoadFreeSpaceMap(bool build);
+
+  /**
+   * The free space map operations the heap uses, each under free_space_latch_.
+   */
+  page_id_t FindFreePage(uint32_t size);
+
+  void UpdateFreeSpace(page_id_t page_id, uint32_t free_space);
+
+  bool AddToFreeSpaceMap(page_id_t page_id, uint32_t free_space);
+
+  bool RemoveFromFreeSpaceMap(page_id_t page_id);
+
+  /**
+   * Allocate a new page, link it after the tail of the chain and record it in the free space map.
+   * @param tail the tail page if the caller already holds it pinned and write latched, otherwise it is fetched
+   * @return the new page, pinned, or nullptr if the buffer pool is full or the free space map cannot record it
+   */
+  TablePage *AppendPage(Txn *txn, TablePage *tail = nullptr);
+
+  /**
+   * Unlink an empty page, already dropped from the free space map, from the chain and give it back to the disk
+   * manager.
+   * @return false if the page is still pinned, in which case it is kept in unlinked_pages_ to be deleted later
+   */
+  bool UnlinkPage(page_id_t page_id, page_id_t prev_page_id, page_id_t next_page_id);
 
  private:
   BufferPoolManager *buffer_pool_manager_;
@@ -147,8 +283,18 @@ class TableHeap {
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
-  // used to find the page to insert tuple
-  std::map<page_id_t, uint32_t> page_free_space_;
+  // used to find the page to insert tuple, nullptr until first needed
+  FreeSpaceMap *free_space_map_{nullptr};
+  // guards free_space_map_ and its creation, so that scans can read ahead along it while rows are inserted
+  std::mutex free_space_latch_;
+  // tail of the page chain, new pages are linked after it
+  page_id_t last_page_id_{INVALID_PAGE_ID};
+  // contiguous pages reserved for the next pages of the heap
+  PageExtent extent_;
+  // summary the heap was opened with
+  TableHeapMeta heap_meta_;
+  // pages Vacuum unlinked while they were still pinned, not given back to the disk manager yet
+  std::vector<page_id_t> unlinked_pages_;
 };
 
 #endif  // MINISQL_TABLE_HEAP_H
@@ -1,12 +1,29 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
 #include "common/rowid.h"
 #include "concurrency/txn.h"
+#include "page/table_page.h"
 #include "record/row.h"
+#include "record/tuple_view.h"
 
 class TableHeap;
 
+/**
+ * TableIterator walks the live tuples of a table heap in page order.
+ *
+ * The iterator keeps the page of the current tuple pinned until it moves to another page or is destroyed, so
+ * stepping within a page and reading the current tuple need no FetchPage. When it lands on a page it takes the
+ * read latch once to copy the live slot numbers, and ++ then walks that copy without touching the page until
+ * it runs out. The latch is not held between calls: executors stacked on a scan (delete, update) write-latch
+ * the page the scan is on from the same thread. Tuples deleted after the copy show up as an invalid view.
+ *
+ * GetTupleView exposes the current tuple in place; operator* and operator-> deserialize it into a Row owned
+ * by the iterator, at most once per tuple.
+ */
 class TableIterator {
 public:
  // you may define your own constructor based on your member variables
@@ -29,11 +46,44 @@ public:
 
   TableIterator operator++(int);
 
+  inline RowId GetRowId() const { return current_rid_; }
+
+  /**
+   * @return a view over the current tuple's bytes, valid until the iterator moves
+   */
+  const TupleView &GetTupleView();
+
 private:
+  /**
+   * Pin page_id as the current page, unpinning the previous one. Does nothing if it is already current.
+   * @return false if the page cannot be fetched
+   */
+  bool PinPage(page_id_t page_id);
+
+  /** Drop the pin on the current page, if any. */
+  void ReleasePage();
+
+  /**
+   * Move to the first live tuple of page_id, skipping pages without live tuples. Becomes End() when the page
+   * chain runs out.
+   */
+  void SeekFrom(page_id_t page_id);
+
+  /** Copy the live slots of the current page into slots_ under its read latch. */
+  void LoadSlots();
+
+  /** Drop the materialized row and view of the previous tuple. */
+  void ResetCurrent();
+
 TableHeap *table_heap_;  // 指向表堆的指针
 RowId current_rid_;      // 当前记录的 RowId
 Txn *txn_;               // 当前事务
 Row *current_row_;       // 当前记录的指针
+ReadAheadState read_ahead_;  // 顺序扫描的预读状态
+TablePage *page_{nullptr};   // 当前记录所在页，迭代器持有它的 pin
+TupleView view_;             // 当前记录的原地视图
+std::vector<uint32_t> slots_;  // 当前页有效记录的槽号
+size_t slot_idx_{0};           // current_rid_ 在 slots_ 中的下标
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
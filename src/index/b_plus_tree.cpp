@@ -1,6 +1,8 @@
 #include "index/b_plus_tree.h"
 
+#include <algorithm>
 #include <string>
+#include <thread>
 
 #include "glog/logging.h"
 #include "index/basic_comparator.h"
@@ -17,9 +19,11 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
       processor_(KM),
       leaf_max_size_(leaf_max_size),
       internal_max_size_(internal_max_size) {
-        auto root_index = reinterpret_cast<IndexRootsPage*>(buffer_pool_manager->FetchPage(INDEX_ROOTS_PAGE_ID));
-        root_index->GetRootId(index_id,&root_page_id_);
-        buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
+        auto root_index_page = buffer_pool_manager->FetchPage(INDEX_ROOTS_PAGE_ID);
+        root_index_page->RLatch();
+        reinterpret_cast<IndexRootsPage*>(root_index_page->GetData())->GetRootId(index_id,&root_page_id_);
+        root_index_page->RUnlatch();
+        buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, false);
 
         if(leaf_max_size == UNDEFINED_SIZE){
           leaf_max_size_ = (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (processor_.GetKeySize() + sizeof(RowId));
@@ -30,6 +34,11 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
         } 
 }
 
+BPlusTree::~BPlusTree() {
+  DeletePages({});
+  buffer_pool_manager_->ReleaseExtent(&extent_);
+}
+
 void BPlusTree::Destroy(page_id_t current_page_id) {
   buffer_pool_manager_->DeletePage(current_page_id);
 }
@@ -49,42 +58,85 @@ bool BPlusTree::IsEmpty() const {
  * This method is used for point query
  * @return : true means key exists
  */
-//Page* FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) 
 bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction) {
-  if (IsEmpty()){
+  Page *page = CrabToLeaf(key, false, false);
+  if (page == nullptr) {
     return false;
   }
-  auto page_leave_t = reinterpret_cast<BPlusTreeLeafPage*>(FindLeafPage(key,-1,false)->GetData());
-  RowId row_t;
-  bool flag = page_leave_t->Lookup(key,row_t,processor_);
-  if (flag){
-    result.push_back(row_t);
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  RowId row_id;
+  bool found = leaf->Lookup(key, row_id, processor_);
+  if (found) {
+    result.push_back(row_id);
   }
-  buffer_pool_manager_->UnpinPage(page_leave_t->GetPageId(), false);
-  return flag;
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return found;
 }
 
-
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 /*
  * Insert constant key & value pair into b+ tree
- * if current tree is empty, start new tree, update root page id and insert
- * entry, otherwise insert into leaf page.
+ * First try the optimistic path: write latch only the leaf and insert there if
+ * it does not have to split. Otherwise start over on the pessimistic path.
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
-// 如果当前树是空的，则调用StartNewTree，否则，调用InsertIntoLeaf
 bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
-  if (IsEmpty()){
-    StartNewTree(key,value);
+  Page *page = CrabToLeaf(key, false, true);
+  if (page != nullptr) {
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    RowId old_value;
+    if (leaf->Lookup(key, old_value, processor_)) {
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      return false;
+    }
+    if (IsSafe(leaf, Operation::kInsert)) {
+      leaf->Insert(key, value, processor_);
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+      return true;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+  return InsertPessimistic(key, value);
+}
+
+/*
+ * Insert with write latches on every page the insertion may split. Between the
+ * optimistic attempt and here other threads may have changed the tree, so the
+ * duplicate check and the empty tree case are done again.
+ */
+bool BPlusTree::InsertPessimistic(GenericKey *key, const RowId &value) {
+  WriteSet write_set;
+  root_latch_.WLock();
+  write_set.root_locked_ = true;
+  if (IsEmpty()) {
+    StartNewTree(key, value);
+    ReleaseWriteSet(write_set);
     return true;
   }
-  else{
-    return InsertIntoLeaf(key,value,transaction);
+  CrabToLeafForWrite(key, Operation::kInsert, write_set);
+  auto leaf = reinterpret_cast<LeafPage *>(write_set.pages_.back()->GetData());
+  RowId old_value;
+  if (leaf->Lookup(key, old_value, processor_)) {
+    ReleaseWriteSet(write_set);
+    return false;
+  }
+  leaf->Insert(key, value, processor_);
+  if (leaf->GetSize() >= leaf_max_size_) {
+    LeafPage *new_leaf = Split(leaf);
+    InsertIntoParent(leaf, new_leaf->KeyAt(0), new_leaf);
+    buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
   }
+  ReleaseWriteSet(write_set);
+  return true;
 }
+
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
@@ -95,10 +147,7 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
 //然后对根（即叶子）节点进行操作
 void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
   page_id_t page_id_l;
-  auto new_page = buffer_pool_manager_->NewPage(page_id_l);
-  if (new_page == nullptr) {
-    throw("out of memory");
-  }
+  auto new_page = NewTreePage(page_id_l);
   auto page_leave_t = reinterpret_cast<BPlusTreeLeafPage*>(new_page->GetData());
 
   page_leave_t->Init(page_id_l,INVALID_PAGE_ID,processor_.GetKeySize(),leaf_max_size_);
@@ -108,71 +157,32 @@ void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
   buffer_pool_manager_->UnpinPage(page_id_l,true);
 }
 
-/*
- * Insert constant key & value pair into leaf page
- * User needs to first find the right leaf page as insertion target, then look
- * through leaf page to see whether insert key exist or not. If exist, return
- * immediately, otherwise insert entry. Remember to deal with split if necessary.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
- */
-//先调用 FindLeafPage
-//Page* FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
-//观察是否已经存在，否则插入，如果太多则分裂节点
-//BPlusTreeInternalPage* Split(InternalPage *node, Txn *transaction)
-bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transaction) {
-  auto page_t = FindLeafPage(key,INVALID_PAGE_ID,false)->GetData();
-  auto leave_page_t = reinterpret_cast<BPlusTreeLeafPage*>(page_t);
-  RowId new_row;
-  if (leave_page_t->Lookup(key,new_row,processor_)){
-    buffer_pool_manager_->UnpinPage(leave_page_t->GetPageId(), false);
-    return false;
-  }
-  else{
-    leave_page_t->Insert(key,value,processor_);
-    if (leave_page_t->GetSize()>=leaf_max_size_){
-      auto next_leave=Split(leave_page_t,transaction);
-      InsertIntoParent(leave_page_t, next_leave->KeyAt(0), next_leave, transaction);
-    }
-    buffer_pool_manager_->UnpinPage(leave_page_t->GetPageId(), false);
-    return true;
-  }
-}
-
 /*
  * Split input page and return newly created page.
  * Using template N to represent either internal page or leaf page.
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
+ * The new page is returned pinned, the caller unpins it.
  */
 //开辟新叶，初始化它，搬运一半过去
-BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
+BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node) {
   page_id_t new_pageid;
-  auto new_page = buffer_pool_manager_->NewPage(new_pageid);
-  if (new_page == nullptr) {
-    throw("out of memory");
-  }
+  auto new_page = NewTreePage(new_pageid);
   auto internal_page_t = reinterpret_cast<BPlusTreeInternalPage*>(new_page->GetData());
   internal_page_t->Init(new_pageid,node->GetParentPageId(),processor_.GetKeySize(),internal_max_size_);
   node->MoveHalfTo(internal_page_t,buffer_pool_manager_);
-  
-  buffer_pool_manager_->UnpinPage(new_pageid,true);
   return internal_page_t;
 }
 
 //和上面几乎一样，注意设置nextpage指针
-BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
+BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node) {
   page_id_t new_pageid;
-  auto new_page = buffer_pool_manager_->NewPage(new_pageid);
-  if (new_page == nullptr) {
-    throw("out of memory");
-  }
+  auto new_page = NewTreePage(new_pageid);
   auto leave_page_t = reinterpret_cast<BPlusTreeLeafPage*>(new_page->GetData());
   leave_page_t->Init(new_pageid,node->GetParentPageId(),processor_.GetKeySize(),leaf_max_size_);
   node->MoveHalfTo(leave_page_t);
 
-  buffer_pool_manager_->UnpinPage(new_pageid,true);
   leave_page_t->SetNextPageId(node->GetNextPageId());
   node->SetNextPageId(new_pageid);
   return leave_page_t;
@@ -186,37 +196,126 @@ BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
  * User needs to first find the parent page of old_node, parent node must be
  * adjusted to take info of new_node into account. Remember to deal with split
  * recursively if necessary.
+ * old_node was not safe, so its parent (or root_latch_ if it is the root) is
+ * still write latched by this thread.
  */
-void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction) {
-  if (old_node->GetParentPageId()==INVALID_PAGE_ID){
+void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node) {
+  if (old_node->IsRootPage()){
     page_id_t new_page_l;
-    auto new_page = buffer_pool_manager_->NewPage(new_page_l);
-    if (new_page == nullptr) {
-      throw("out of memory");
-    }
+    auto new_page = NewTreePage(new_page_l);
     auto internal_page_t = reinterpret_cast<BPlusTreeInternalPage*>(new_page->GetData());
     internal_page_t->Init(new_page_l,INVALID_PAGE_ID,processor_.GetKeySize(),internal_max_size_);
     internal_page_t->PopulateNewRoot(old_node->GetPageId(),key,new_node->GetPageId());
     root_page_id_ = new_page_l;
     old_node->SetParentPageId(new_page_l);
     new_node->SetParentPageId(new_page_l);
-    UpdateRootPageId(0); 
+    UpdateRootPageId(0);
     buffer_pool_manager_->UnpinPage(new_page_l,true);
     return;
   }
-  else{
-    auto parent_page = buffer_pool_manager_->FetchPage(old_node->GetParentPageId());
-    auto internal_page_l = reinterpret_cast<BPlusTreeInternalPage*>(parent_page->GetData());
-    internal_page_l->InsertNodeAfter(old_node->GetPageId(),key,new_node->GetPageId());
-    if (internal_page_l->GetSize()>=internal_max_size_){
-      BPlusTreeInternalPage* new_internal_page = Split(internal_page_l,transaction);
-      InsertIntoParent(internal_page_l,new_internal_page->KeyAt(0),new_internal_page,transaction);
+  // 父节点分裂后 old_node 可能被移到新节点下，要先记下 pin 住的是哪一页
+  page_id_t parent_id = old_node->GetParentPageId();
+  auto parent_page = buffer_pool_manager_->FetchPage(parent_id);
+  auto internal_page_l = reinterpret_cast<BPlusTreeInternalPage*>(parent_page->GetData());
+  internal_page_l->InsertNodeAfter(old_node->GetPageId(),key,new_node->GetPageId());
+  if (internal_page_l->GetSize()>=internal_max_size_){
+    BPlusTreeInternalPage* new_internal_page = Split(internal_page_l);
+    InsertIntoParent(internal_page_l,new_internal_page->KeyAt(0),new_internal_page);
+    buffer_pool_manager_->UnpinPage(new_internal_page->GetPageId(),true);
+  }
+  buffer_pool_manager_->UnpinPage(parent_id,true);
+}
+
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+/*
+ * Build the tree from entries sorted by key, without duplicates, instead of
+ * inserting them one by one. Leaves are filled left to right from the
+ * entries and chained, then each internal level is built over the first keys
+ * of the level below until a single root is left. Every page is packed to
+ * fill_factor, but when that would leave pages at or below their min size,
+ * fewer and fuller pages are used instead: more than the min size when the
+ * capacity allows, and never less. So later inserts have room before a split
+ * and later removes do not coalesce right away.
+ * @return: false if the tree is not empty
+ */
+bool BPlusTree::BulkLoad(const std::vector<std::pair<GenericKey *, RowId>> &entries, double fill_factor,
+                         [[maybe_unused]] Txn *transaction) {
+  root_latch_.WLock();
+  bool empty = IsEmpty();
+  if (!empty || entries.empty()) {
+    root_latch_.WUnlock();
+    return empty;
+  }
+  // 下一层每页的页号和首键，作为上一层的键值对
+  std::vector<std::pair<page_id_t, GenericKey *>> level;
+  // 页面在 size 达到 max_size 时分裂，所以最多放 max_size - 1 个
+  size_t next_entry = 0;
+  LeafPage *prev_leaf = nullptr;
+  for (int leaf_size : PackPages(entries.size(), leaf_max_size_ - 1, leaf_max_size_ / 2, fill_factor)) {
+    page_id_t page_id;
+    auto new_page = NewTreePage(page_id);
+    auto leaf = reinterpret_cast<LeafPage *>(new_page->GetData());
+    leaf->Init(page_id, INVALID_PAGE_ID, processor_.GetKeySize(), leaf_max_size_);
+    level.emplace_back(page_id, entries[next_entry].first);
+    for (int i = 0; i < leaf_size; i++, next_entry++) {
+      leaf->SetKeyAt(i, entries[next_entry].first);
+      leaf->SetValueAt(i, entries[next_entry].second);
+    }
+    leaf->SetSize(leaf_size);
+    if (prev_leaf != nullptr) {
+      prev_leaf->SetNextPageId(page_id);
+      buffer_pool_manager_->UnpinPage(prev_leaf->GetPageId(), true);
+    }
+    prev_leaf = leaf;
+  }
+  buffer_pool_manager_->UnpinPage(prev_leaf->GetPageId(), true);
+
+  while (level.size() > 1) {
+    std::vector<std::pair<page_id_t, GenericKey *>> upper_level;
+    size_t next_child = 0;
+    int min_size = std::max(2, internal_max_size_ / 2);
+    for (int node_size : PackPages(level.size(), internal_max_size_ - 1, min_size, fill_factor)) {
+      page_id_t page_id;
+      auto new_page = NewTreePage(page_id);
+      auto internal = reinterpret_cast<InternalPage *>(new_page->GetData());
+      internal->Init(page_id, INVALID_PAGE_ID, processor_.GetKeySize(), internal_max_size_);
+      upper_level.emplace_back(page_id, level[next_child].second);
+      // 第 0 个键不参与查找；子节点在下一层建好时还不知道父亲，这里补上
+      for (int i = 0; i < node_size; i++, next_child++) {
+        internal->SetKeyAt(i, level[next_child].second);
+        internal->SetValueAt(i, level[next_child].first);
+        auto child = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(level[next_child].first)->GetData());
+        child->SetParentPageId(page_id);
+        buffer_pool_manager_->UnpinPage(level[next_child].first, true);
+      }
+      internal->SetSize(node_size);
+      buffer_pool_manager_->UnpinPage(page_id, true);
     }
-    buffer_pool_manager_->UnpinPage(old_node->GetParentPageId(),true);
+    level = std::move(upper_level);
   }
+  root_page_id_ = level[0].first;
+  UpdateRootPageId(1);
+  root_latch_.WUnlock();
+  return true;
+}
 
+std::vector<int> BPlusTree::PackPages(int count, int capacity, int min_size, double fill_factor) {
+  int per_page = std::max(min_size, static_cast<int>(capacity * fill_factor));
+  per_page = std::max(1, std::min(per_page, capacity));
+  int pages = (count + per_page - 1) / per_page;
+  if (pages > 1 && count / pages <= min_size) {
+    // 按填充率分出的页太空，删一个就要合并；减少页数让每页多于 min_size，但不超过容量
+    pages = std::max(count / (min_size + 1), (count + capacity - 1) / capacity);
+  }
+  // 平均分配，避免最后一页过空
+  std::vector<int> sizes(pages, count / pages);
+  for (int i = 0; i < count % pages; i++) {
+    sizes[i]++;
+  }
+  return sizes;
 }
-//BPlusTreeInternalPage* Split(InternalPage *node, Txn *transaction)
 
 /*****************************************************************************
  * REMOVE
@@ -224,145 +323,86 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
 /*
  * Delete key & value pair associated with input key
  * If current tree is empty, return immediately.
- * If not, User needs to first find the right leaf page as deletion target, then
- * delete entry from leaf page. Remember to deal with redistribute or merge if
- * necessary.
- * 
-删除与输入的 key 相关联的键值对。
-
-如果当前 B+树是空的，直接返回。
-
-如果不是空树，用户需要：
-
-先找到正确的叶子节点（即要删除的目标叶子页）；
-
-在叶子节点中删除对应的 key-value 键值对；
-
-注意，如果删除后导致节点大小小于最小要求（比如不满足半满条件）：
-
-需要考虑**重新分配（Redistribute）**或者
-
-**合并（Merge）**节点，以保证 B+树的平衡性。
+ * If not, first try the optimistic path: write latch only the leaf and delete
+ * there if it does not underflow. Otherwise start over on the pessimistic
+ * path, which redistributes or merges as necessary.
  */
 void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {
-  if (IsEmpty()){
+  Page *page = CrabToLeaf(key, false, true);
+  if (page == nullptr) {
     return;
   }
-  Page* new_Page;
-  new_Page = FindLeafPage(key);
-  BPlusTreeLeafPage* page_leave_l = reinterpret_cast<BPlusTreeLeafPage*>(new_Page->GetData());
-  page_id_t leave_id_l = page_leave_l->GetPageId();
-  if (page_leave_l->KeyAt(0) == key && page_leave_l->GetParentPageId()!=INVALID_PAGE_ID){
-    page_id_t parent_id_l = page_leave_l -> GetParentPageId();
-    BPlusTreeInternalPage* internal_page_l = reinterpret_cast<BPlusTreeInternalPage*>(buffer_pool_manager_->FetchPage(parent_id_l)->GetData());
-    if (!(internal_page_l-> ValueAt(0)==leave_id_l)){
-      int key_index_at_parent = internal_page_l->ValueIndex(leave_id_l);
-      GenericKey* old_key = internal_page_l->KeyAt(key_index_at_parent);
-      memcpy(old_key,key,sizeof(GenericKey));
-      bool flag = false;
-      while(internal_page_l->KeyAt(0) == key && internal_page_l->GetParentPageId()!=INVALID_PAGE_ID){
-        page_id_t new_internal_id_l = internal_page_l -> GetParentPageId();
-        BPlusTreeInternalPage* new_internal_page_l = reinterpret_cast<BPlusTreeInternalPage*>(buffer_pool_manager_->FetchPage(new_internal_id_l)->GetData());
-        if (!(new_internal_page_l->ValueAt(0)==internal_page_l->GetPageId())){
-          int key_index_at_parent_1 = new_internal_page_l->ValueIndex(internal_page_l->GetPageId());
-          GenericKey* old_key_1 = new_internal_page_l -> KeyAt(key_index_at_parent_1);
-          memcpy(old_key_1,key,sizeof(GenericKey));
-          internal_page_l = new_internal_page_l;
-          buffer_pool_manager_->UnpinPage(new_internal_page_l->GetPageId(),true);
-        }
-        else{
-          buffer_pool_manager_->UnpinPage(new_internal_page_l->GetPageId(),true);
-          break;
-        } 
-      }
-      buffer_pool_manager_->UnpinPage(parent_id_l,true);
-    }
-    else{
-      buffer_pool_manager_->UnpinPage(parent_id_l,false);
-    }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  RowId value;
+  if (!leaf->Lookup(key, value, processor_)) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    return;
   }
-  int size_l = page_leave_l->RemoveAndDeleteRecord(key,processor_);
-  if (size_l < page_leave_l->GetMinSize()){
-    CoalesceOrRedistribute(page_leave_l,transaction);
+  if (IsSafe(leaf, Operation::kRemove)) {
+    // 叶子第一个键被删掉时不必改父节点：父节点中的分隔键仍然不大于该叶子剩下的键
+    leaf->RemoveAndDeleteRecord(key, processor_);
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+    return;
   }
-  page_id_t index_page = page_leave_l->GetPageId();
-  buffer_pool_manager_->UnpinPage(index_page,true);
-  if (page_leave_l->GetSize()==0){
-    buffer_pool_manager_->DeletePage(page_leave_l->GetPageId());
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  RemovePessimistic(key);
+}
+
+void BPlusTree::RemovePessimistic(const GenericKey *key) {
+  WriteSet write_set;
+  root_latch_.WLock();
+  write_set.root_locked_ = true;
+  if (IsEmpty()) {
+    ReleaseWriteSet(write_set);
     return;
   }
+  CrabToLeafForWrite(key, Operation::kRemove, write_set);
+  auto leaf = reinterpret_cast<LeafPage *>(write_set.pages_.back()->GetData());
+  int old_size = leaf->GetSize();
+  if (leaf->RemoveAndDeleteRecord(key, processor_) != old_size) {
+    if (leaf->IsRootPage() ? leaf->GetSize() == 0 : leaf->GetSize() < leaf->GetMinSize()) {
+      CoalesceOrRedistribute(leaf, write_set);
+    }
+  }
+  ReleaseWriteSet(write_set);
 }
 
-/* todo
+/*
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
  * Using template N to represent either internal page or leaf page.
- * @return: true means target leaf page should be deleted, false means no
- * deletion happens
- * 
- 用户首先需要找到当前节点（node）对应的兄弟节点（邻居节点）。
-
-然后判断：
-
-如果兄弟节点的大小 + 当前节点的大小 > 节点最大容量（MaxSize）：
-
-那么**执行重分配（Redistribute）**操作（从兄弟节点借一部分过来）。
-
-否则：
-
-**执行合并（Merge）**操作（把当前节点和兄弟节点合并成一个）。
+ * node is not safe, so its parent is write latched by this thread; the sibling
+ * is latched here. A leaf page holds at most max size - 1 entries and an
+ * internal page max size - 1 children, as they split when they reach max size.
  */
+// 左兄弟优先；node 是最左孩子时用右兄弟
 template <typename N>
-bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
+void BPlusTree::CoalesceOrRedistribute(N *node, WriteSet &write_set) {
   if (node->IsRootPage()){
-    return AdjustRoot(node);
-  }
-  int this_page_size = node->GetSize();
-  page_id_t page_id_l = node->GetPageId();
-  page_id_t parent_internal_id = node->GetParentPageId();
-  BPlusTreeInternalPage* parent_page_l = reinterpret_cast<BPlusTreeInternalPage*>(buffer_pool_manager_->FetchPage(parent_internal_id)->GetData());
-  int index_at_parent = parent_page_l->ValueIndex(page_id_l);
-
-  if (index_at_parent!=0){
-    page_id_t left_neighbor_id = parent_page_l->ValueAt(index_at_parent-1);
-    N* left_neighbor_page = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(left_neighbor_id)->GetData());
-    int left_page_size = left_neighbor_page->GetSize();
-    if (this_page_size + left_page_size > left_neighbor_page->GetMaxSize()){
-      Redistribute(left_neighbor_page,node,1);
-      buffer_pool_manager_->UnpinPage(left_neighbor_id,true);
-      buffer_pool_manager_->UnpinPage(parent_internal_id,true);
-      return true;
-    }
-  }
-  if (index_at_parent!=parent_page_l->GetSize()-1){
-    page_id_t right_neighbor_id = parent_page_l->ValueAt(index_at_parent+1);
-    N* right_neighbor_page = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(right_neighbor_id)->GetData());
-    int right_page_size = right_neighbor_page->GetSize();
-    if (right_page_size + this_page_size > right_neighbor_page->GetMaxSize()){
-      Redistribute(right_neighbor_page,node,0);
-      buffer_pool_manager_->UnpinPage(right_neighbor_id,true);
-      buffer_pool_manager_->UnpinPage(parent_internal_id,true);
-      return true;
-    }
-  }
-  if (index_at_parent>0){
-    page_id_t left_neighbor_id = parent_page_l->ValueAt(index_at_parent-1);
-    N* left_neighbor_page = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(left_neighbor_id)->GetData());
-    int left_page_size = left_neighbor_page->GetSize();
-    Coalesce(left_neighbor_page,node,parent_page_l,index_at_parent,transaction);
-    buffer_pool_manager_->UnpinPage(left_neighbor_id,true);
-    buffer_pool_manager_->UnpinPage(parent_internal_id,true);
-    return true;
+    AdjustRoot(node, write_set);
+    return;
   }
-  else{
-    page_id_t  right_neighbor_id= parent_page_l->ValueAt(index_at_parent+1);
-    N* right_neighbor_page = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(right_neighbor_id)->GetData());
-    Coalesce(node,right_neighbor_page,parent_page_l,index_at_parent,transaction);
-    buffer_pool_manager_->UnpinPage(parent_internal_id,true);
-    buffer_pool_manager_->UnpinPage(right_neighbor_id,true);
-    return true;
+  page_id_t parent_id = node->GetParentPageId();
+  auto parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(parent_id)->GetData());
+  int index = parent->ValueIndex(node->GetPageId());
+  page_id_t sibling_id = parent->ValueAt(index == 0 ? 1 : index - 1);
+  Page *sibling_page = buffer_pool_manager_->FetchPage(sibling_id);
+  sibling_page->WLatch();
+  auto sibling = reinterpret_cast<N *>(sibling_page->GetData());
+  if (sibling->GetSize() + node->GetSize() >= node->GetMaxSize()) {
+    Redistribute(sibling, node, parent, index == 0 ? 0 : 1);
+  } else if (index == 0) {
+    // 把右兄弟并到 node 里
+    Coalesce(node, sibling, parent, 1, write_set);
+  } else {
+    Coalesce(sibling, node, parent, index, write_set);
   }
-  return false;
+  sibling_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(sibling_id, true);
+  buffer_pool_manager_->UnpinPage(parent_id, true);
 }
 
 /*
@@ -370,45 +410,30 @@ bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
  * buffer pool manager to delete this page. Parent page must be adjusted to
  * take info of deletion into account. Remember to deal with coalesce or
  * redistribute recursively if necessary.
- * Using template N to represent either internal page or leaf page.
- * @param   neighbor_node      sibling page of input "node"
- * @param   node               input from method coalesceOrRedistribute()
- * @param   parent             parent page of input "node"
- * @return  true means parent node should be deleted, false means no deletion happened
- 将一个节点（node）的所有键值对全部移动到它的兄弟节点（neighbor_node）中。
-
-然后，通知缓冲池管理器（BufferPoolManager），删除当前节点（即 node 页）。
-
-同时，需要修改父节点（parent）以反映这次合并产生的变化：
-
-父节点中需要删除指向被删节点（node）的记录。
-
-注意：如果父节点因为这次删除也变得太小（比如不再满足最小大小要求），
-
-则需要递归地对父节点继续执行合并（Coalesce）或重分配（Redistribute）。
+ * @param   neighbor_node      left sibling that receives the pairs
+ * @param   node               right page, emptied and deleted
+ * @param   parent             parent page of both
+ * @param   index              index of node in parent
+ * The emptied page is deleted in ReleaseWriteSet, once nobody here holds it.
  */
-bool BPlusTree::Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index,
-                         Txn *transaction) {
-  page_id_t node_index = node->GetPageId();
+void BPlusTree::Coalesce(LeafPage *neighbor_node, LeafPage *node, InternalPage *parent, int index,
+                         WriteSet &write_set) {
   node->MoveAllTo(neighbor_node);
-
-  parent->Remove(parent->ValueIndex(node_index));
-  if (parent->GetSize()<parent->GetMinSize()){
-    return CoalesceOrRedistribute<BPlusTree::InternalPage>(parent,transaction);
+  write_set.deleted_pages_.push_back(node->GetPageId());
+  parent->Remove(index);
+  if (parent->IsRootPage() ? parent->GetSize() == 1 : parent->GetSize() < parent->GetMinSize()) {
+    CoalesceOrRedistribute(parent, write_set);
   }
-  return true;
 }
 
-bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
-                         Txn *transaction) {
-  page_id_t node_index = node->GetPageId();
-  node->MoveAllTo(neighbor_node,parent->KeyAt(index),buffer_pool_manager_);
-
-  parent->Remove(parent->ValueIndex(node_index));
-  if (parent->GetSize()<parent->GetMinSize()){
-    return CoalesceOrRedistribute<BPlusTree::InternalPage>(parent,transaction);
+void BPlusTree::Coalesce(InternalPage *neighbor_node, InternalPage *node, InternalPage *parent, int index,
+                         WriteSet &write_set) {
+  node->MoveAllTo(neighbor_node, parent->KeyAt(index), buffer_pool_manager_);
+  write_set.deleted_pages_.push_back(node->GetPageId());
+  parent->Remove(index);
+  if (parent->IsRootPage() ? parent->GetSize() == 1 : parent->GetSize() < parent->GetMinSize()) {
+    CoalesceOrRedistribute(parent, write_set);
   }
-  return true;
 }
 
 /*
@@ -416,77 +441,39 @@ bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, Inte
  * 0, move sibling page's first key & value pair into end of input "node",
  * otherwise move sibling page's last key & value pair into head of input
  * "node".
- * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
- 将键值对（key & value）从兄弟节点（neighbor_node）移动到当前节点（node），以重新平衡两个节点的大小。
-
-根据 index 参数的不同：
-
-如果 index == 0：
-
-表示当前节点（node）在左边，兄弟节点在右边；
-
-从兄弟节点的第一个键值对拿过来，插入到当前节点的末尾。
-
-如果 index != 0：
-
-表示当前节点在右边，兄弟节点在左边；
-
-从兄弟节点的最后一个键值对拿过来，插入到当前节点的开头。
-
-使用模板 N 来泛化节点类型，可以是：
-
-叶子节点（LeafPage）
-
-或者内部节点（InternalPage）
+ * @param   parent             parent page of both
+ * 父节点中右边那页的分隔键要随之更新
  */
-void BPlusTree::Redistribute(LeafPage *neighbor_node, LeafPage *node, int index) {
+void BPlusTree::Redistribute(LeafPage *neighbor_node, LeafPage *node, InternalPage *parent, int index) {
   if (index == 0){
     neighbor_node->MoveFirstToEndOf(node);
-    page_id_t page_id_parent = node->GetParentPageId();
-    auto fetch_page_l = buffer_pool_manager_->FetchPage(page_id_parent);
-    auto parent_internal_page = reinterpret_cast<BPlusTreeInternalPage*>(fetch_page_l->GetData());
-
-    GenericKey* used_key = neighbor_node->KeyAt(0);
-    int index_at_parent = parent_internal_page->ValueIndex(neighbor_node->GetPageId());
-    parent_internal_page->SetKeyAt(index_at_parent,used_key);
-
-    buffer_pool_manager_->UnpinPage(page_id_parent,true);
+    parent->SetKeyAt(parent->ValueIndex(neighbor_node->GetPageId()), neighbor_node->KeyAt(0));
   }
   else{
     neighbor_node->MoveLastToFrontOf(node);
-    page_id_t page_id_parent = node->GetParentPageId();
-    auto fetch_page_l = buffer_pool_manager_->FetchPage(page_id_parent);
-    auto parent_internal_page = reinterpret_cast<BPlusTreeInternalPage*>(fetch_page_l->GetData());
-
-    GenericKey* used_key = node->KeyAt(0);
-    int index_at_parent = parent_internal_page->ValueIndex(node->GetPageId());
-    parent_internal_page->SetKeyAt(index_at_parent,used_key);
-
-    buffer_pool_manager_->UnpinPage(page_id_parent,true);
+    parent->SetKeyAt(parent->ValueIndex(node->GetPageId()), node->KeyAt(0));
   }
 }
-void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, int index) {
-  page_id_t page_id_parent = node->GetParentPageId();
-  auto fetch_page_l = buffer_pool_manager_->FetchPage(page_id_parent);
-  auto parent_internal_page = reinterpret_cast<BPlusTreeInternalPage*>(fetch_page_l->GetData());
 
-  page_id_t neighbor_node_index = neighbor_node->GetPageId();
+void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, InternalPage *parent, int index) {
   if (index == 0){
-    // 不必fetch子节点以获取key,父节点已经有key了
-    int neighbor_index_at_parent = parent_internal_page->ValueIndex(neighbor_node_index);
-    GenericKey* used_key = parent_internal_page->KeyAt(neighbor_index_at_parent);
-    neighbor_node->MoveFirstToEndOf(node,used_key,buffer_pool_manager_);
-    parent_internal_page->SetKeyAt(neighbor_index_at_parent,neighbor_node->KeyAt(0));
+    // 父节点的分隔键下移到 node 末尾，右兄弟剩下的第一个键上移
+    int neighbor_index = parent->ValueIndex(neighbor_node->GetPageId());
+    neighbor_node->MoveFirstToEndOf(node, parent->KeyAt(neighbor_index), buffer_pool_manager_);
+    parent->SetKeyAt(neighbor_index, neighbor_node->KeyAt(0));
   }
   else{
-    int node_index_at_parent = parent_internal_page->ValueIndex(node->GetPageId());
-    GenericKey* used_key = neighbor_node->KeyAt(neighbor_node->GetSize()-1);
-    neighbor_node->MoveLastToFrontOf(node,parent_internal_page->KeyAt(node_index_at_parent),buffer_pool_manager_);
-    parent_internal_page->SetKeyAt(node_index_at_parent,used_key);
+    // 左兄弟的最后一个键上移，先拷出来，移动后那一格就不属于它了
+    int node_index = parent->ValueIndex(node->GetPageId());
+    std::vector<char> up_key(processor_.GetKeySize());
+    memcpy(up_key.data(), neighbor_node->KeyAt(neighbor_node->GetSize() - 1), processor_.GetKeySize());
+    neighbor_node->MoveLastToFrontOf(node, parent->KeyAt(node_index), buffer_pool_manager_);
+    parent->SetKeyAt(node_index, reinterpret_cast<GenericKey *>(up_key.data()));
   }
 }
+
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -494,36 +481,23 @@ void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, in
  * case 1: when you delete the last element in root page, but root page still
  * has one last child
  * case 2: when you delete the last element in whole b+ tree
- * @return : true means root page should be deleted, false means no deletion
- * happened
- * 情况1：
-
-当你删除了根节点中最后一个元素，但根节点还有最后一个子节点存在时：
-
-需要把根节点指向它的唯一子节点，并更新根页的指向（root page id）。
-
-情况2：
-
-当你删除了整棵B+树的最后一个元素，即整棵树都空了，
-
-那么就应该把根节点也删掉，整棵树成为空树。
+ * The root is not safe here, so root_latch_ is held exclusively.
  */
-bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
+void BPlusTree::AdjustRoot(BPlusTreePage *old_root_node, WriteSet &write_set) {
   if (old_root_node->IsLeafPage()){
-    auto leave_page_l = reinterpret_cast<BPlusTreeLeafPage*>(old_root_node);
-    if (leave_page_l->GetSize()==0){
-      auto root_index_page = reinterpret_cast<IndexRootsPage*>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID));
-      root_index_page->Delete(index_id_);
+    if (old_root_node->GetSize()==0){
       root_page_id_ = INVALID_PAGE_ID;
-      buffer_pool_manager_->UnpinPage(leave_page_l->GetPageId(),false);
-      buffer_pool_manager_->DeletePage(leave_page_l->GetPageId());
+      auto root_index_page = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
+      root_index_page->WLatch();
+      reinterpret_cast<IndexRootsPage *>(root_index_page->GetData())->Delete(index_id_);
+      root_index_page->WUnlatch();
       buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID,true);
-      return true;
+      write_set.deleted_pages_.push_back(old_root_node->GetPageId());
     }
   }
-  else if (!old_root_node->IsLeafPage()&&old_root_node->GetSize()==1){
+  else if (old_root_node->GetSize()==1){
     auto root_internal_page = reinterpret_cast<BPlusTreeInternalPage*>(old_root_node);
-    page_id_t child_page_id = root_internal_page->ValueAt(0);
+    page_id_t child_page_id = root_internal_page->RemoveAndReturnOnlyChild();
     root_page_id_ = child_page_id;
 
     auto child_page_l =reinterpret_cast<BPlusTreePage*>(buffer_pool_manager_->FetchPage(child_page_id)->GetData());
@@ -531,13 +505,7 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
     buffer_pool_manager_->UnpinPage(child_page_id,true);
 
     UpdateRootPageId(0);
-    buffer_pool_manager_->UnpinPage(old_root_node->GetPageId(),false);
-    buffer_pool_manager_->DeletePage(old_root_node->GetPageId());
-
-    return true;
-  }
-  else{
-    return false;
+    write_set.deleted_pages_.push_back(old_root_node->GetPageId());
   }
 }
 
@@ -548,14 +516,15 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
  * Input parameter is void, find the left most leaf page first, then construct
  * index iterator
  * @return : index iterator
- * 需要首先找到最左边的叶子页（也就是整棵树中最小的元素所在的页）。
-
-然后构造一个索引迭代器（IndexIterator），让它从最小的键开始遍历。
  */
 IndexIterator BPlusTree::Begin() {
-  GenericKey* null_key;
-  BPlusTreeLeafPage* first_leave_page = reinterpret_cast<BPlusTreeLeafPage*>((FindLeafPage(null_key,INVALID_PAGE_ID,true))->GetData());
-  page_id_t first_leave_id = first_leave_page->GetPageId();
+  Page *page = FindLeafPage(nullptr, INVALID_PAGE_ID, true);
+  if (page == nullptr) {
+    return End();
+  }
+  page_id_t first_leave_id = page->GetPageId();
+  // FindLeafPage 返回的页是 pin 住的，迭代器会自己再 pin 一次
+  buffer_pool_manager_->UnpinPage(first_leave_id, false);
 
   return IndexIterator(first_leave_id,buffer_pool_manager_);
 }
@@ -564,31 +533,86 @@ IndexIterator BPlusTree::Begin() {
  * Input parameter is low key, find the leaf page that contains the input key
  * first, then construct index iterator
  * @return : index iterator
- * 输入参数：一个下界的 key（也叫 low key）。
-
-需要首先找到包含这个 key 的叶子页。
-
-然后从这个 key 开始构造一个索引迭代器。
  */
 IndexIterator BPlusTree::Begin(const GenericKey *key) {
-  BPlusTreeLeafPage* des_leave_page = reinterpret_cast<BPlusTreeLeafPage*>((FindLeafPage(key,INVALID_PAGE_ID,false))->GetData());
+  Page *page = CrabToLeaf(key, false, false);
+  if (page == nullptr) {
+    return End();
+  }
+  auto des_leave_page = reinterpret_cast<BPlusTreeLeafPage*>(page->GetData());
   page_id_t des_leave_id = des_leave_page->GetPageId();
-  
-  return IndexIterator(des_leave_id,buffer_pool_manager_,des_leave_page->KeyIndex(key,processor_));
+  int key_index = des_leave_page->KeyIndex(key,processor_);
+  // key 比叶子里所有键都大时，从下一个叶子的第一个键开始
+  page_id_t next_leave_id = des_leave_page->GetNextPageId();
+  bool past_end = key_index == des_leave_page->GetSize();
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(des_leave_id, false);
+
+  if (past_end) {
+    return next_leave_id == INVALID_PAGE_ID ? End() : IndexIterator(next_leave_id, buffer_pool_manager_);
+  }
+  return IndexIterator(des_leave_id,buffer_pool_manager_,key_index);
 }
 
 /*
  * Input parameter is void, construct an index iterator representing the end
  * of the key/value pair in the leaf node
  * @return : index iterator
- * 构造一个表示B+树中键值对末尾（即遍历结束位置）的索引迭代器（IndexIterator）。
-
-这个迭代器用于指示遍历完成，比如在循环中作为终止条件。
  */
 IndexIterator BPlusTree::End() {
   return IndexIterator();
 }
 
+/*
+ * 横向走到下一个叶子时先拿下一个叶子的读锁再放当前叶子。合并的写者已持有一个叶子的写锁、再等它左边
+ * 的兄弟，所以这里只能试着加锁；拿不到就全部放掉，让出 CPU 后从根重新找 from 所在的叶子
+ */
+bool BPlusTree::ScanLeaf(const GenericKey *from, bool inclusive,
+                         const std::function<bool(const GenericKey *key, RowId value)> &visit) {
+  while (true) {
+    Page *page = CrabToLeaf(from, false, false);
+    if (page == nullptr) {
+      return false;
+    }
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    int index = leaf->KeyIndex(from, processor_);
+    if (!inclusive && index < leaf->GetSize() && processor_.CompareKeys(leaf->KeyAt(index), from) == 0) {
+      index++;
+    }
+    bool blocked = false;
+    while (index == leaf->GetSize()) {
+      page_id_t next_id = leaf->GetNextPageId();
+      if (next_id == INVALID_PAGE_ID) {
+        page->RUnlatch();
+        buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+        return false;
+      }
+      Page *next = buffer_pool_manager_->FetchPage(next_id);
+      blocked = !next->TryRLatch();
+      if (blocked) {
+        buffer_pool_manager_->UnpinPage(next_id, false);
+        break;
+      }
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      page = next;
+      leaf = reinterpret_cast<LeafPage *>(page->GetData());
+      index = 0;
+    }
+    if (!blocked) {
+      while (index < leaf->GetSize() && visit(leaf->KeyAt(index), leaf->ValueAt(index))) {
+        index++;
+      }
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (!blocked) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+}
+
 /*****************************************************************************
  * UTILITIES AND DEBUG
  *****************************************************************************/
@@ -597,28 +621,124 @@ IndexIterator BPlusTree::End() {
  * the left most leaf page
  * Note: the leaf page is pinned, you need to unpin it after use.
  */
-//先把根节点fetch过来，->data之后转化成B_plus_tree_page
-//然后不断向下寻找，注意每循环一次要unpin一次上次打开的page
-//注意leftmost
 Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
-  if (IsEmpty())return nullptr;
-  auto tree_page_t = reinterpret_cast<BPlusTreePage*>((buffer_pool_manager_->FetchPage(root_page_id_))->GetData());
-  
-  page_id_t value_t = root_page_id_;
-  while (!tree_page_t->IsLeafPage()){
-    buffer_pool_manager_->UnpinPage(value_t,false);
-    auto tree_internal_t = reinterpret_cast<BPlusTreeInternalPage*>(tree_page_t);
-    if (!leftMost){
-      value_t = tree_internal_t->Lookup(key,processor_);
+  Page *page = CrabToLeaf(key, leftMost, false);
+  if (page != nullptr) {
+    page->RUnlatch();
+  }
+  return page;
+}
+
+/*
+ * 持有父节点的读锁时换子节点的锁是安全的：改变子节点结构的悲观操作必须先拿到父节点的写锁，
+ * 根节点则由 root_latch_ 保护
+ */
+Page *BPlusTree::CrabToLeaf(const GenericKey *key, bool leftMost, bool write_leaf) {
+  root_latch_.RLock();
+  if (IsEmpty()) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
+  page->RLatch();
+  if (write_leaf && reinterpret_cast<BPlusTreePage *>(page->GetData())->IsLeafPage()) {
+    page->RUnlatch();
+    page->WLatch();
+  }
+  root_latch_.RUnlock();
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    page_id_t child_id = leftMost ? internal->ValueAt(0) : internal->Lookup(key, processor_);
+    Page *child = buffer_pool_manager_->FetchPage(child_id);
+    child->RLatch();
+    if (write_leaf && reinterpret_cast<BPlusTreePage *>(child->GetData())->IsLeafPage()) {
+      child->RUnlatch();
+      child->WLatch();
     }
-    else{
-      value_t = tree_internal_t->ValueAt(0);
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  return page;
+}
+
+void BPlusTree::CrabToLeafForWrite(const GenericKey *key, Operation op, WriteSet &write_set) {
+  page_id_t page_id = root_page_id_;
+  while (true) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    page->WLatch();
+    write_set.pages_.push_back(page);
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op)) {
+      ReleaseAncestors(write_set);
     }
-    tree_page_t = reinterpret_cast<BPlusTreePage*>((buffer_pool_manager_->FetchPage(value_t))->GetData());
+    if (node->IsLeafPage()) {
+      return;
+    }
+    page_id = reinterpret_cast<InternalPage *>(node)->Lookup(key, processor_);
+  }
+}
+
+bool BPlusTree::IsSafe(BPlusTreePage *node, Operation op) {
+  if (op == Operation::kInsert) {
+    return node->GetSize() + 1 < node->GetMaxSize();
+  }
+  if (node->IsRootPage()) {
+    // 根叶子删空、根内部节点只剩一个孩子时都要换根
+    return node->GetSize() > (node->IsLeafPage() ? 1 : 2);
+  }
+  return node->GetSize() > node->GetMinSize();
+}
+
+void BPlusTree::ReleaseAncestors(WriteSet &write_set) {
+  if (write_set.root_locked_) {
+    root_latch_.WUnlock();
+    write_set.root_locked_ = false;
+  }
+  while (write_set.pages_.size() > 1) {
+    Page *page = write_set.pages_.front();
+    write_set.pages_.pop_front();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+}
+
+void BPlusTree::ReleaseWriteSet(WriteSet &write_set) {
+  for (Page *page : write_set.pages_) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  }
+  write_set.pages_.clear();
+  if (write_set.root_locked_) {
+    root_latch_.WUnlock();
+    write_set.root_locked_ = false;
   }
-  auto ans = buffer_pool_manager_->FetchPage(value_t);
-  buffer_pool_manager_->UnpinPage(value_t,false);
-  return ans;
+  DeletePages(write_set.deleted_pages_);
+  write_set.deleted_pages_.clear();
+}
+
+Page *BPlusTree::NewTreePage(page_id_t &page_id) {
+  std::scoped_lock<std::mutex> lock(extent_latch_);
+  auto new_page = buffer_pool_manager_->NewPage(page_id, &extent_);
+  if (new_page == nullptr) {
+    throw("out of memory");
+  }
+  return new_page;
+}
+
+/*
+ * 合并掉的页可能还被游标或迭代器 pin 着，这时 DeletePage 会失败；先记下，等下次有页被删时再试
+ */
+void BPlusTree::DeletePages(const std::vector<page_id_t> &page_ids) {
+  std::scoped_lock<std::mutex> lock(extent_latch_);
+  pending_deletes_.insert(pending_deletes_.end(), page_ids.begin(), page_ids.end());
+  pending_deletes_.erase(std::remove_if(pending_deletes_.begin(), pending_deletes_.end(),
+                                        [this](page_id_t page_id) {
+                                          return buffer_pool_manager_->DeletePage(page_id);
+                                        }),
+                         pending_deletes_.end());
 }
 
 /*
@@ -630,15 +750,18 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
  * updating it.
  */
 // 改变 root-index 键值对 类，根据insert record 来决定是
-// 插入还是更新
+// 插入还是更新；各索引共用这一页，所以要加写锁
 void BPlusTree::UpdateRootPageId(int insert_record) {
-  auto root_index_t = reinterpret_cast<IndexRootsPage*>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID));
+  auto root_index_page = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
+  root_index_page->WLatch();
+  auto root_index_t = reinterpret_cast<IndexRootsPage*>(root_index_page->GetData());
   if (insert_record){
     root_index_t->Insert(index_id_,root_page_id_);
   }
   else{
     root_index_t->Update(index_id_,root_page_id_);
   }
+  root_index_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID,true);
 }
 
@@ -1,17 +1,32 @@
 #include "index/b_plus_tree_index.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "index/generic_key.h"
 #include "utils/tree_file_mgr.h"
 BPlusTreeIndex::BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
-                               BufferPoolManager *buffer_pool_manager)
-    : Index(index_id, key_schema),
-      processor_(key_schema_, key_size),
+                               BufferPoolManager *buffer_pool_manager, bool unique)
+    : Index(index_id, key_schema, unique),
+      processor_(key_schema_, key_size, !unique),
       container_(index_id, buffer_pool_manager, processor_) {}
 
+bool BPlusTreeIndex::EncodeKey(GenericKey *index_key, const Row &key, RowId row_id) {
+  bool fits = processor_.SerializeFromKey(index_key, key, key_schema_);
+  if (!unique_) {
+    // 键相同的行靠 RowId 区分，树里的每个键仍然唯一
+    processor_.SetRowId(index_key, row_id);
+  }
+  return fits;
+}
+
 dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
   // ASSERT(row_id.Get() != INVALID_ROWID.Get(), "Invalid row id for index insert.");
   GenericKey *index_key = processor_.InitKey();
-  processor_.SerializeFromKey(index_key, key, key_schema_);
+  if (!EncodeKey(index_key, key, row_id)) {
+    free(index_key);
+    return DB_KEY_TOO_LONG;
+  }
 
   bool status = container_.Insert(index_key, row_id, txn);
   free(index_key);
@@ -28,7 +43,7 @@ dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
 
 dberr_t BPlusTreeIndex::RemoveEntry(const Row &key, RowId row_id, Txn *txn) {
   GenericKey *index_key = processor_.InitKey();
-  processor_.SerializeFromKey(index_key, key, key_schema_);
+  EncodeKey(index_key, key, row_id);
 
   container_.Remove(index_key, txn);
   free(index_key);
@@ -36,48 +51,70 @@ dberr_t BPlusTreeIndex::RemoveEntry(const Row &key, RowId row_id, Txn *txn) {
 }
 
 dberr_t BPlusTreeIndex::ScanKey(const Row &key, vector<RowId> &result, Txn *txn, string compare_operator) {
-  GenericKey *index_key = processor_.InitKey();
-  processor_.SerializeFromKey(index_key, key, key_schema_);
-  auto end_iter = GetEndIterator();
+  Row open;
   if (compare_operator == "=") {
-    container_.GetValue(index_key, result, txn);
+    ScanRange(key, true, key, true, result, txn);
   } else if (compare_operator == ">") {
-    auto iter = GetBeginIterator(index_key);
-    if (container_.GetValue(index_key, result, txn)) ++iter;
-    result.clear();
-    for (; iter != end_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
+    ScanRange(key, false, open, true, result, txn);
   } else if (compare_operator == ">=") {
-    for (auto iter = GetBeginIterator(index_key); iter != end_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
+    ScanRange(key, true, open, true, result, txn);
   } else if (compare_operator == "<") {
-    auto stop_iter = GetBeginIterator(index_key);
-    for (auto iter = GetBeginIterator(); iter != stop_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
+    ScanRange(open, true, key, false, result, txn);
   } else if (compare_operator == "<=") {
-    auto stop_iter = GetBeginIterator(index_key);
-    for (auto iter = GetBeginIterator(); iter != stop_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
-    container_.GetValue(index_key, result, txn);
+    ScanRange(open, true, key, true, result, txn);
   } else if (compare_operator == "<>") {
-    for (auto iter = GetBeginIterator(); iter != end_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
-    vector<RowId> temp;
-    if (container_.GetValue(index_key, temp, txn))
-      result.erase(find(result.begin(), result.end(), temp[0]));
+    ScanRange(open, true, key, false, result, txn);
+    ScanRange(key, false, open, true, result, txn);
   }
-  free(index_key);
   if (!result.empty())
     return DB_SUCCESS;
   else
     return DB_KEY_NOT_FOUND;
 }
 
+std::unique_ptr<IndexCursor> BPlusTreeIndex::OpenCursor(const Row &start, bool start_inclusive, const Row &stop,
+                                                        bool stop_inclusive, [[maybe_unused]] Txn *txn) {
+  return std::make_unique<BPlusTreeIndexCursor>(this, start, start_inclusive, stop, stop_inclusive);
+}
+
+dberr_t BPlusTreeIndex::BulkLoad(const std::function<bool(Row &key, RowId &row_id)> &next, Txn *txn,
+                                 double fill_factor) {
+  if (!container_.IsEmpty()) {
+    return Index::BulkLoad(next, txn, fill_factor);
+  }
+  // 编码后的键定长，连续存放在一块缓冲区里，排序只交换指针
+  int key_size = processor_.GetKeySize();
+  std::vector<char> key_buf;
+  std::vector<RowId> row_ids;
+  Row key;
+  RowId row_id;
+  while (next(key, row_id)) {
+    key_buf.resize(key_buf.size() + key_size);
+    if (!EncodeKey(reinterpret_cast<GenericKey *>(key_buf.data() + key_buf.size() - key_size), key, row_id)) {
+      return DB_KEY_TOO_LONG;
+    }
+    row_ids.push_back(row_id);
+  }
+  std::vector<std::pair<GenericKey *, RowId>> entries;
+  entries.reserve(row_ids.size());
+  for (size_t i = 0; i < row_ids.size(); i++) {
+    entries.emplace_back(reinterpret_cast<GenericKey *>(key_buf.data() + i * key_size), row_ids[i]);
+  }
+  std::stable_sort(entries.begin(), entries.end(), [this](const auto &lhs, const auto &rhs) {
+    return processor_.CompareKeys(lhs.first, rhs.first) < 0;
+  });
+  // 非唯一索引的键带着 RowId，不会相等
+  entries.erase(std::unique(entries.begin(), entries.end(),
+                            [this](const auto &lhs, const auto &rhs) {
+                              return processor_.CompareKeys(lhs.first, rhs.first) == 0;
+                            }),
+                entries.end());
+  if (!container_.BulkLoad(entries, fill_factor, txn)) {
+    return DB_FAILED;
+  }
+  return DB_SUCCESS;
+}
+
 dberr_t BPlusTreeIndex::Destroy() {
   container_.Destroy();
   return DB_SUCCESS;
@@ -93,4 +130,76 @@ IndexIterator BPlusTreeIndex::GetBeginIterator(GenericKey *key) {
 
 IndexIterator BPlusTreeIndex::GetEndIterator() {
   return container_.End();
-}
\ No newline at end of file
+}
+
+GenericKey *BPlusTreeIndexCursor::EncodeBound(BPlusTreeIndex *index, const Row &bound) {
+  // 未给出的列和 RowId 后缀都留空（全 0），得到所有以 bound 开头的键的下界
+  GenericKey *key = index->processor_.InitKey();
+  index->processor_.SerializeFromKey(key, bound, index->key_schema_);
+  return key;
+}
+
+BPlusTreeIndexCursor::BPlusTreeIndexCursor(BPlusTreeIndex *index, const Row &start, bool start_inclusive,
+                                           const Row &stop, bool stop_inclusive)
+    : processor_(index->processor_),
+      container_(index->container_),
+      start_key_(EncodeBound(index, start)),
+      stop_key_(EncodeBound(index, stop)),
+      start_size_(processor_.GetPrefixSize(start.GetFieldCount())),
+      stop_size_(processor_.GetPrefixSize(stop.GetFieldCount())),
+      bound_columns_(std::max(start.GetFieldCount(), stop.GetFieldCount())),
+      start_inclusive_(start_inclusive),
+      stop_inclusive_(stop_inclusive),
+      single_(index->IsUnique() && start_inclusive && stop_inclusive &&
+              start.GetFieldCount() == index->key_schema_->GetColumnCount() &&
+              processor_.CompareKeys(start_key_, stop_key_) == 0),
+      // 与 NULL 比较的结果都不为真
+      done_(processor_.HasNull(start_key_, start.GetFieldCount()) ||
+            processor_.HasNull(stop_key_, stop.GetFieldCount())),
+      last_key_(processor_.InitKey()) {}
+
+BPlusTreeIndexCursor::~BPlusTreeIndexCursor() {
+  free(start_key_);
+  free(stop_key_);
+  free(last_key_);
+}
+
+bool BPlusTreeIndexCursor::Next(RowId *row_id) {
+  while (next_ == buffer_.size()) {
+    if (done_) {
+      return false;
+    }
+    buffer_.clear();
+    next_ = 0;
+    // 第一次从 start 的下界读起，之后从上次读到的键之后接着读
+    bool more = container_.ScanLeaf(started_ ? last_key_ : start_key_, !started_,
+                                    [this](const GenericKey *key, RowId row_id) { return Visit(key, row_id); });
+    if (!more) {
+      done_ = true;
+    }
+  }
+  *row_id = buffer_[next_++];
+  return true;
+}
+
+bool BPlusTreeIndexCursor::Visit(const GenericKey *key, RowId row_id) {
+  memcpy(last_key_, key, processor_.GetKeySize());
+  started_ = true;
+  if (stop_size_ > 0) {
+    int cmp = processor_.ComparePrefix(key, stop_key_, stop_size_);
+    if (cmp > 0 || (cmp == 0 && !stop_inclusive_)) {
+      done_ = true;
+      return false;
+    }
+  }
+  if ((!start_inclusive_ && start_size_ > 0 && processor_.ComparePrefix(key, start_key_, start_size_) == 0) ||
+      processor_.HasNull(key, bound_columns_)) {
+    return true;
+  }
+  buffer_.push_back(row_id);
+  if (single_) {
+    done_ = true;
+    return false;
+  }
+  return true;
+}
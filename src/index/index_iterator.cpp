@@ -7,7 +7,8 @@ IndexIterator::IndexIterator() = default;
 
 IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
     : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
-  page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+  frame = buffer_pool_manager->FetchPage(current_page_id);
+  page = reinterpret_cast<LeafPage *>(frame->GetData());
 }
 
 IndexIterator::~IndexIterator() {
@@ -19,23 +20,31 @@ IndexIterator::~IndexIterator() {
  * TODO: Student Implement
  */
 std::pair<GenericKey *, RowId> IndexIterator::operator*() {
-  return page->GetItem(item_index);
+  frame->RLatch();
+  auto item = page->GetItem(item_index);
+  frame->RUnlatch();
+  return item;
 }
 
 /**
  * TODO: Student Implement
  */
 IndexIterator &IndexIterator::operator++() {
-  if (item_index!=page->GetSize()-1){
+  frame->RLatch();
+  int size = page->GetSize();
+  page_id_t next_leave_page_id = page->GetNextPageId();
+  frame->RUnlatch();
+  if (item_index + 1 < size){
     item_index++;
     return *this;
   }
   else{
-    page_id_t next_leave_page_id = page->GetNextPageId();
     buffer_pool_manager->UnpinPage(current_page_id,false);
     current_page_id = next_leave_page_id;
-    page = reinterpret_cast<BPlusTreeLeafPage*>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
     item_index = 0;
+    // 走过最后一个叶子后与 End() 相等
+    frame = current_page_id == INVALID_PAGE_ID ? nullptr : buffer_pool_manager->FetchPage(current_page_id);
+    page = frame == nullptr ? nullptr : reinterpret_cast<BPlusTreeLeafPage *>(frame->GetData());
     return *this;
   }
 }
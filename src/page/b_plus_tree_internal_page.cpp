@@ -20,6 +20,8 @@
  * max page size
  */
 void InternalPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetSize(0);
   SetPageId(page_id);
   SetParentPageId(parent_id);
   SetKeySize(key_size);
@@ -211,7 +213,7 @@ void InternalPage::MoveAllTo(InternalPage *recipient, GenericKey *middle_key, Bu
   GenericKey* new_key = KeyAt(1);
   recipient->CopyNFrom(reinterpret_cast<void*>(new_key), GetSize()-1, buffer_pool_manager);
   SetSize(0);
-  buffer_pool_manager->DeletePage(this->GetPageId());
+  // 当前页还被调用者 pin 着，由调用者在释放后删除
 }
 //void InternalPage::CopyLastFrom(GenericKey *key, const page_id_t value, BufferPoolManager *buffer_pool_manager) {
 //void InternalPage::CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool_manager) {
@@ -274,13 +276,15 @@ void InternalPage::MoveLastToFrontOf(InternalPage *recipient, GenericKey *middle
  */
 void InternalPage::CopyFirstFrom(const page_id_t value, BufferPoolManager *buffer_pool_manager) {
   int size_t = GetSize();
-  for (int i=0; i<size_t; i++){
+  // 从后往前挪，否则前面的会覆盖后面的
+  for (int i=size_t-1; i>=0; i--){
     GenericKey* new_key = KeyAt(i);
     page_id_t new_value = ValueAt(i);
     SetKeyAt(i+1,new_key);
     SetValueAt(i+1,new_value);
   }
   SetValueAt(0,value);
+  SetSize(size_t+1);
   InternalPage* new_page =reinterpret_cast<InternalPage*>((buffer_pool_manager)->FetchPage(value)); 
   new_page -> SetParentPageId(GetPageId());
   buffer_pool_manager->UnpinPage(value, true);
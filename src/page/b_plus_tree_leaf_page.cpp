@@ -134,10 +134,8 @@ int LeafPage::Insert(GenericKey *key, const RowId &value, const KeyManager &KM)
  */
 void LeafPage::MoveHalfTo(LeafPage *recipient) {
   int size_t = GetSize();
-  char *src_l = reinterpret_cast<char*>(KeyAt(0));
-  for (int i=0; i<size_t/2; i++){
-    src_l += pair_size;
-  }
+  // 保留前 size_t - size_t/2 个，奇数个时不能从 size_t/2 开始搬
+  char *src_l = reinterpret_cast<char*>(KeyAt(size_t - size_t/2));
   void* src = reinterpret_cast<void*>(src_l);
   recipient->CopyNFrom(src,size_t/2);
   SetSize(size_t - size_t/2);
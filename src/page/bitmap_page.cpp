@@ -1,29 +1,89 @@
 #include "page/bitmap_page.h"
 
+#include <cstring>
+
 #include "glog/logging.h"
 
+template <size_t PageSize>
+uint64_t BitmapPage<PageSize>::LoadWord(uint32_t word_index) const {
+    // bytes 不保证 8 字节对齐；小端序下第 i 位正好对应 page_offset % 64 == i
+    uint64_t word;
+    memcpy(&word, bytes + word_index * sizeof(uint64_t), sizeof(uint64_t));
+    return word;
+}
+
 template <size_t PageSize>
 bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
-    uint32_t count=0;
-    while(!IsPageFree(next_free_page_)){
-        count++;
-        next_free_page_++;
-        next_free_page_%=GetMaxSupportedSize();
-        if (count>GetMaxSupportedSize()){
-            return false;
+    if (page_allocated_ >= GetMaxSupportedSize()) {
+        return false;
+    }
+    if (next_free_page_ >= GetMaxSupportedSize()) {
+        next_free_page_ = 0;
+    }
+    // 从 next_free_page_ 所在的 word 开始按 64 位整字找第一个 0 位，绕回后再检查起始 word 的低位
+    uint32_t start_word = next_free_page_ / WORD_BITS;
+    for (uint32_t i = 0; i <= NUM_WORDS; i++) {
+        uint32_t word_index = (start_word + i) % NUM_WORDS;
+        uint64_t word = LoadWord(word_index);
+        if (i == 0) {
+            // 跳过 hint 之前的位
+            word |= (uint64_t{1} << (next_free_page_ % WORD_BITS)) - 1;
+        }
+        if (~word == 0) {
+            continue;
         }
+        page_offset = word_index * WORD_BITS + __builtin_ctzll(~word);
+        page_allocated_++;
+        bytes[page_offset / 8] |= (1 << (page_offset % 8));
+        next_free_page_ = (page_offset + 1) % GetMaxSupportedSize();
+        return true;
     }
+    return false;
+}
 
-    page_allocated_++;
-    page_offset=next_free_page_;
-    uint32_t byte_index=page_offset / 8;
-    uint8_t bit_index=page_offset % 8;
-    bytes[byte_index]|=(1<<bit_index);
+template <size_t PageSize>
+bool BitmapPage<PageSize>::AllocateRun(uint32_t count, uint32_t &page_offset) {
+    if (count == 0 || count > GetMaxSupportedSize() - page_allocated_) {
+        return false;
+    }
+    uint32_t run_start = 0;
+    uint32_t run_length = 0;
+    for (uint32_t word_index = 0; word_index < NUM_WORDS && run_length < count; word_index++) {
+        uint64_t word = LoadWord(word_index);
+        // 整字全满或全空时不必逐位检查
+        if (~word == 0) {
+            run_length = 0;
+            continue;
+        }
+        if (word == 0) {
+            if (run_length == 0) {
+                run_start = word_index * WORD_BITS;
+            }
+            run_length += WORD_BITS;
+            continue;
+        }
+        for (uint32_t bit = 0; bit < WORD_BITS && run_length < count; bit++) {
+            if ((word >> bit) & 1) {
+                run_length = 0;
+            } else if (run_length++ == 0) {
+                run_start = word_index * WORD_BITS + bit;
+            }
+        }
+    }
+    if (run_length < count) {
+        return false;
+    }
+    for (uint32_t offset = run_start; offset < run_start + count; offset++) {
+        bytes[offset / 8] |= (1 << (offset % 8));
+    }
+    page_allocated_ += count;
+    if (next_free_page_ >= run_start && next_free_page_ < run_start + count) {
+        next_free_page_ = (run_start + count) % GetMaxSupportedSize();
+    }
+    page_offset = run_start;
     return true;
-
 }
 
-
 template <size_t PageSize>
 bool BitmapPage<PageSize>::DeAllocatePage(uint32_t page_offset) {
     if (page_offset>=GetMaxSupportedSize())
@@ -0,0 +1,10 @@
+#include "page/free_space_map_page.h"
+
+int FreeSpaceMapPage::Append(page_id_t page_id, uint32_t free_space) {
+  if (IsFull()) {
+    return -1;
+  }
+  entries_[count_].first = page_id;
+  entries_[count_].second = free_space;
+  return count_++;
+}
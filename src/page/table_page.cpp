@@ -1,5 +1,8 @@
 #include "page/table_page.h"
 
+#include <algorithm>
+#include <vector>
+
 // TODO: Update interface implementation if apply recovery
 
 void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr, Txn *txn) {
@@ -173,6 +176,47 @@ bool TablePage::GetFirstTupleRid(RowId *first_rid) {
   return false;
 }
 
+void TablePage::GetLiveSlots(std::vector<uint32_t> *slots) {
+  slots->clear();
+  uint32_t tuple_count = GetTupleCount();
+  for (uint32_t i = 0; i < tuple_count; i++) {
+    if (!IsDeleted(GetTupleSize(i))) {
+      slots->push_back(i);
+    }
+  }
+}
+
+uint32_t TablePage::Compact() {
+  uint32_t old_free_space = GetFreeSpaceRemaining();
+  // 去掉槽目录末尾的空槽，中间的空槽仍要保留以免改变 RowId
+  uint32_t tuple_count = GetTupleCount();
+  while (tuple_count > 0 && GetTupleSize(tuple_count - 1) == 0) {
+    tuple_count--;
+  }
+  SetTupleCount(tuple_count);
+  // 按偏移从高到低依次把元组紧贴页尾存放
+  std::vector<uint32_t> slots;
+  for (uint32_t i = 0; i < tuple_count; i++) {
+    if (GetTupleSize(i) != 0) {
+      slots.push_back(i);
+    }
+  }
+  std::sort(slots.begin(), slots.end(),
+            [this](uint32_t a, uint32_t b) { return GetTupleOffsetAtSlot(a) > GetTupleOffsetAtSlot(b); });
+  uint32_t free_space_pointer = PAGE_SIZE;
+  for (auto slot : slots) {
+    uint32_t tuple_size = UnsetDeletedFlag(GetTupleSize(slot));
+    uint32_t tuple_offset = GetTupleOffsetAtSlot(slot);
+    free_space_pointer -= tuple_size;
+    if (tuple_offset != free_space_pointer) {
+      memmove(GetData() + free_space_pointer, GetData() + tuple_offset, tuple_size);
+      SetTupleOffsetAtSlot(slot, free_space_pointer);
+    }
+  }
+  SetFreeSpacePointer(free_space_pointer);
+  return GetFreeSpaceRemaining() - old_free_space;
+}
+
 bool TablePage::GetNextTupleRid(const RowId &cur_rid, RowId *next_rid) {
   ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
   // Find and return the first valid tuple after our current slot number.
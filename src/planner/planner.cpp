@@ -33,26 +33,126 @@ void Planner::PlanQuery(pSyntaxNode ast) {
       throw std::logic_error("the statement is not supported in planner yet");
   }
 }
+/**
+ * Split a WHERE clause without OR into its comparisons.
+ */
+static void CollectConjuncts(const AbstractExpressionRef &predicate,
+                             std::vector<std::shared_ptr<ComparisonExpression>> *conjuncts) {
+  if (predicate->GetType() == ExpressionType::LogicExpression) {
+    CollectConjuncts(predicate->GetChildAt(0), conjuncts);
+    CollectConjuncts(predicate->GetChildAt(1), conjuncts);
+  } else if (predicate->GetType() == ExpressionType::ComparisonExpression) {
+    conjuncts->push_back(dynamic_pointer_cast<ComparisonExpression>(predicate));
+  }
+}
+
+/**
+ * The part of a WHERE clause one index can answer with a single range scan.
+ */
+struct IndexRange {
+  IndexInfo *index_{nullptr};
+  Row start_;
+  bool start_inclusive_{true};
+  Row stop_;
+  bool stop_inclusive_{true};
+  uint32_t equal_columns_{0};  // 等值条件绑定的前导列数
+  bool has_range_{false};      // 下一列上是否还有范围条件
+  size_t used_{0};             // 用掉的条件数
+
+  /** A unique index fully bound by equalities first, as it returns at most one row; then more bound columns. */
+  bool BetterThan(const IndexRange &other) const {
+    if (IsPointLookup() != other.IsPointLookup()) {
+      return IsPointLookup();
+    }
+    if (equal_columns_ != other.equal_columns_) {
+      return equal_columns_ > other.equal_columns_;
+    }
+    return has_range_ && !other.has_range_;
+  }
+
+  bool IsPointLookup() const {
+    return index_->GetIndex()->IsUnique() && equal_columns_ == index_->GetIndexKeySchema()->GetColumnCount();
+  }
+};
+
+/**
+ * Bind the leading columns of index with equalities, then at most one lower and one upper bound on the next
+ * column. Comparisons left over stay in the filter.
+ */
+static IndexRange MatchIndex(IndexInfo *index, const std::vector<std::shared_ptr<ComparisonExpression>> &conjuncts) {
+  IndexRange range;
+  range.index_ = index;
+  std::vector<Field> prefix;
+  auto find_conjunct = [&conjuncts](uint32_t col_id, std::initializer_list<const char *> ops) {
+    for (auto &conjunct : conjuncts) {
+      auto column = dynamic_pointer_cast<ColumnValueExpression>(conjunct->GetChildAt(0));
+      auto type = conjunct->GetComparisonType();
+      if (column != nullptr && column->GetColIdx() == col_id &&
+          std::find(ops.begin(), ops.end(), type) != ops.end()) {
+        return conjunct;
+      }
+    }
+    return std::shared_ptr<ComparisonExpression>();
+  };
+  for (auto column : index->GetIndexKeySchema()->GetColumns()) {
+    auto col_id = column->GetTableInd();
+    auto equal = find_conjunct(col_id, {"="});
+    if (equal != nullptr) {
+      prefix.emplace_back(equal->GetChildAt(1)->Evaluate(nullptr));
+      range.equal_columns_++;
+      range.used_++;
+      continue;
+    }
+    std::vector<Field> start = prefix;
+    std::vector<Field> stop = prefix;
+    auto lower = find_conjunct(col_id, {">", ">="});
+    if (lower != nullptr) {
+      start.emplace_back(lower->GetChildAt(1)->Evaluate(nullptr));
+      range.start_inclusive_ = lower->GetComparisonType() == ">=";
+      range.used_++;
+    }
+    auto upper = find_conjunct(col_id, {"<", "<="});
+    if (upper != nullptr) {
+      stop.emplace_back(upper->GetChildAt(1)->Evaluate(nullptr));
+      range.stop_inclusive_ = upper->GetComparisonType() == "<=";
+      range.used_++;
+    }
+    range.has_range_ = lower != nullptr || upper != nullptr;
+    range.start_ = Row(start);
+    range.stop_ = Row(stop);
+    return range;
+  }
+  range.start_ = Row(prefix);
+  range.stop_ = Row(prefix);
+  return range;
+}
+
 AbstractPlanNodeRef Planner::PlanSelect(std::shared_ptr<SelectStatement> statement) {
   auto out_schema = MakeOutputSchema(statement->column_list_);
+  if (statement->where_ == nullptr || statement->has_or) {
+    return make_shared<SeqScanPlanNode>(out_schema, statement->table_name_, statement->where_);
+  }
+  std::vector<std::shared_ptr<ComparisonExpression>> conjuncts;
+  CollectConjuncts(statement->where_, &conjuncts);
+  // 选能绑定最多前导列的索引，整个条件只读一段连续的键
   vector<IndexInfo *> indexes;
-  vector<IndexInfo *> available_index;
   context_->GetCatalog()->GetTableIndexes(statement->table_name_, indexes);
+  IndexRange best;
   for (auto index : indexes) {
-    if (index->GetIndexKeySchema()->GetColumns().size() == 1) {
-      auto col_id = index->GetIndexKeySchema()->GetColumn(0)->GetTableInd();
-      if (std::find(statement->column_in_condition_.begin(), statement->column_in_condition_.end(), col_id) !=
-          statement->column_in_condition_.end()) {
-        available_index.push_back(index);
-      }
+    IndexRange range = MatchIndex(index, conjuncts);
+    if (range.equal_columns_ == 0 && !range.has_range_) {
+      continue;
+    }
+    if (best.index_ == nullptr || range.BetterThan(best)) {
+      best = std::move(range);
     }
   }
-  if (available_index.empty() || statement->has_or) {
+  if (best.index_ == nullptr) {
     return make_shared<SeqScanPlanNode>(out_schema, statement->table_name_, statement->where_);
   }
-  return make_shared<IndexScanPlanNode>(out_schema, statement->table_name_, available_index,
-                                        available_index.size() != statement->column_in_condition_.size(),
-                                        statement->where_);
+  return make_shared<IndexScanPlanNode>(out_schema, statement->table_name_, best.index_, std::move(best.start_),
+                                        best.start_inclusive_, std::move(best.stop_), best.stop_inclusive_,
+                                        best.used_ != conjuncts.size(), statement->where_);
 }
 
 AbstractPlanNodeRef Planner::PlanInsert(std::shared_ptr<InsertStatement> statement) {
@@ -4,28 +4,34 @@ uint32_t Row::SerializeTo(char *buf, Schema *schema) const {
   ASSERT(schema != nullptr, "Invalid schema before serialize.");
   ASSERT(schema->GetColumnCount() == fields_.size(), "Fields size do not match schema's column size.");
 
-  uint32_t offset = 0;
-
-  // 写入字段数量
-  uint32_t field_count = fields_.size();
-  memcpy(buf + offset, &field_count, sizeof(RowId));
-
-  offset += sizeof(RowId);
+  // 定长部分先清零，空值和 CHAR 的填充字节都是 0
+  uint32_t offset = schema->GetFixedRowSize();
+  memset(buf, 0, offset);
   // 写入空值位图
-  uint32_t null_bitmap_size = (field_count + 7) / 8; // 每8个字段占1字节
-  std::vector<uint8_t> null_bitmap(null_bitmap_size, 0);
-  for (uint32_t i = 0; i < field_count; i++) {
-    if (fields_[i]->IsNull()) {// 如果字段是空值
-      null_bitmap[i / 8] |= (1 << (i % 8));
+  for (uint32_t i = 0; i < fields_.size(); i++) {
+    if (fields_[i].IsNull()) {
+      buf[i / 8] |= static_cast<char>(1 << (i % 8));
     }
   }
-  memcpy(buf + offset, null_bitmap.data(), null_bitmap_size);
-  offset += null_bitmap_size;
-  // 写入每个字段的数据
-  for (uint32_t i = 0; i < field_count; i++) {
-    if (!fields_[i]->IsNull()) {
-      int tmp2 = fields_[i]->SerializeTo(buf + offset);
-      offset += tmp2;
+  // 写入每个字段的定长槽，超长的 CHAR 数据写到尾部
+  for (uint32_t i = 0; i < fields_.size(); i++) {
+    const Field &field = fields_[i];
+    if (field.IsNull()) {
+      continue;
+    }
+    char *slot = buf + schema->GetColumnOffset(i);
+    if (field.GetTypeId() != TypeId::kTypeChar) {
+      field.SerializeTo(slot);
+      continue;
+    }
+    uint32_t len = field.GetLength();
+    MACH_WRITE_UINT32(slot, len);
+    if (len <= schema->GetColumn(i)->GetLength()) {
+      memcpy(slot + sizeof(uint32_t), field.GetData(), len);
+    } else {
+      MACH_WRITE_UINT32(slot + sizeof(uint32_t), offset);
+      memcpy(buf + offset, field.GetData(), len);
+      offset += len;
     }
   }
   return offset;
@@ -35,58 +41,108 @@ uint32_t Row::DeserializeFrom(char *buf, Schema *schema) {
   ASSERT(schema != nullptr, "Invalid schema before deserialize.");
   ASSERT(fields_.empty(), "Non empty field in row.");
 
-  uint32_t offset = 0;
-
-  // 读取字段数量
-  RowId field_count = rid_;
-  memcpy(&field_count, buf + offset, sizeof(RowId));
-  offset += sizeof(RowId);
-  // 读取空值位图
-  uint32_t null_bitmap_size = (schema->GetColumnCount() + 7) / 8;
-  std::vector<uint8_t> null_bitmap(null_bitmap_size, 0);
-  memcpy(null_bitmap.data(), buf + offset, null_bitmap_size);
-  offset += null_bitmap_size;
-  // 读取每个字段的数据
-
+  uint32_t size = schema->GetFixedRowSize();
+  // 读取每个字段的数据，CHAR 字段先借用 buf 中的数据，最后统一拷贝到行自己的缓冲区
+  fields_.reserve(schema->GetColumnCount());
   for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
-      TypeId type = schema->GetColumn(i)->GetType();
-      Field *field;
-      offset += field->DeserializeFrom(buf + offset, type, &field, null_bitmap[i / 8] & (1 << (i % 8)));
-      fields_.push_back(field);
+    TypeId type = schema->GetColumn(i)->GetType();
+    if (buf[i / 8] & (1 << (i % 8))) {
+      fields_.emplace_back(type);
+      continue;
+    }
+    const char *slot = buf + schema->GetColumnOffset(i);
+    switch (type) {
+      case TypeId::kTypeInt:
+        fields_.emplace_back(type, MACH_READ_FROM(int32_t, slot));
+        break;
+      case TypeId::kTypeFloat:
+        fields_.emplace_back(type, MACH_READ_FROM(float_t, slot));
+        break;
+      case TypeId::kTypeChar: {
+        uint32_t len;
+        const char *data = GetCharData(buf, schema, i, &len);
+        fields_.emplace_back(type, const_cast<char *>(data), len, false);
+        if (len > schema->GetColumn(i)->GetLength()) {
+          size += len;
+        }
+        break;
+      }
+      default:
+        ASSERT(false, "Unsupported field type.");
+    }
   }
-  return offset;
+  OwnCharData();
+  return size;
 }
 
 uint32_t Row::GetSerializedSize(Schema *schema) const {
   ASSERT(schema != nullptr, "Invalid schema before calculating serialized size.");
   ASSERT(schema->GetColumnCount() == fields_.size(), "Fields size do not match schema's column size.");
 
-  uint32_t size = 0;
-
-  // 字段数量大小
-  size += sizeof(RowId);
-
-  // 空值位图大小
-  uint32_t field_count = fields_.size();
-  size += (field_count + 7) / 8;
-
-  // 每个字段的序列化大小
-  for (const auto &field : fields_) {
-    if (!field->IsNull()) {
-      size += field->GetSerializedSize();
+  // 定长部分加上超长 CHAR 放在尾部的数据
+  uint32_t size = schema->GetFixedRowSize();
+  for (uint32_t i = 0; i < fields_.size(); i++) {
+    const Field &field = fields_[i];
+    if (field.GetTypeId() == TypeId::kTypeChar && !field.IsNull() &&
+        field.GetLength() > schema->GetColumn(i)->GetLength()) {
+      size += field.GetLength();
     }
   }
   return size;
 }
 
 void Row::GetKeyFromRow(const Schema *schema, const Schema *key_schema, Row &key_row) {
-  
-  auto columns = key_schema->GetColumns();
-  std::vector<Field> fields;
+  auto &columns = key_schema->GetColumns();
+  key_row.destroy();
+  key_row.fields_.reserve(columns.size());
   uint32_t idx;
   for (auto column : columns) {
     schema->GetColumnIndex(column->GetName(), idx);
-    fields.emplace_back(*this->GetField(idx));
+    key_row.AppendBorrowed(fields_[idx]);
+  }
+  key_row.OwnCharData();
+}
+
+void Row::CopyFields(const std::vector<Field> &fields) {
+  fields_.clear();
+  fields_.reserve(fields.size());
+  for (auto &field : fields) {
+    AppendBorrowed(field);
+  }
+  OwnCharData();
+}
+
+void Row::AppendBorrowed(const Field &field) {
+  if (field.GetTypeId() == TypeId::kTypeChar && !field.IsNull()) {
+    fields_.emplace_back(TypeId::kTypeChar, const_cast<char *>(field.GetData()), field.GetLength(), false);
+  } else {
+    fields_.emplace_back(field);
+  }
+}
+
+void Row::OwnCharData() {
+  uint32_t total = 0;
+  bool has_chars = false;
+  for (auto &field : fields_) {
+    if (field.GetTypeId() == TypeId::kTypeChar && !field.IsNull()) {
+      total += field.GetLength();
+      has_chars = true;
+    }
+  }
+  if (!has_chars) {
+    chars_.reset();
+    return;
+  }
+  // 空串也要指向有效地址，否则会被当成空值
+  std::unique_ptr<char[]> chars(new char[total == 0 ? 1 : total]);
+  uint32_t offset = 0;
+  for (auto &field : fields_) {
+    if (field.GetTypeId() == TypeId::kTypeChar && !field.IsNull()) {
+      uint32_t len = field.GetLength();
+      memcpy(chars.get() + offset, field.GetData(), len);
+      field = Field(TypeId::kTypeChar, chars.get() + offset, len, false);
+      offset += len;
+    }
   }
-  key_row = Row(fields);
+  chars_ = std::move(chars);
 }
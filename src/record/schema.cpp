@@ -1,5 +1,16 @@
 #include "record/schema.h"
 
+void Schema::ComputeRowLayout() {
+  column_offsets_.clear();
+  column_offsets_.reserve(columns_.size());
+  uint32_t offset = GetNullBitmapSize();
+  for (auto column : columns_) {
+    column_offsets_.push_back(offset);
+    offset += GetColumnSlotSize(column);
+  }
+  fixed_row_size_ = offset;
+}
+
 uint32_t Schema::SerializeTo(char *buf) const {
   // 写入魔数
   uint32_t offset = 0;
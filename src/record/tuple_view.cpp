@@ -0,0 +1,36 @@
+#include "record/tuple_view.h"
+
+Field TupleView::GetField(uint32_t idx, bool copy_data) const {
+  TypeId type = schema_->GetColumn(idx)->GetType();
+  if (IsNull(idx)) {
+    return Field(type);
+  }
+  const char *buf = data_ + schema_->GetColumnOffset(idx);
+  switch (type) {
+    case TypeId::kTypeInt:
+      return Field(type, MACH_READ_FROM(int32_t, buf));
+    case TypeId::kTypeFloat:
+      return Field(type, MACH_READ_FROM(float_t, buf));
+    case TypeId::kTypeChar: {
+      uint32_t len;
+      const char *data = Row::GetCharData(data_, schema_, idx, &len);
+      return Field(type, const_cast<char *>(data), len, copy_data);
+    }
+    default:
+      ASSERT(false, "Unsupported field type.");
+      return Field(type);
+  }
+}
+
+void TupleView::ToRow(Row *row) const {
+  row->DeserializeFrom(const_cast<char *>(data_), const_cast<Schema *>(schema_));
+}
+
+void TupleView::Project(const Schema *output_schema, Row *row) const {
+  std::vector<Field> fields;
+  fields.reserve(output_schema->GetColumnCount());
+  for (auto column : output_schema->GetColumns()) {
+    fields.emplace_back(GetField(column->GetTableInd(), true));
+  }
+  *row = Row(fields);
+}
@@ -0,0 +1,223 @@
+#include "storage/async_io_engine.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/aio_abi.h>
+#include <sys/syscall.h>
+#endif
+
+#include "glog/logging.h"
+#include "storage/disk_manager.h"
+
+#ifdef __linux__
+static int IOSetup(unsigned nr_events, aio_context_t *ctx) { return syscall(__NR_io_setup, nr_events, ctx); }
+
+static int IODestroy(aio_context_t ctx) { return syscall(__NR_io_destroy, ctx); }
+
+static int IOSubmit(aio_context_t ctx, long nr, struct iocb **iocbpp) {
+  return syscall(__NR_io_submit, ctx, nr, iocbpp);
+}
+
+static int IOGetEvents(aio_context_t ctx, long min_nr, long max_nr, struct io_event *events) {
+  return syscall(__NR_io_getevents, ctx, min_nr, max_nr, events, nullptr);
+}
+#endif
+
+AsyncIOEngine::AsyncIOEngine(int fd, bool direct_io) : fd_(fd), direct_io_(direct_io) {
+#ifdef __linux__
+  aio_context_t ctx = 0;
+  if (IOSetup(MAX_QUEUE_DEPTH, &ctx) == 0) {
+    aio_context_ = ctx;
+  } else {
+    LOG(WARNING) << "Native AIO is unavailable (" << strerror(errno) << "), using synchronous I/O";
+  }
+#endif
+  if (direct_io_) {
+    bounce_pages_ = static_cast<char *>(aligned_alloc(DiskManager::DIRECT_IO_ALIGNMENT, MAX_QUEUE_DEPTH * PAGE_SIZE));
+  }
+}
+
+AsyncIOEngine::~AsyncIOEngine() {
+#ifdef __linux__
+  if (aio_context_ != 0) {
+    IODestroy(aio_context_);
+  }
+#endif
+  free(bounce_pages_);
+}
+
+bool AsyncIOEngine::ExecuteSync(std::vector<Request> &requests) {
+  bool ok = true;
+  for (auto &request : requests) {
+    ok = ExecuteOne(request, bounce_pages_) && ok;
+  }
+  return ok;
+}
+
+bool AsyncIOEngine::ExecuteOne(Request &request, char *bounce) {
+  bool unaligned = direct_io_ && reinterpret_cast<uintptr_t>(request.data_) % DiskManager::DIRECT_IO_ALIGNMENT != 0;
+  char *buffer = unaligned ? bounce : request.data_;
+  if (request.is_write_ && unaligned) {
+    memcpy(buffer, request.data_, PAGE_SIZE);
+  }
+  ssize_t done = 0;
+  bool eof = false;
+  while (done < PAGE_SIZE) {
+    ssize_t ret = request.is_write_ ? pwrite(fd_, buffer + done, PAGE_SIZE - done, request.offset_ + done)
+                                    : pread(fd_, buffer + done, PAGE_SIZE - done, request.offset_ + done);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      eof = ret == 0 && !request.is_write_;
+      break;
+    }
+    done += ret;
+  }
+  // 只有读到文件末尾时才补 0，读写出错都算失败
+  if (done < PAGE_SIZE && !eof) {
+    request.failed_ = true;
+    return false;
+  }
+  if (request.is_write_) {
+    return true;
+  }
+  memset(buffer + done, 0, PAGE_SIZE - done);
+  if (unaligned) {
+    memcpy(request.data_, buffer, PAGE_SIZE);
+  }
+  return true;
+}
+
+bool AsyncIOEngine::Execute(std::vector<Request> &requests, size_t queue_depth) {
+#ifdef __linux__
+  if (aio_context_ == 0 || queue_depth <= 1) {
+    return ExecuteSync(requests);
+  }
+  if (queue_depth > MAX_QUEUE_DEPTH) {
+    queue_depth = MAX_QUEUE_DEPTH;
+  }
+  struct iocb iocbs[MAX_QUEUE_DEPTH];
+  struct iocb *iocb_ptrs[MAX_QUEUE_DEPTH];
+  struct io_event events[MAX_QUEUE_DEPTH];
+  // 空闲的 iocb 槽位，每个槽位对应一个 bounce page
+  std::vector<size_t> free_slots;
+  std::vector<size_t> slot_request(queue_depth);
+  for (size_t i = queue_depth; i > 0; i--) {
+    free_slots.push_back(i - 1);
+  }
+  bool ok = true;
+  size_t next = 0;
+  size_t in_flight = 0;
+  long pending = 0;  // iocb_ptrs[0, pending) are filled in but not submitted yet
+  while (next < requests.size() || pending > 0 || in_flight > 0) {
+    // fill the queue
+    while (next < requests.size() && !free_slots.empty()) {
+      size_t slot = free_slots.back();
+      free_slots.pop_back();
+      Request &request = requests[next];
+      char *buffer = request.data_;
+      if (direct_io_ && reinterpret_cast<uintptr_t>(buffer) % DiskManager::DIRECT_IO_ALIGNMENT != 0) {
+        buffer = bounce_pages_ + slot * PAGE_SIZE;
+        if (request.is_write_) {
+          memcpy(buffer, request.data_, PAGE_SIZE);
+        }
+      }
+      struct iocb &cb = iocbs[slot];
+      memset(&cb, 0, sizeof(cb));
+      cb.aio_data = slot;
+      cb.aio_fildes = fd_;
+      cb.aio_lio_opcode = request.is_write_ ? IOCB_CMD_PWRITE : IOCB_CMD_PREAD;
+      cb.aio_buf = reinterpret_cast<uint64_t>(buffer);
+      cb.aio_nbytes = PAGE_SIZE;
+      cb.aio_offset = request.offset_;
+      slot_request[slot] = next;
+      iocb_ptrs[pending++] = &cb;
+      next++;
+    }
+    while (pending > 0) {
+      int ret = IOSubmit(aio_context_, pending, iocb_ptrs);
+      if (ret > 0) {
+        in_flight += ret;
+        pending -= ret;
+        memmove(iocb_ptrs, iocb_ptrs + ret, pending * sizeof(iocb_ptrs[0]));
+        continue;
+      }
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret < 0 && errno == EAGAIN && in_flight > 0) {
+        // the kernel queue is full: reap some completions before submitting the rest
+        break;
+      }
+      LOG(ERROR) << "io_submit failed: " << strerror(errno);
+      // run what is left of this round synchronously
+      for (long i = 0; i < pending; i++) {
+        size_t slot = iocb_ptrs[i]->aio_data;
+        ok = ExecuteOne(requests[slot_request[slot]], bounce_pages_ + slot * PAGE_SIZE) && ok;
+        free_slots.push_back(slot);
+      }
+      pending = 0;
+    }
+    if (in_flight == 0) {
+      continue;
+    }
+    // reap at least one completion
+    int reaped = IOGetEvents(aio_context_, 1, in_flight, events);
+    if (reaped < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG(ERROR) << "io_getevents failed: " << strerror(errno) << ", falling back to synchronous I/O";
+      // io_destroy cancels or waits out every request in flight, after which the kernel no longer touches their
+      // buffers; redo those and the rest of the batch synchronously
+      IODestroy(aio_context_);
+      aio_context_ = 0;
+      std::vector<bool> idle(queue_depth, false);
+      for (size_t slot : free_slots) {
+        idle[slot] = true;
+      }
+      for (size_t slot = 0; slot < queue_depth; slot++) {
+        if (!idle[slot]) {
+          ok = ExecuteOne(requests[slot_request[slot]], bounce_pages_ + slot * PAGE_SIZE) && ok;
+        }
+      }
+      for (; next < requests.size(); next++) {
+        ok = ExecuteOne(requests[next], bounce_pages_) && ok;
+      }
+      return ok;
+    }
+    for (int i = 0; i < reaped; i++) {
+      size_t slot = events[i].data;
+      Request &request = requests[slot_request[slot]];
+      auto *buffer = reinterpret_cast<char *>(iocbs[slot].aio_buf);
+      int64_t res = events[i].res;
+      if (request.is_write_) {
+        request.failed_ = res != PAGE_SIZE;
+        ok = ok && !request.failed_;
+      } else {
+        if (res < 0) {
+          request.failed_ = true;
+          ok = false;
+          res = 0;
+        }
+        // short read at the end of file
+        memset(buffer + res, 0, PAGE_SIZE - res);
+        if (buffer != request.data_) {
+          memcpy(request.data_, buffer, PAGE_SIZE);
+        }
+      }
+      free_slots.push_back(slot);
+      in_flight--;
+    }
+  }
+  return ok;
+#else
+  return ExecuteSync(requests);
+#endif
+}
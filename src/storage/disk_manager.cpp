@@ -1,52 +1,123 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <filesystem>
 #include <stdexcept>
 
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io) : file_name_(db_file) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    std::filesystem::path p = db_file;
-    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw std::exception();
+  OpenFile(direct_io);
+  aio_engine_ = new AsyncIOEngine(db_fd_, direct_io_);
+  ReadPhysicalPage(META_PAGE_ID, meta_data_);
+}
+
+void DiskManager::OpenFile(bool direct_io) {
+  // directory does not exist
+  std::filesystem::path p = file_name_;
+  if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+  int flags = O_RDWR | O_CREAT;
+  if (direct_io) {
+    db_fd_ = open(file_name_.c_str(), flags | O_DIRECT, 0644);
+    if (db_fd_ >= 0) {
+      direct_io_ = true;
+    } else {
+      LOG(WARNING) << "O_DIRECT is not supported for " << file_name_ << ", falling back to buffered I/O";
     }
   }
-  ReadPhysicalPage(META_PAGE_ID, meta_data_);
+  if (db_fd_ < 0) {
+    db_fd_ = open(file_name_.c_str(), flags, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw std::exception();
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    throw std::exception();
+  }
+  file_size_ = stat_buf.st_size;
 }
 
 void DiskManager::Close() {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
   if (!closed) {
-    db_io_.close();
+    meta_dirty_ = true;
+    FlushMetadata();
+    fsync(db_fd_);
+    close(db_fd_);
     closed = true;
   }
 }
 
 void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
   // ASSERT(logical_page_id >= 0, "Invalid page id.");
+  num_reads_++;
   ReadPhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
 void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
-
   WritePhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
+bool DiskManager::ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages, size_t queue_depth,
+                            std::vector<page_id_t> *failed) {
+  std::vector<AsyncIOEngine::Request> requests;
+  std::vector<page_id_t> request_pages;
+  requests.reserve(pages.size());
+  num_reads_ += pages.size();
+  for (auto &page : pages) {
+    uint64_t offset = static_cast<uint64_t>(MapPageId(page.first)) * PAGE_SIZE;
+    if (offset >= file_size_) {
+      memset(page.second, 0, PAGE_SIZE);
+      continue;
+    }
+    requests.push_back({offset, page.second, false});
+    request_pages.push_back(page.first);
+  }
+  std::scoped_lock<std::mutex> lock(aio_latch_);
+  if (aio_engine_->Execute(requests, queue_depth)) {
+    return true;
+  }
+  LOG(ERROR) << "I/O error while reading a batch of pages";
+  for (size_t i = 0; failed != nullptr && i < requests.size(); i++) {
+    if (requests[i].failed_) {
+      failed->push_back(request_pages[i]);
+    }
+  }
+  return false;
+}
+
+bool DiskManager::WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages, size_t queue_depth,
+                             std::vector<page_id_t> *failed) {
+  std::vector<AsyncIOEngine::Request> requests;
+  requests.reserve(pages.size());
+  for (auto &page : pages) {
+    uint64_t offset = static_cast<uint64_t>(MapPageId(page.first)) * PAGE_SIZE;
+    requests.push_back({offset, const_cast<char *>(page.second), true});
+  }
+  std::scoped_lock<std::mutex> lock(aio_latch_);
+  bool ok = aio_engine_->Execute(requests, queue_depth);
+  if (!ok) {
+    LOG(ERROR) << "I/O error while writing a batch of pages";
+  }
+  for (size_t i = 0; i < requests.size(); i++) {
+    // 写失败的页不算进文件大小
+    if (!requests[i].failed_) {
+      ExtendFileSize(requests[i].offset_);
+    } else if (failed != nullptr) {
+      failed->push_back(pages[i].first);
+    }
+  }
+  return ok;
+}
+
 /**
  *
     tips:
@@ -54,10 +125,11 @@ void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
      2. 检查每个extend
      3. 根据物理地址将一个bitmap读入内存
      4. 分配页
-     5. 写回硬盘
+     5. 只改内存中的 bitmap，由 FlushMetadata 批量写回
      6. 没有空间的话新建extent
  */
 page_id_t DiskManager::AllocatePage() {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
     DiskFileMetaPage* meta_page = reinterpret_cast<DiskFileMetaPage*>(meta_data_);
     bool sign = false;
     if (meta_page->GetAllocatedPages()>=MAX_VALID_PAGE_ID){
@@ -70,16 +142,14 @@ page_id_t DiskManager::AllocatePage() {
             break;
         }
     }
-    int locate_physics = 1 + (1 + BITMAP_SIZE) * locate_Bitmap;
-    char* page_data = new char[sizeof(BitmapPage<PAGE_SIZE>)];
-    ReadPhysicalPage(locate_physics,page_data);
-    BitmapPage<PAGE_SIZE>* Bitpage=reinterpret_cast<BitmapPage<PAGE_SIZE>*>(page_data);
+    // bitmap 常驻内存，分配只修改内存中的位，由 FlushMetadata 统一写回
+    BitmapPage<PAGE_SIZE>* Bitpage = GetBitmap(locate_Bitmap);
     uint32_t page_offset;
     if (!(Bitpage->AllocatePage(page_offset))){
         throw std::exception();
     }
-    WritePhysicalPage(locate_physics,page_data);
-    delete[] page_data;
+    bitmap_dirty_[locate_Bitmap] = true;
+    meta_dirty_ = true;
     meta_page->num_allocated_pages_++;
     meta_page->extent_used_page_[locate_Bitmap]++;
     if (!sign){
@@ -88,45 +158,105 @@ page_id_t DiskManager::AllocatePage() {
     return locate_Bitmap * BITMAP_SIZE + page_offset;
 }
 
+page_id_t DiskManager::AllocatePages(uint32_t count) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  if (count == 0 || count > BITMAP_SIZE || meta_page->GetAllocatedPages() + count > MAX_VALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  // 已有 extent 中找不到足够长的连续空闲段时，开辟一个新的 extent
+  uint32_t max_extents = MAX_VALID_PAGE_ID / BITMAP_SIZE;
+  for (uint32_t extent_id = 0; extent_id <= meta_page->GetExtentNums() && extent_id < max_extents; extent_id++) {
+    if (BITMAP_SIZE - meta_page->GetExtentUsedPage(extent_id) < count) {
+      continue;
+    }
+    uint32_t page_offset;
+    if (!GetBitmap(extent_id)->AllocateRun(count, page_offset)) {
+      continue;
+    }
+    bitmap_dirty_[extent_id] = true;
+    meta_dirty_ = true;
+    if (extent_id == meta_page->GetExtentNums()) {
+      meta_page->num_extents_++;
+      meta_page->extent_used_page_[extent_id] = 0;
+    }
+    meta_page->num_allocated_pages_ += count;
+    meta_page->extent_used_page_[extent_id] += count;
+    return extent_id * BITMAP_SIZE + page_offset;
+  }
+  return INVALID_PAGE_ID;
+}
+
 /*
  */
 void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
     DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
     if (logical_page_id >= MAX_VALID_PAGE_ID){
         throw std::exception();
     }
-    int locate_physics =( logical_page_id / BITMAP_SIZE ) * (1 + BITMAP_SIZE) + 1;
-    // 将逻辑地址转化为物理地址非常的关键
+    uint32_t locate_Bitmap = logical_page_id / BITMAP_SIZE;
     uint32_t page_offset = logical_page_id % BITMAP_SIZE;
-    char* page_data = new char[sizeof(BitmapPage<PAGE_SIZE>)];
-    ReadPhysicalPage(locate_physics,page_data);
-    BitmapPage<PAGE_SIZE>* Bitpage=reinterpret_cast<BitmapPage<PAGE_SIZE>*>(page_data);
+    BitmapPage<PAGE_SIZE>* Bitpage = GetBitmap(locate_Bitmap);
     if (!Bitpage->DeAllocatePage(page_offset)){
         throw std::exception();
     }
-    WritePhysicalPage(locate_physics,page_data);
-    delete[] page_data;
+    bitmap_dirty_[locate_Bitmap] = true;
+    meta_dirty_ = true;
     meta_page->num_allocated_pages_--;
-    uint32_t locate_Bitmap;
-    locate_Bitmap = locate_physics / BITMAP_SIZE;
     meta_page->extent_used_page_[locate_Bitmap]--;
 }
 
 /*
  */
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
     if (logical_page_id >= MAX_VALID_PAGE_ID){
         throw std::exception();
     }
-    int locate_physics =( logical_page_id / BITMAP_SIZE ) * (1 + BITMAP_SIZE) + 1;
     uint32_t page_offset = logical_page_id % BITMAP_SIZE;
-    char* page_data = new char[sizeof(BitmapPage<PAGE_SIZE>)];
-    ReadPhysicalPage(locate_physics,page_data);
-    BitmapPage<PAGE_SIZE>* Bitpage=reinterpret_cast<BitmapPage<PAGE_SIZE>*>(page_data);
-    
-    bool is_free =  Bitpage->IsPageFree(page_offset);
-    delete[] page_data;
-    return is_free;
+    return GetBitmap(logical_page_id / BITMAP_SIZE)->IsPageFree(page_offset);
+}
+
+BitmapPage<PAGE_SIZE> *DiskManager::GetBitmap(uint32_t extent_id) {
+  if (extent_id >= bitmaps_.size()) {
+    bitmaps_.resize(extent_id + 1, nullptr);
+    bitmap_dirty_.resize(extent_id + 1, false);
+  }
+  if (bitmaps_[extent_id] == nullptr) {
+    // 页对齐，O_DIRECT 写回时不需要中转
+    bitmaps_[extent_id] = static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, PAGE_SIZE));
+    ReadPhysicalPage(BitmapPhysicalId(extent_id), bitmaps_[extent_id]);
+  }
+  return reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmaps_[extent_id]);
+}
+
+void DiskManager::FlushMetadata() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  std::vector<AsyncIOEngine::Request> requests;
+  for (uint32_t extent_id = 0; extent_id < bitmaps_.size(); extent_id++) {
+    if (bitmap_dirty_[extent_id]) {
+      uint64_t offset = static_cast<uint64_t>(BitmapPhysicalId(extent_id)) * PAGE_SIZE;
+      requests.push_back({offset, bitmaps_[extent_id], true});
+      bitmap_dirty_[extent_id] = false;
+    }
+  }
+  if (meta_dirty_) {
+    requests.push_back({static_cast<uint64_t>(META_PAGE_ID) * PAGE_SIZE, meta_data_, true});
+    meta_dirty_ = false;
+  }
+  if (requests.empty()) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> aio_lock(aio_latch_);
+    if (!aio_engine_->Execute(requests, DEFAULT_IO_QUEUE_DEPTH)) {
+      LOG(ERROR) << "I/O error while writing the free page bitmaps";
+    }
+  }
+  for (auto &request : requests) {
+    ExtendFileSize(request.offset_);
+  }
 }
 
 /*
@@ -138,45 +268,83 @@ page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
     return ( logical_page_id / BITMAP_SIZE ) + logical_page_id + 2;
 }
 
-int DiskManager::GetFileSize(const std::string &file_name) {
-  struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? stat_buf.st_size : -1;
+/**
+ * Aligned scratch page for O_DIRECT transfers whose caller buffer is not aligned, one per thread.
+ */
+static char *DirectIOBuffer() {
+  struct AlignedPage {
+    alignas(DiskManager::DIRECT_IO_ALIGNMENT) char data_[PAGE_SIZE];
+  };
+  thread_local AlignedPage buffer;
+  return buffer.data_;
 }
 
 void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-  int offset = physical_page_id * PAGE_SIZE;
+  uint64_t offset = static_cast<uint64_t>(physical_page_id) * PAGE_SIZE;
   // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
+  if (offset >= file_size_) {
 #ifdef ENABLE_BPM_DEBUG
     LOG(INFO) << "Read less than a page" << std::endl;
 #endif
     memset(page_data, 0, PAGE_SIZE);
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
+    return;
+  }
+  bool bounce = direct_io_ && reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0;
+  char *buffer = bounce ? DirectIOBuffer() : page_data;
+  ssize_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    ssize_t ret = pread(db_fd_, buffer + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret < 0) {
+      LOG(ERROR) << "I/O error while reading: " << strerror(errno);
+      break;
+    }
+    if (ret == 0) {
+      break;
+    }
+    read_count += ret;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
 #ifdef ENABLE_BPM_DEBUG
-      LOG(INFO) << "Read less than a page" << std::endl;
+    LOG(INFO) << "Read less than a page" << std::endl;
 #endif
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
-    }
+    memset(buffer + std::max<ssize_t>(read_count, 0), 0, PAGE_SIZE - std::max<ssize_t>(read_count, 0));
+  }
+  if (bounce) {
+    memcpy(page_data, buffer, PAGE_SIZE);
   }
 }
 
 void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG(ERROR) << "I/O error while writing";
-    return;
+  uint64_t offset = static_cast<uint64_t>(physical_page_id) * PAGE_SIZE;
+  const char *buffer = page_data;
+  if (direct_io_ && reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0) {
+    char *aligned = DirectIOBuffer();
+    memcpy(aligned, page_data, PAGE_SIZE);
+    buffer = aligned;
+  }
+  ssize_t write_count = 0;
+  while (write_count < PAGE_SIZE) {
+    ssize_t ret = pwrite(db_fd_, buffer + write_count, PAGE_SIZE - write_count, offset + write_count);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (ret < 0) {
+      LOG(ERROR) << "I/O error while writing: " << strerror(errno);
+      return;
+    }
+    write_count += ret;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
-}
\ No newline at end of file
+  ExtendFileSize(offset);
+}
+
+void DiskManager::ExtendFileSize(uint64_t offset) {
+  uint64_t end = offset + PAGE_SIZE;
+  uint64_t size = file_size_.load();
+  while (size < end && !file_size_.compare_exchange_weak(size, end)) {
+  }
+}
@@ -0,0 +1,190 @@
+#include "storage/free_space_map.h"
+
+#include "glog/logging.h"
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager)
+    : buffer_pool_manager_(buffer_pool_manager), buckets_(NUM_BUCKETS) {
+  page_id_t page_id;
+  Page *raw_page = buffer_pool_manager_->NewPage(page_id);
+  if (raw_page == nullptr) {
+    LOG(ERROR) << "No buffer for the first free space map page.";
+    return;
+  }
+  auto page = reinterpret_cast<FreeSpaceMapPage *>(raw_page->GetData());
+  page->Init();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  first_page_id_ = page_id;
+  map_pages_.push_back(page_id);
+}
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id)
+    : buffer_pool_manager_(buffer_pool_manager), first_page_id_(first_page_id), buckets_(NUM_BUCKETS) {
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+    Page *raw_page = buffer_pool_manager_->FetchPage(page_id);
+    if (raw_page == nullptr) {
+      // 只读到一部分的映射不能用，否则追加时会接在错误的映射页后面
+      LOG(ERROR) << "No buffer for free space map page " << page_id << ".";
+      map_pages_.clear();
+      entries_.clear();
+      chain_.clear();
+      buckets_.assign(NUM_BUCKETS, {});
+      last_page_id_ = INVALID_PAGE_ID;
+      total_free_space_ = 0;
+      return;
+    }
+    auto page = reinterpret_cast<FreeSpaceMapPage *>(raw_page->GetData());
+    auto map_index = static_cast<uint32_t>(map_pages_.size());
+    map_pages_.push_back(page_id);
+    for (uint32_t slot = 0; slot < page->GetCount(); slot++) {
+      page_id_t heap_page_id = page->PageIdAt(slot);
+      uint32_t free_space = page->FreeSpaceAt(slot);
+      chain_.push_back(heap_page_id);
+      if (heap_page_id == INVALID_PAGE_ID) {
+        continue;
+      }
+      entries_[heap_page_id] = {map_index, slot, free_space, free_space};
+      buckets_[BucketOf(free_space)].insert(heap_page_id);
+      total_free_space_ += free_space;
+      last_page_id_ = heap_page_id;
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+bool FreeSpaceMap::AddPage(page_id_t page_id, uint32_t free_space) {
+  if (!IsLoaded()) {
+    return false;
+  }
+  Page *raw_page = buffer_pool_manager_->FetchPage(map_pages_.back());
+  if (raw_page == nullptr) {
+    return false;
+  }
+  auto page = reinterpret_cast<FreeSpaceMapPage *>(raw_page->GetData());
+  if (page->IsFull()) {
+    // 当前映射页已满，链上一个新的映射页
+    page_id_t new_page_id;
+    Page *raw_new_page = buffer_pool_manager_->NewPage(new_page_id);
+    if (raw_new_page == nullptr) {
+      buffer_pool_manager_->UnpinPage(map_pages_.back(), false);
+      return false;
+    }
+    auto new_page = reinterpret_cast<FreeSpaceMapPage *>(raw_new_page->GetData());
+    new_page->Init();
+    page->SetNextPageId(new_page_id);
+    buffer_pool_manager_->UnpinPage(map_pages_.back(), true);
+    map_pages_.push_back(new_page_id);
+    page = new_page;
+  }
+  int slot = page->Append(page_id, free_space);
+  buffer_pool_manager_->UnpinPage(map_pages_.back(), true);
+  entries_[page_id] = {static_cast<uint32_t>(map_pages_.size() - 1), static_cast<uint32_t>(slot), free_space,
+                       free_space};
+  chain_.push_back(page_id);
+  buckets_[BucketOf(free_space)].insert(page_id);
+  total_free_space_ += free_space;
+  last_page_id_ = page_id;
+  return true;
+}
+
+bool FreeSpaceMap::Update(page_id_t page_id, uint32_t free_space) {
+  auto iter = entries_.find(page_id);
+  if (iter == entries_.end()) {
+    LOG(WARNING) << "Page " << page_id << " is not in the free space map.";
+    return false;
+  }
+  Entry &entry = iter->second;
+  uint32_t old_bucket = BucketOf(entry.free_space_);
+  uint32_t new_bucket = BucketOf(free_space);
+  total_free_space_ += free_space;
+  total_free_space_ -= entry.free_space_;
+  entry.free_space_ = free_space;
+  if (old_bucket != new_bucket) {
+    buckets_[old_bucket].erase(page_id);
+    buckets_[new_bucket].insert(page_id);
+  }
+  // 只有和映射页上记录的桶不同时才写回，上次没写成的也在这里补上
+  if (BucketOf(entry.stored_free_space_) == new_bucket) {
+    return true;
+  }
+  page_id_t map_page_id = map_pages_[entry.map_index_];
+  Page *raw_page = buffer_pool_manager_->FetchPage(map_page_id);
+  if (raw_page == nullptr) {
+    return false;
+  }
+  auto page = reinterpret_cast<FreeSpaceMapPage *>(raw_page->GetData());
+  page->SetFreeSpaceAt(entry.slot_, free_space);
+  buffer_pool_manager_->UnpinPage(map_page_id, true);
+  entry.stored_free_space_ = free_space;
+  return true;
+}
+
+bool FreeSpaceMap::RemovePage(page_id_t page_id) {
+  auto iter = entries_.find(page_id);
+  if (iter == entries_.end()) {
+    LOG(WARNING) << "Page " << page_id << " is not in the free space map.";
+    return false;
+  }
+  Entry entry = iter->second;
+  page_id_t map_page_id = map_pages_[entry.map_index_];
+  Page *raw_page = buffer_pool_manager_->FetchPage(map_page_id);
+  if (raw_page == nullptr) {
+    return false;
+  }
+  auto page = reinterpret_cast<FreeSpaceMapPage *>(raw_page->GetData());
+  page->RemoveAt(entry.slot_);
+  buffer_pool_manager_->UnpinPage(map_page_id, true);
+  buckets_[BucketOf(entry.free_space_)].erase(page_id);
+  total_free_space_ -= entry.free_space_;
+  entries_.erase(iter);
+  chain_[PositionOf(entry)] = INVALID_PAGE_ID;
+  if (page_id != last_page_id_) {
+    return true;
+  }
+  // 移除的是链尾，映射中排在最后的页成为新的链尾
+  last_page_id_ = INVALID_PAGE_ID;
+  for (auto chain_iter = chain_.rbegin(); chain_iter != chain_.rend(); ++chain_iter) {
+    if (*chain_iter != INVALID_PAGE_ID) {
+      last_page_id_ = *chain_iter;
+      break;
+    }
+  }
+  return true;
+}
+
+page_id_t FreeSpaceMap::FindPage(uint32_t size) const {
+  // 只看其中每一页都一定放得下的桶
+  for (uint32_t bucket = (size + BUCKET_WIDTH - 1) / BUCKET_WIDTH; bucket < NUM_BUCKETS; bucket++) {
+    if (!buckets_[bucket].empty()) {
+      return *buckets_[bucket].begin();
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+void FreeSpaceMap::GetNextPages(page_id_t page_id, size_t count, std::vector<page_id_t> *page_ids) const {
+  auto iter = entries_.find(page_id);
+  if (iter == entries_.end()) {
+    return;
+  }
+  // 跳过已移除页留下的空位
+  for (size_t position = PositionOf(iter->second) + 1; position < chain_.size() && count > 0; position++) {
+    if (chain_[position] != INVALID_PAGE_ID) {
+      page_ids->push_back(chain_[position]);
+      count--;
+    }
+  }
+}
+
+void FreeSpaceMap::Destroy() {
+  for (auto page_id : map_pages_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  map_pages_.clear();
+  entries_.clear();
+  chain_.clear();
+  buckets_.assign(NUM_BUCKETS, {});
+  last_page_id_ = INVALID_PAGE_ID;
+  total_free_space_ = 0;
+}
@@ -1,5 +1,7 @@
 #include "storage/table_heap.h"
 
+#include <algorithm>
+
 /**
  * TODO: Student Implement
  */
@@ -11,68 +13,187 @@ bool TableHeap::InsertTuple(Row &row, Txn *txn) {
     return false;
   }
 
-  // 在现有 page_free_space_ 中查找可容纳行的页面
-  auto page_iter = std::find_if(
-      page_free_space_.begin(), page_free_space_.end(),
-      [row_size](const auto &pair) {
-        return pair.second >= row_size + TablePage::SIZE_TUPLE;
-      });
-
-  TablePage *target_page = nullptr;
-
-  if (page_iter == page_free_space_.end()) {
-    // 没找到 → 创建新页
-    page_id_t new_page_id;
-    auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id));
-    if (new_page == nullptr) {
-      return false; // 创建失败
+  while (true) {
+    // 从空闲空间映射中找一个放得下的页，找不到就在链尾追加新页
+    page_id_t page_id = FindFreePage(row_size + TablePage::SIZE_TUPLE);
+    bool is_new_page = page_id == INVALID_PAGE_ID;
+    TablePage *target_page = nullptr;
+    if (is_new_page) {
+      target_page = AppendPage(txn);
+    } else {
+      target_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
     }
-
-    // 链接新页到链表尾
-    page_id_t prev_page_id = INVALID_PAGE_ID;
-    if (!page_free_space_.empty()) {
-      prev_page_id = page_free_space_.rbegin()->first;
+    if (target_page == nullptr) {
+      return false; // 缓冲池已满
     }
+    page_id = target_page->GetTablePageId();
+
+    // 插入行
+    target_page->WLatch();
+    bool insert_success = target_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    uint32_t free_space = target_page->GetFreeSpaceRemaining();
+    target_page->WUnlatch();
+
+    // 更新该页面的剩余空间记录
+    UpdateFreeSpace(page_id, free_space);
+    buffer_pool_manager_->UnpinPage(page_id, insert_success || is_new_page);
+    if (insert_success) {
+      return true;
+    }
+    if (is_new_page) {
+      // 空页也放不下
+      return false;
+    }
+  }
+}
 
-    new_page->Init(new_page_id, prev_page_id, log_manager_, txn);
-
-    // 如果存在前页，设置其 next_page_id
-    if (prev_page_id != INVALID_PAGE_ID) {
-      auto prev_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
-      prev_page->WLatch();
-      prev_page->SetNextPageId(new_page_id);
-      prev_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(prev_page_id, true);
+bool TableHeap::BulkInsert(std::vector<Row> &rows, Txn *txn) {
+  // 空页也放不下的行要在动手之前拒绝，免得插入一半再追加一个空页
+  for (auto &row : rows) {
+    if (row.GetSerializedSize(schema_) > TablePage::SIZE_MAX_ROW) {
+      return false;
+    }
+  }
+  if (rows.empty()) {
+    return true;
+  }
+  // 载入空闲空间映射后 last_page_id_ 才是准确的链尾
+  GetFreeSpaceMap();
+  // 从链尾开始顺序填充，当前页在填满之前一直保持 pin 和写锁
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id_));
+  if (page == nullptr) {
+    return false;
+  }
+  page->WLatch();
+  bool success = true;
+  for (auto &row : rows) {
+    if (page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
+      continue;
     }
+    // 当前页已满，链接新页后只在这里更新一次空闲空间映射
+    auto new_page = AppendPage(txn, page);
+    if (new_page == nullptr) {
+      success = false;  // 缓冲池已满
+      break;
+    }
+    UpdateFreeSpace(page->GetTablePageId(), page->GetFreeSpaceRemaining());
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+    page = new_page;
+    page->WLatch();
+    if (!page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
+      success = false;  // 空页也放不下
+      break;
+    }
+  }
+  UpdateFreeSpace(page->GetTablePageId(), page->GetFreeSpaceRemaining());
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  return success;
+}
 
-    // 更新 target_page 指针
-    target_page = new_page;
-  } else {
-    // 找到已有 page，直接取出来
-    target_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_iter->first));
+TablePage *TableHeap::AppendPage(Txn *txn, TablePage *tail) {
+  // 先载入空闲空间映射，它记录的链尾才是准确的
+  GetFreeSpaceMap();
+  // 从预留的连续页中取新页，使表页在磁盘上连续
+  page_id_t new_page_id;
+  auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id, &extent_));
+  if (new_page == nullptr) {
+    return nullptr;
+  }
+  page_id_t prev_page_id = last_page_id_;
+  new_page->Init(new_page_id, prev_page_id, log_manager_, txn);
+  // 先记进空闲空间映射，记不进去就不要这一页，免得链上有映射不知道的页
+  if (!AddToFreeSpaceMap(new_page_id, new_page->GetFreeSpaceRemaining())) {
+    buffer_pool_manager_->UnpinPage(new_page_id, false);
+    buffer_pool_manager_->DeletePage(new_page_id);
+    return nullptr;
   }
+  // 链接新页到链表尾
+  if (tail != nullptr) {
+    tail->SetNextPageId(new_page_id);
+  } else if (prev_page_id != INVALID_PAGE_ID) {
+    auto prev_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
+    prev_page->WLatch();
+    prev_page->SetNextPageId(new_page_id);
+    prev_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(prev_page_id, true);
+  }
+  last_page_id_ = new_page_id;
+  return new_page;
+}
 
-  // 插入行
-  target_page->WLatch();
-  bool insert_success = target_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
-  target_page->WUnlatch();
+FreeSpaceMap *TableHeap::GetFreeSpaceMap() {
+  std::scoped_lock<std::mutex> lock(free_space_latch_);
+  return LoadFreeSpaceMap(true);
+}
 
-  if (!insert_success) {
-    // 插入失败，释放页面
-    buffer_pool_manager_->UnpinPage(target_page->GetPageId(), false);
-    return false;
+FreeSpaceMap *TableHeap::LoadFreeSpaceMap(bool build) {
+  if (free_space_map_ != nullptr) {
+    return free_space_map_;
+  }
+  if (heap_meta_.free_space_map_page_id_ != INVALID_PAGE_ID) {
+    free_space_map_ = new FreeSpaceMap(buffer_pool_manager_, heap_meta_.free_space_map_page_id_);
+    last_page_id_ = free_space_map_->GetLastPageId();
+    return free_space_map_;
+  }
+  if (!build) {
+    return nullptr;
   }
+  // 没有空闲空间映射的旧表，遍历一次页链建立映射
+  free_space_map_ = new FreeSpaceMap(buffer_pool_manager_);
+  auto next_page_id = first_page_id_;
+  while (next_page_id != INVALID_PAGE_ID) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+    assert(page != nullptr);
+    free_space_map_->AddPage(next_page_id, page->GetFreeSpaceRemaining());
+    last_page_id_ = next_page_id;
+    next_page_id = page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(last_page_id_, false);
+  }
+  return free_space_map_;
+}
 
-  // 更新该页面的剩余空间记录
-  page_free_space_[target_page->GetTablePageId()] = target_page->GetFreeSpaceRemaining();
+page_id_t TableHeap::FindFreePage(uint32_t size) {
+  std::scoped_lock<std::mutex> lock(free_space_latch_);
+  return LoadFreeSpaceMap(true)->FindPage(size);
+}
 
-  // 释放页面
-  buffer_pool_manager_->UnpinPage(target_page->GetPageId(), true);
+void TableHeap::UpdateFreeSpace(page_id_t page_id, uint32_t free_space) {
+  std::scoped_lock<std::mutex> lock(free_space_latch_);
+  LoadFreeSpaceMap(true)->Update(page_id, free_space);
+}
 
-  return true;
+bool TableHeap::AddToFreeSpaceMap(page_id_t page_id, uint32_t free_space) {
+  std::scoped_lock<std::mutex> lock(free_space_latch_);
+  return LoadFreeSpaceMap(true)->AddPage(page_id, free_space);
 }
 
+bool TableHeap::RemoveFromFreeSpaceMap(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(free_space_latch_);
+  return LoadFreeSpaceMap(true)->RemovePage(page_id);
+}
+
+void TableHeap::GetNextPages(page_id_t page_id, size_t count, std::vector<page_id_t> *page_ids) {
+  std::scoped_lock<std::mutex> lock(free_space_latch_);
+  FreeSpaceMap *free_space_map = LoadFreeSpaceMap(false);
+  if (free_space_map != nullptr) {
+    free_space_map->GetNextPages(page_id, count, page_ids);
+  }
+}
 
+TableHeapMeta TableHeap::GetHeapMeta() {
+  std::scoped_lock<std::mutex> lock(free_space_latch_);
+  if (free_space_map_ == nullptr || !free_space_map_->IsLoaded()) {
+    return heap_meta_;
+  }
+  TableHeapMeta heap_meta;
+  heap_meta.free_space_map_page_id_ = free_space_map_->GetFirstPageId();
+  heap_meta.last_page_id_ = free_space_map_->GetLastPageId();
+  heap_meta.page_count_ = free_space_map_->GetPageCount();
+  heap_meta.free_space_ = free_space_map_->GetTotalFreeSpace();
+  return heap_meta;
+}
 
 bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
   // Find the page which contains the tuple.
@@ -109,6 +230,7 @@ bool TableHeap::UpdateTuple(Row &new_row, const RowId &rid, Txn *txn) {
   if (success) {
     // 更新成功，设置新记录的 RowId
     new_row.SetRowId(rid);
+    UpdateFreeSpace(rid.GetPageId(), page->GetFreeSpaceRemaining());
     page->WUnlatch();
     buffer_pool_manager_->UnpinPage(rid.GetPageId(), true);
     return true;
@@ -143,6 +265,7 @@ void TableHeap::ApplyDelete(const RowId &rid, Txn *txn) {
   // Step2: Delete the tuple from the page.
   page->WLatch();
   page->ApplyDelete(rid, txn, log_manager_);
+  UpdateFreeSpace(rid.GetPageId(), page->GetFreeSpaceRemaining());
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
@@ -181,6 +304,159 @@ bool TableHeap::GetTuple(Row *row, Txn *txn) {
   return success;
 }
 
+void TableHeap::GetStats(TableHeapStats *stats) {
+  *stats = TableHeapStats();
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    assert(page != nullptr);
+    page->RLatch();
+    stats->page_count_++;
+    for (uint32_t slot = 0; slot < page->GetTupleCount(); slot++) {
+      uint32_t tuple_size = page->GetTupleSize(slot);
+      if (tuple_size == 0) {
+        stats->empty_slot_count_++;
+      } else if (TablePage::IsDeleted(tuple_size)) {
+        stats->dead_tuple_count_++;
+        stats->dead_bytes_ += TablePage::UnsetDeletedFlag(tuple_size);
+      } else {
+        stats->tuple_count_++;
+        stats->live_bytes_ += tuple_size;
+      }
+    }
+    stats->free_bytes_ += page->GetFreeSpaceRemaining();
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+void TableHeap::Vacuum(VacuumStats *stats, Txn *txn,
+                       const std::function<void(Row &row, const RowId &old_rid)> &on_move) {
+  *stats = VacuumStats();
+  // 上次还被 pin 着、只摘下了链表的空页，现在再试着归还
+  unlinked_pages_.erase(std::remove_if(unlinked_pages_.begin(), unlinked_pages_.end(),
+                                       [&](page_id_t page_id) {
+                                         if (!buffer_pool_manager_->DeletePage(page_id)) {
+                                           return false;
+                                         }
+                                         stats->bytes_reclaimed_ += PAGE_SIZE;
+                                         stats->pages_freed_++;
+                                         return true;
+                                       }),
+                        unlinked_pages_.end());
+  // 第一遍：清除已标记删除的元组并整理每一页，记下稀疏页
+  std::vector<page_id_t> sparse_pages;
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    assert(page != nullptr);
+    page->WLatch();
+    uint32_t old_free_space = page->GetFreeSpaceRemaining();
+    for (uint32_t slot = 0; slot < page->GetTupleCount(); slot++) {
+      uint32_t tuple_size = page->GetTupleSize(slot);
+      if (tuple_size != 0 && TablePage::IsDeleted(tuple_size)) {
+        page->ApplyDelete(RowId(page_id, slot), txn, log_manager_);
+        stats->dead_tuples_removed_++;
+      }
+    }
+    page->Compact();
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    stats->bytes_reclaimed_ += free_space - old_free_space;
+    UpdateFreeSpace(page_id, free_space);
+    uint32_t used_space = PAGE_SIZE - TablePage::SIZE_TABLE_PAGE_HEADER - free_space;
+    if (page_id != first_page_id_ && used_space <= VACUUM_SPARSE_BYTES) {
+      sparse_pages.push_back(page_id);
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, free_space != old_free_space);
+    page_id = next_page_id;
+  }
+
+  // 第二遍：从链尾开始把稀疏页中的元组搬到更满的页里，搬空的页归还给磁盘
+  for (auto iter = sparse_pages.rbegin(); iter != sparse_pages.rend(); ++iter) {
+    page_id_t page_id = *iter;
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    assert(page != nullptr);
+    page->WLatch();
+    // 暂时把本页记为没有空间，免得元组又被搬回本页
+    UpdateFreeSpace(page_id, 0);
+    bool moved_all = true;
+    for (uint32_t slot = 0; slot < page->GetTupleCount() && moved_all; slot++) {
+      if (TablePage::IsDeleted(page->GetTupleSize(slot))) {
+        continue;
+      }
+      RowId old_rid(page_id, slot);
+      Row row(old_rid);
+      page->GetTuple(&row, schema_, txn, lock_manager_);
+      uint32_t row_size = page->GetTupleSize(slot);
+      moved_all = false;
+      for (page_id_t target_id = FindFreePage(row_size + TablePage::SIZE_TUPLE); target_id != INVALID_PAGE_ID;
+           target_id = FindFreePage(row_size + TablePage::SIZE_TUPLE)) {
+        auto target = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(target_id));
+        if (target == nullptr) {
+          break;
+        }
+        target->WLatch();
+        moved_all = target->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+        UpdateFreeSpace(target_id, target->GetFreeSpaceRemaining());
+        target->WUnlatch();
+        buffer_pool_manager_->UnpinPage(target_id, moved_all);
+        if (moved_all) {
+          break;
+        }
+      }
+      if (moved_all) {
+        page->ApplyDelete(old_rid, txn, log_manager_);
+        stats->tuples_moved_++;
+        if (on_move != nullptr) {
+          on_move(row, old_rid);
+        }
+      }
+    }
+    page_id_t prev_page_id = page->GetPrevPageId();
+    page_id_t next_page_id = page->GetNextPageId();
+    if (!moved_all || !RemoveFromFreeSpaceMap(page_id)) {
+      // 其余页放不下了，或者映射页读不进来，本页留在链上
+      page->Compact();
+      UpdateFreeSpace(page_id, page->GetFreeSpaceRemaining());
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page_id, true);
+      continue;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    if (UnlinkPage(page_id, prev_page_id, next_page_id)) {
+      stats->bytes_reclaimed_ += PAGE_SIZE;
+      stats->pages_freed_++;
+    }
+  }
+}
+
+bool TableHeap::UnlinkPage(page_id_t page_id, page_id_t prev_page_id, page_id_t next_page_id) {
+  auto prev_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
+  prev_page->WLatch();
+  prev_page->SetNextPageId(next_page_id);
+  prev_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(prev_page_id, true);
+  if (next_page_id != INVALID_PAGE_ID) {
+    auto next_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+    next_page->WLatch();
+    next_page->SetPrevPageId(prev_page_id);
+    next_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(next_page_id, true);
+  }
+  if (last_page_id_ == page_id) {
+    last_page_id_ = prev_page_id;
+  }
+  if (buffer_pool_manager_->DeletePage(page_id)) {
+    return true;
+  }
+  // 还有迭代器停在这一页上，它仍能顺着本页的 next 走下去；等没人 pin 时再删
+  unlinked_pages_.push_back(page_id);
+  return false;
+}
+
 void TableHeap::DeleteTable(page_id_t page_id) {
   if (page_id != INVALID_PAGE_ID) {
     auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));  // 删除table_heap
@@ -190,6 +466,12 @@ void TableHeap::DeleteTable(page_id_t page_id) {
     buffer_pool_manager_->DeletePage(page_id);
   } else {
     DeleteTable(first_page_id_);
+    for (page_id_t unlinked_page_id : unlinked_pages_) {
+      buffer_pool_manager_->DeletePage(unlinked_page_id);
+    }
+    unlinked_pages_.clear();
+    std::scoped_lock<std::mutex> lock(free_space_latch_);
+    LoadFreeSpaceMap(true)->Destroy();
   }
 }
 
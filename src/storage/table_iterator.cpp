@@ -1,43 +1,42 @@
 #include "storage/table_iterator.h"
 
+#include <algorithm>
+
 #include "common/macros.h"
 #include "storage/table_heap.h"
 
 TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn)
     : table_heap_(table_heap), current_rid_(rid), txn_(txn), current_row_(nullptr) {
-      if (current_rid_ == RowId{0}) {
-        auto page_id = table_heap_->GetFirstPageId();
-        if (page_id == INVALID_PAGE_ID) {
-          current_rid_ = RowId{-1};
-          return;
-        }
-        // get first page
-        auto page = reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(page_id));
-        if (page == nullptr) {
-          DLOG(ERROR) << "Failed to fetch page";
-        }
-        // get first rid
-        auto got = page->GetFirstTupleRid(&current_rid_);
-        table_heap_->buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
-        if (!got) {
-          //DLOG(ERROR) << "No tuple found in first table";
-          current_rid_ = RowId{-1};
-        }
-      } 
+  if (table_heap_ == nullptr || current_rid_ == RowId{-1}) {
+    return;
+  }
+  if (current_rid_ == RowId{0}) {
+    // get first page
+    SeekFrom(table_heap_->GetFirstPageId());
+  } else if (current_rid_.GetPageId() != INVALID_PAGE_ID && PinPage(current_rid_.GetPageId())) {
+    LoadSlots();
+  }
 }
 
 TableIterator::TableIterator(const TableIterator &other)
-    : table_heap_(other.table_heap_), current_rid_(other.current_rid_), txn_(other.txn_), current_row_(nullptr) {
+    : table_heap_(other.table_heap_),
+      current_rid_(other.current_rid_),
+      txn_(other.txn_),
+      current_row_(nullptr),
+      read_ahead_(other.read_ahead_),
+      slots_(other.slots_),
+      slot_idx_(other.slot_idx_) {
+  if (other.page_ != nullptr) {
+    PinPage(other.page_->GetTablePageId());
+  }
   if (other.current_row_ != nullptr) {
     current_row_ = new Row(*other.current_row_);
   }
 }
 
 TableIterator::~TableIterator() {
-  if (current_row_ != nullptr) {
-    delete current_row_;
-    current_row_ = nullptr;
-  }
+  ResetCurrent();
+  ReleasePage();
 }
 
 bool TableIterator::operator==(const TableIterator &itr) const {
@@ -50,64 +49,140 @@ bool TableIterator::operator!=(const TableIterator &itr) const {
 
 const Row &TableIterator::operator*() {
   if (current_row_ == nullptr) {
-    current_row_ = new Row(current_rid_);  // 分配新的 Row 对象
-    table_heap_->GetTuple(current_row_, txn_);  // 填充 Row 数据
+    current_row_ = new Row(current_rid_);  // 每条记录只反序列化一次
+    const TupleView &view = GetTupleView();
+    if (view.IsValid()) {
+      view.ToRow(current_row_);
+    }
   }
   return *current_row_;  // 返回引用
 }
 
 Row *TableIterator::operator->() {
-  Row *row = new Row(current_rid_);
-  table_heap_->GetTuple(row, txn_);
-  return row;
+  return const_cast<Row *>(&operator*());
 }
 
 TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
   if (this != &itr) {
+    ResetCurrent();
     table_heap_ = itr.table_heap_;
     current_rid_ = itr.current_rid_;
     txn_ = itr.txn_;
-    
+    read_ahead_ = itr.read_ahead_;
+    slots_ = itr.slots_;
+    slot_idx_ = itr.slot_idx_;
+    if (itr.page_ != nullptr) {
+      PinPage(itr.page_->GetTablePageId());
+    } else {
+      ReleasePage();
+    }
   }
   return *this;
 }
 
+const TupleView &TableIterator::GetTupleView() {
+  if (!view_.IsValid() && page_ != nullptr && current_rid_.GetPageId() == page_->GetTablePageId()) {
+    page_->RLatch();
+    view_.Reset(page_->GetTupleData(current_rid_.GetSlotNum()), table_heap_->schema_);
+    page_->RUnlatch();
+  }
+  return view_;
+}
+
 // ++iter
 TableIterator &TableIterator::operator++() {
-  if (current_row_ != nullptr) {
-    delete current_row_;  // 释放当前行
-    current_row_ = nullptr;
+  ResetCurrent();
+  if (page_ == nullptr) {
+    if (!PinPage(current_rid_.GetPageId())) {
+      current_rid_ = RowId{-1};
+      return *this;
+    }
+    LoadSlots();
   }
-
-  auto page = reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(current_rid_.GetPageId()));
-  if (page == nullptr) {
-    DLOG(ERROR) << "Failed to fetch page";
+  // 从给定 RowId 开始且该槽已无记录时，slot_idx_ 已经指向其后的第一条记录
+  if (slot_idx_ < slots_.size() && slots_[slot_idx_] != current_rid_.GetSlotNum()) {
+    current_rid_.Set(page_->GetTablePageId(), slots_[slot_idx_]);
+    return *this;
   }
-  bool is_next = page->GetNextTupleRid(current_rid_, &current_rid_);
-  table_heap_->buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
-  if (is_next) {
+  // 在当前页的槽号副本内前进，不访问页面
+  if (slot_idx_ + 1 < slots_.size()) {
+    current_rid_.Set(page_->GetTablePageId(), slots_[++slot_idx_]);
     return *this;
   }
   // get next page
-  if (page->GetNextPageId() == INVALID_PAGE_ID) {
-    current_rid_ = RowId{-1};
-    return *this;
+  page_->RLatch();
+  page_id_t next_page_id = page_->GetNextPageId();
+  page_->RUnlatch();
+  SeekFrom(next_page_id);
+  return *this;
+}
+
+// iter++
+TableIterator TableIterator::operator++(int) {
+  TableIterator temp(*this);
+  ++(*this);
+  return temp;
+}
+
+bool TableIterator::PinPage(page_id_t page_id) {
+  if (page_ != nullptr && page_->GetTablePageId() == page_id) {
+    return true;
   }
-  page = reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(page->GetNextPageId()));
-  if (page == nullptr) {
+  ReleasePage();
+  page_ = reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(page_id));
+  if (page_ == nullptr) {
     DLOG(ERROR) << "Failed to fetch page";
+    return false;
   }
-  // get first rid
-  bool is_first = page->GetFirstTupleRid(&current_rid_);
-  table_heap_->buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
-  if (!is_first) current_rid_ = RowId{-1};
-  return *this;
+  return true;
 }
 
+void TableIterator::ReleasePage() {
+  if (page_ != nullptr) {
+    table_heap_->buffer_pool_manager_->UnpinPage(page_->GetTablePageId(), false);
+    page_ = nullptr;
+  }
+}
 
-// iter++
-TableIterator TableIterator::operator++(int) {
-  TableIterator temp(*this); 
-  ++(*this); 
-  return temp; 
+void TableIterator::SeekFrom(page_id_t page_id) {
+  // 跳过没有有效记录的页（例如 Vacuum 清空后尚未回收的页）
+  while (page_id != INVALID_PAGE_ID) {
+    // 跨页时通知缓冲池，按表堆的链序预读它自己的页
+    table_heap_->buffer_pool_manager_->ReadAhead(
+        &read_ahead_, page_id, [this](page_id_t from, size_t count, std::vector<page_id_t> *page_ids) {
+          table_heap_->GetNextPages(from, count, page_ids);
+        });
+    if (!PinPage(page_id)) {
+      break;
+    }
+    LoadSlots();
+    if (!slots_.empty()) {
+      current_rid_.Set(page_id, slots_[0]);
+      return;
+    }
+    page_->RLatch();
+    page_id = page_->GetNextPageId();
+    page_->RUnlatch();
+  }
+  ReleasePage();
+  current_rid_ = RowId{-1};
+}
+
+void TableIterator::LoadSlots() {
+  page_->RLatch();
+  page_->GetLiveSlots(&slots_);
+  page_->RUnlatch();
+  // 定位到不早于 current_rid_ 的第一个有效槽
+  slot_idx_ = 0;
+  if (current_rid_.GetPageId() == page_->GetTablePageId()) {
+    slot_idx_ = std::lower_bound(slots_.begin(), slots_.end(), current_rid_.GetSlotNum()) - slots_.begin();
+  }
+}
+
+void TableIterator::ResetCurrent() {
+  if (current_row_ != nullptr) {
+    delete current_row_;  // 释放当前行
+    current_row_ = nullptr;
+  }
+  view_.Reset(nullptr, nullptr);
 }
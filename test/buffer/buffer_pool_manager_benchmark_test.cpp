@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+static const std::string bench_db_name = "bpm_bench_test.db";
+
+/**
+ * Run num_threads workers that each fetch, check and unpin random pages, and return the throughput in ops/s.
+ * Every page stores its own page id at offset 0 so that a wrong mapping or a lost write-back is detected.
+ */
+static double RunFetchUnpinWorkload(BufferPoolManager *bpm, const std::vector<page_id_t> &page_ids,
+                                    size_t num_threads, size_t ops_per_thread) {
+  std::vector<std::thread> workers;
+  std::vector<size_t> failures(num_threads, 0);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    workers.emplace_back([&, t]() {
+      std::default_random_engine rng(t);
+      std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        page_id_t page_id = page_ids[dist(rng)];
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          failures[t]++;
+          continue;
+        }
+        page->RLatch();
+        if (*reinterpret_cast<page_id_t *>(page->GetData()) != page_id) {
+          failures[t]++;
+        }
+        page->RUnlatch();
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  for (size_t t = 0; t < num_threads; t++) {
+    EXPECT_EQ(0, failures[t]);
+  }
+  return static_cast<double>(num_threads * ops_per_thread) / elapsed;
+}
+
+static std::vector<page_id_t> PreparePages(BufferPoolManager *bpm, size_t num_pages) {
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(page_id);
+    EXPECT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id_t));
+    bpm->UnpinPage(page_id, true);
+    page_ids.push_back(page_id);
+  }
+  return page_ids;
+}
+
+TEST(BufferPoolManagerBenchmarkTest, ConcurrentFetchUnpinTest) {
+  const size_t num_pages = 512;
+  const size_t num_threads = 4;
+  const size_t ops_per_thread = 20000;
+  for (size_t num_instances : {1, 8}) {
+    remove(bench_db_name.c_str());
+    auto *disk_manager = new DiskManager(bench_db_name);
+    auto *bpm = new BufferPoolManager(num_pages, disk_manager, num_instances);
+    auto page_ids = PreparePages(bpm, num_pages);
+    double throughput = RunFetchUnpinWorkload(bpm, page_ids, num_threads, ops_per_thread);
+    std::cout << "instances: " << num_instances << ", threads: " << num_threads << ", resident fetch/unpin: "
+              << static_cast<size_t>(throughput) << " ops/s" << std::endl;
+    ASSERT_TRUE(bpm->CheckAllUnpinned());
+    delete bpm;
+    disk_manager->Close();
+    delete disk_manager;
+  }
+  remove(bench_db_name.c_str());
+}
+
+TEST(BufferPoolManagerBenchmarkTest, ConcurrentEvictionTest) {
+  const size_t num_pages = 512;
+  const size_t pool_size = 64;
+  const size_t num_threads = 4;
+  const size_t ops_per_thread = 5000;
+  for (size_t num_instances : {1, 8}) {
+    remove(bench_db_name.c_str());
+    auto *disk_manager = new DiskManager(bench_db_name);
+    auto *bpm = new BufferPoolManager(pool_size, disk_manager, num_instances);
+    auto page_ids = PreparePages(bpm, num_pages);
+    double throughput = RunFetchUnpinWorkload(bpm, page_ids, num_threads, ops_per_thread);
+    std::cout << "instances: " << num_instances << ", threads: " << num_threads << ", evicting fetch/unpin: "
+              << static_cast<size_t>(throughput) << " ops/s" << std::endl;
+    ASSERT_TRUE(bpm->CheckAllUnpinned());
+    delete bpm;
+    disk_manager->Close();
+    delete disk_manager;
+  }
+  remove(bench_db_name.c_str());
+}
@@ -1,11 +1,44 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
 #include <cstdio>
+#include <cstdlib>
 #include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
+/**
+ * @return the descriptor this process has open on file_name, -1 if none
+ */
+static int FindOpenFile(const std::string &file_name) {
+  char path[PATH_MAX];
+  if (realpath(file_name.c_str(), path) == nullptr) {
+    return -1;
+  }
+  int found = -1;
+  DIR *dir = opendir("/proc/self/fd");
+  for (dirent *entry = readdir(dir); entry != nullptr && found < 0; entry = readdir(dir)) {
+    char link[PATH_MAX];
+    std::string fd_path = std::string("/proc/self/fd/") + entry->d_name;
+    ssize_t len = readlink(fd_path.c_str(), link, sizeof(link) - 1);
+    if (len > 0) {
+      link[len] = '\0';
+      found = strcmp(link, path) == 0 ? atoi(entry->d_name) : -1;
+    }
+  }
+  closedir(dir);
+  return found;
+}
+
 TEST(BufferPoolManagerTest, BinaryDataTest) {
   const std::string db_name = "bpm_test.db";
   const size_t buffer_pool_size = 10;
@@ -71,4 +104,291 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+TEST(BufferPoolManagerTest, BackgroundFlushTest) {
+  const std::string db_name = "bpm_flush_test.db";
+  const size_t buffer_pool_size = 50;
+  const size_t num_pages = 40;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+
+  // Scenario: dirty 40 of the 50 frames, keeping the last one pinned.
+  for (size_t i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    if (i + 1 < num_pages) {
+      bpm->UnpinPage(page_id, true);
+    }
+  }
+  // the pinned page only becomes dirty when it is unpinned
+  EXPECT_EQ(num_pages - 1, bpm->GetDirtyCount());
+
+  // Scenario: the flusher writes back unpinned dirty pages until the dirty ratio drops to the low watermark.
+  bpm->StartFlusher(std::chrono::milliseconds(5), 0.5, 0.1);
+  for (int i = 0; i < 400 && bpm->GetDirtyCount() > 5; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  bpm->StopFlusher();
+  EXPECT_EQ(5, bpm->GetDirtyCount());
+
+  // Scenario: the flushed pages are on disk, lowest page ids first; the pinned page was not touched.
+  char buffer[PAGE_SIZE];
+  char expected[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(num_pages) - 1 - 5; ++page_id) {
+    disk_manager->ReadPage(page_id, buffer);
+    snprintf(expected, PAGE_SIZE, "page %d", page_id);
+    EXPECT_STREQ(expected, buffer);
+  }
+  disk_manager->ReadPage(num_pages - 1, buffer);
+  EXPECT_STREQ("", buffer);
+  EXPECT_TRUE(bpm->UnpinPage(num_pages - 1, true));
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ReadAheadTest) {
+  const std::string db_name = "bpm_read_ahead_test.db";
+  const size_t buffer_pool_size = 64;
+  const page_id_t num_pages = 40;
+  const page_id_t num_object_pages = 30;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+  delete bpm;
+  // the scanned object owns the first pages in an order unrelated to their ids, the rest belong to others
+  std::vector<page_id_t> object_pages;
+  for (page_id_t i = 0; i < num_object_pages; ++i) {
+    object_pages.push_back(i * 7 % num_object_pages);
+  }
+  NextPagesFunc next_pages = [&](page_id_t page_id, size_t count, vector<page_id_t> *page_ids) {
+    auto iter = std::find(object_pages.begin(), object_pages.end(), page_id);
+    for (++iter; iter != object_pages.end() && count > 0; ++iter, --count) {
+      page_ids->push_back(*iter);
+    }
+  };
+
+  // Scenario: a cursor following the object's page order triggers read-ahead with a growing window.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  ReadAheadState state;
+  char expected[PAGE_SIZE];
+  for (size_t i = 0; i < object_pages.size(); ++i) {
+    page_id_t page_id = object_pages[i];
+    bpm->ReadAhead(&state, page_id, next_pages);
+    if (i > 0 && i + 1 < object_pages.size()) {
+      EXPECT_GT(state.ahead_, 0);
+    }
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", page_id);
+    EXPECT_STREQ(expected, page->GetData());
+    bpm->UnpinPage(page_id, false);
+  }
+  EXPECT_GT(state.window_, static_cast<size_t>(DEFAULT_READ_AHEAD_MIN_PAGES));
+
+  // Scenario: read-ahead stopped at the object's last page and brought in none of the other pages, so each
+  // instance holds exactly its half of the object's pages.
+  EXPECT_EQ(object_pages.back(), state.last_prefetched_id_);
+  EXPECT_EQ(0, state.ahead_);
+  size_t per_instance = num_object_pages / 2;
+  EXPECT_EQ(2 * (buffer_pool_size / 2 - per_instance + per_instance / 4), bpm->GetReadAheadBudget());
+
+  // Scenario: a jump resets the window.
+  bpm->ReadAhead(&state, object_pages[3], next_pages);
+  EXPECT_EQ(0, state.window_);
+  EXPECT_EQ(INVALID_PAGE_ID, state.last_prefetched_id_);
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, PrefetchIOErrorTest) {
+  const std::string db_name = "bpm_prefetch_error_test.db";
+  const size_t buffer_pool_size = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (page_id_t i = 0; i < 2; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+  delete bpm;
+  int db_fd = FindOpenFile(db_name);
+  ASSERT_GE(db_fd, 0);
+  int saved_fd = dup(db_fd);
+  ASSERT_GE(saved_fd, 0);
+
+  // Scenario: reads that fail leave nothing cached, so the next FetchPage reads the page itself.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  int write_only_fd = open(db_name.c_str(), O_WRONLY);
+  ASSERT_GE(write_only_fd, 0);
+  dup2(write_only_fd, db_fd);
+  EXPECT_EQ(0, bpm->PrefetchPages({0, 1}));
+  dup2(saved_fd, db_fd);
+  EXPECT_EQ(buffer_pool_size, bpm->GetReadAheadBudget());
+  auto *page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("page 0", page->GetData());
+  snprintf(page->GetData(), PAGE_SIZE, "dirty 0");
+  bpm->UnpinPage(0, true);
+  delete bpm;
+
+  // Scenario: a dirty victim whose write-back fails stays cached and dirty instead of being overwritten.
+  bpm = new BufferPoolManager(1, disk_manager);
+  page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "dirty again 0");
+  bpm->UnpinPage(0, true);
+  int read_only_fd = open(db_name.c_str(), O_RDONLY);
+  ASSERT_GE(read_only_fd, 0);
+  dup2(read_only_fd, db_fd);
+  EXPECT_EQ(0, bpm->PrefetchPages({1}));
+  dup2(saved_fd, db_fd);
+  page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("dirty again 0", page->GetData());
+  bpm->UnpinPage(0, false);
+  delete bpm;
+  bpm = new BufferPoolManager(1, disk_manager);
+  page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("dirty again 0", page->GetData());
+  bpm->UnpinPage(0, false);
+  delete bpm;
+
+  close(write_only_fd);
+  close(read_only_fd);
+  close(saved_fd);
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ConcurrentColdFetchTest) {
+  const std::string db_name = "bpm_cold_fetch_test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_threads = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  auto *page = bpm->NewPage(page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "cold page");
+  bpm->UnpinPage(page_id, true);
+  delete bpm;
+
+  // Scenario: threads missing on the same page at the same moment share one read and one frame.
+  for (int round = 0; round < 20; round++) {
+    bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+    size_t reads_before = disk_manager->GetNumReads();
+    std::atomic<bool> start{false};
+    std::vector<Page *> fetched(num_threads, nullptr);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([&, i]() {
+        while (!start) {
+          std::this_thread::yield();
+        }
+        fetched[i] = bpm->FetchPage(page_id);
+      });
+    }
+    start = true;
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(reads_before + 1, disk_manager->GetNumReads());
+    for (auto *fetched_page : fetched) {
+      ASSERT_EQ(fetched[0], fetched_page);
+      EXPECT_STREQ("cold page", fetched_page->GetData());
+      bpm->UnpinPage(page_id, false);
+    }
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+    delete bpm;
+  }
+
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, FetchDuringDirtyEvictionTest) {
+  const std::string db_name = "bpm_dirty_eviction_test.db";
+
+  remove(db_name.c_str());
+  // with O_DIRECT the write-back blocks on the device, which gives the reader time to run during it
+  auto *disk_manager = new DiskManager(db_name, true);
+  // one of the three frames stays pinned, the other two are shared by the three pages below
+  auto *bpm = new BufferPoolManager(3, disk_manager);
+  page_id_t pinned_page_id, evicted_page_id, other_page_id, recent_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(pinned_page_id));
+  for (page_id_t *page_id : {&evicted_page_id, &other_page_id, &recent_page_id}) {
+    auto *page = bpm->NewPage(*page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "stale");
+    bpm->UnpinPage(*page_id, true);
+  }
+
+  // Scenario: a thread fetching a page while another thread evicts it dirty gets the bytes being written back,
+  // never the stale copy still on disk.
+  char expected[PAGE_SIZE];
+  for (int round = 0; round < 1000; round++) {
+    auto *page = bpm->FetchPage(evicted_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "round %d", round);
+    snprintf(page->GetData(), PAGE_SIZE, "%s", expected);
+    bpm->UnpinPage(evicted_page_id, true);
+    // touch another page so that the dirty page is the least recently used one
+    ASSERT_NE(nullptr, bpm->FetchPage(recent_page_id));
+    bpm->UnpinPage(recent_page_id, false);
+    std::atomic<bool> start{false};
+    std::thread evictor([&]() {
+      while (!start) {
+        std::this_thread::yield();
+      }
+      ASSERT_NE(nullptr, bpm->FetchPage(other_page_id));
+      bpm->UnpinPage(other_page_id, false);
+    });
+    std::string seen;
+    std::thread reader([&]() {
+      while (!start) {
+        std::this_thread::yield();
+      }
+      auto *evicted_page = bpm->FetchPage(evicted_page_id);
+      ASSERT_NE(nullptr, evicted_page);
+      seen = evicted_page->GetData();
+      bpm->UnpinPage(evicted_page_id, false);
+    });
+    start = true;
+    evictor.join();
+    reader.join();
+    ASSERT_EQ(expected, seen);
+  }
+
+  bpm->UnpinPage(pinned_page_id, false);
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
@@ -0,0 +1,58 @@
+#include "buffer/lru_k_replacer.h"
+
+#include "gtest/gtest.h"
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: unpin six elements, i.e. add them to the replacer. Frame 1 is accessed twice.
+  lru_k_replacer.Unpin(1);
+  lru_k_replacer.Unpin(2);
+  lru_k_replacer.Unpin(3);
+  lru_k_replacer.Unpin(4);
+  lru_k_replacer.Unpin(5);
+  lru_k_replacer.Unpin(6);
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with less than k accesses go first, in order of their first access.
+  int value;
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+
+  // Scenario: pin elements in the replacer.
+  // Note that 3 has already been victimized, so pinning 3 should have no effect.
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Pin(4);
+  lru_k_replacer.Pin(5);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+
+  // Scenario: 5 gets its second access, 6 still has one, so 6 goes first even though 1 is older.
+  lru_k_replacer.Unpin(5);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(6, value);
+  // 1 has the largest backward 2-distance among the frames with two accesses.
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+
+  // Scenario: a removed frame starts over without history.
+  lru_k_replacer.Unpin(1);
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  lru_k_replacer.Remove(1);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+  lru_k_replacer.Unpin(2);
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Unpin(2);
+  lru_k_replacer.Unpin(1);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+}
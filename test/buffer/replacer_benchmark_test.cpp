@@ -0,0 +1,93 @@
+#include <iostream>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "gtest/gtest.h"
+
+struct HitRatio {
+  size_t hot_hits_{0};
+  size_t hot_accesses_{0};
+  size_t hits_{0};
+  size_t accesses_{0};
+};
+
+/**
+ * Replay a page trace against a pool of pool_size frames managed by replacer, the same way
+ * BufferPoolManager drives it: a fetch pins the frame, the matching unpin releases it.
+ */
+static HitRatio Simulate(Replacer *replacer, size_t pool_size, const std::vector<page_id_t> &trace,
+                         page_id_t hot_pages) {
+  HitRatio ratio;
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frame_page(pool_size, INVALID_PAGE_ID);
+  size_t next_free = 0;
+  for (auto page_id : trace) {
+    bool hot = page_id < hot_pages;
+    ratio.accesses_++;
+    ratio.hot_accesses_ += hot;
+    frame_id_t frame_id;
+    auto iter = page_table.find(page_id);
+    if (iter != page_table.end()) {
+      frame_id = iter->second;
+      ratio.hits_++;
+      ratio.hot_hits_ += hot;
+    } else {
+      if (next_free < pool_size) {
+        frame_id = next_free++;
+      } else {
+        EXPECT_TRUE(replacer->Victim(&frame_id));
+        page_table.erase(frame_page[frame_id]);
+      }
+      page_table[page_id] = frame_id;
+      frame_page[frame_id] = page_id;
+    }
+    replacer->Pin(frame_id);
+    replacer->Unpin(frame_id);
+  }
+  return ratio;
+}
+
+TEST(ReplacerBenchmarkTest, PointLookupWithScanTest) {
+  const size_t pool_size = 256;
+  const page_id_t hot_pages = 128;   // e.g. B+ tree internal pages
+  const page_id_t table_pages = 4096;
+  const int rounds = 20;
+  const int lookups_per_round = 2000;
+
+  // Point lookups walk a hot index page and then one random heap page;
+  // every few rounds a full sequential scan runs over the whole table.
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<page_id_t> hot_dist(0, hot_pages - 1);
+  std::uniform_int_distribution<page_id_t> table_dist(hot_pages, hot_pages + table_pages - 1);
+  std::vector<page_id_t> trace;
+  for (int round = 0; round < rounds; round++) {
+    for (int i = 0; i < lookups_per_round; i++) {
+      trace.push_back(hot_dist(rng));
+      trace.push_back(table_dist(rng));
+    }
+    if (round % 4 == 0) {
+      for (page_id_t page_id = hot_pages; page_id < hot_pages + table_pages; page_id++) {
+        trace.push_back(page_id);
+      }
+    }
+  }
+
+  std::unordered_map<int, HitRatio> ratios;
+  std::vector<std::pair<ReplacerType, const char *>> policies{
+      {ReplacerType::kLRU, "LRU  "}, {ReplacerType::kClock, "CLOCK"}, {ReplacerType::kLRUK, "LRU-K"}};
+  for (auto &policy : policies) {
+    ReplacerType type = policy.first;
+    std::unique_ptr<Replacer> replacer(Replacer::Create(type, pool_size));
+    HitRatio ratio = Simulate(replacer.get(), pool_size, trace, hot_pages);
+    std::cout << policy.second << " hit ratio: "
+              << static_cast<double>(ratio.hits_) / ratio.accesses_ << ", hot page hit ratio: "
+              << static_cast<double>(ratio.hot_hits_) / ratio.hot_accesses_ << std::endl;
+    ratios[static_cast<int>(type)] = ratio;
+  }
+  // the scans must not flush the hot pages out of an LRU-K pool
+  EXPECT_GT(ratios[static_cast<int>(ReplacerType::kLRUK)].hot_hits_,
+            ratios[static_cast<int>(ReplacerType::kLRU)].hot_hits_);
+}
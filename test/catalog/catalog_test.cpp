@@ -39,6 +39,51 @@ TEST(CatalogTest, CatalogMetaTest) {
   delete other;
 }
 
+TEST(CatalogTest, TableMetadataTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  Schema schema(columns);
+  char buf[PAGE_SIZE];
+  // Scenario: the heap summary survives a round trip.
+  TableHeapMeta heap_meta;
+  heap_meta.free_space_map_page_id_ = 7;
+  heap_meta.last_page_id_ = 42;
+  heap_meta.page_count_ = 3;
+  heap_meta.free_space_ = 1000;
+  TableMetadata *meta = TableMetadata::Create(5, "table-1", 11, Schema::DeepCopySchema(&schema), heap_meta);
+  uint32_t size = meta->SerializeTo(buf);
+  delete meta;
+  meta = nullptr;
+  ASSERT_EQ(size, TableMetadata::DeserializeFrom(buf, meta));
+  EXPECT_EQ(7, meta->GetHeapMeta().free_space_map_page_id_);
+  EXPECT_EQ(42, meta->GetHeapMeta().last_page_id_);
+  EXPECT_EQ(3, meta->GetHeapMeta().page_count_);
+  EXPECT_EQ(1000, meta->GetHeapMeta().free_space_);
+  delete meta;
+
+  // Scenario: metadata written before the summary was stored still loads, without a summary, so the heap
+  // rebuilds its free space map from the page chain.
+  char *p = buf;
+  MACH_WRITE_UINT32(p, 344528);
+  p += 4;
+  MACH_WRITE_TO(table_id_t, p, 5);
+  p += 4;
+  MACH_WRITE_UINT32(p, 7);
+  p += 4;
+  MACH_WRITE_STRING(p, std::string("table-1"));
+  p += 7;
+  MACH_WRITE_TO(page_id_t, p, 11);
+  p += 4;
+  p += schema.SerializeTo(p);
+  meta = nullptr;
+  ASSERT_EQ(p - buf, TableMetadata::DeserializeFrom(buf, meta));
+  EXPECT_EQ("table-1", meta->GetTableName());
+  EXPECT_EQ(11, meta->GetFirstPageId());
+  EXPECT_EQ(2, meta->GetSchema()->GetColumnCount());
+  EXPECT_EQ(INVALID_PAGE_ID, meta->GetHeapMeta().free_space_map_page_id_);
+  delete meta;
+}
+
 TEST(CatalogTest, CatalogTableTest) {
   /** Stage 2: Testing simple operation */
   auto db_01 = new DBStorageEngine(db_file_name, true);
@@ -91,6 +136,9 @@ TEST(CatalogTest, CatalogIndexTest) {
   ASSERT_EQ(DB_COLUMN_NAME_NOT_EXIST, r2);
   auto r3 = catalog_01->CreateIndex("table-1", "index-1", index_keys, &txn, index_info, "bptree");
   ASSERT_EQ(DB_SUCCESS, r3);
+  IndexInfo *name_index_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog_01->CreateIndex("table-1", "index-2", {"name"}, &txn, name_index_info, "bptree",
+                                                false));
   for (int i = 0; i < 10; i++) {
     std::vector<Field> fields{Field(TypeId::kTypeInt, i),
                               Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
@@ -116,6 +164,10 @@ TEST(CatalogTest, CatalogIndexTest) {
   ASSERT_EQ(DB_INDEX_ALREADY_EXIST, r4);
   IndexInfo *index_info_02 = nullptr;
   ASSERT_EQ(DB_SUCCESS, catalog_02->GetIndex("table-1", "index-1", index_info_02));
+  ASSERT_TRUE(index_info_02->GetIndex()->IsUnique());
+  ASSERT_EQ(DB_SUCCESS, catalog_02->GetIndex("table-1", "index-2", index_info_02));
+  ASSERT_FALSE(index_info_02->GetIndex()->IsUnique());
+  ASSERT_EQ(DB_SUCCESS, catalog_02->GetIndex("table-1", "index-1", index_info_02));
   std::vector<RowId> ret_02;
   for (int i = 0; i < 10; i++) {
     std::vector<Field> fields{Field(TypeId::kTypeInt, i),
@@ -2,10 +2,12 @@
 // Created by njz on 2023/1/26.
 //
 #include "executor/plans/delete_plan.h"
+#include "executor/plans/index_scan_plan.h"
 #include "executor/plans/insert_plan.h"
 #include "executor/plans/seq_scan_plan.h"
 #include "executor/plans/update_plan.h"
 #include "executor/plans/values_plan.h"
+#include "planner/expressions/logic_expression.h"
 #include "executor_test_util.h"  // NOLINT
 
 // SELECT id FROM table-1 WHERE id < 500
@@ -112,6 +114,96 @@ TEST_F(ExecutorTest, SimpleRawInsertTest) {
   ASSERT_TRUE(result_set[0].GetField(2)->CompareEquals(Field(kTypeFloat, static_cast<float>(2.33))));
 }
 
+// INSERT INTO table-1 VALUES (1001, "aaa", 2.33), (1002, "bbb", 2.33), (1001, "ccc", 2.33), (1003, "ddd", 2.33);
+TEST_F(ExecutorTest, MultiRowInsertTest) {
+  IndexInfo *index_info = nullptr;
+  std::vector<std::string> index_keys{"id"};
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateIndex("table-1", "index-1", index_keys, GetTxn(),
+                                                                        index_info, "bptree"));
+  std::vector<std::vector<AbstractExpressionRef>> raw_values;
+  for (auto id : {1001, 1002, 1001, 1003}) {
+    raw_values.push_back({MakeConstantValueExpression(Field(kTypeInt, id)),
+                          MakeConstantValueExpression(Field(kTypeChar, const_cast<char *>("aaa"), 3, false)),
+                          MakeConstantValueExpression(Field(kTypeFloat, static_cast<float>(2.33)))});
+  }
+  auto value_plan = std::make_shared<ValuesPlanNode>(nullptr, raw_values);
+  auto insert_plan = std::make_shared<InsertPlanNode>(nullptr, value_plan, "table-1");
+
+  // The whole list goes through one InsertExecutor, which reports the duplicate key and stores none of the rows.
+  std::vector<Row> result_set{};
+  ASSERT_EQ(DB_FAILED, GetExecutionEngine()->ExecutePlan(insert_plan, &result_set, GetTxn(), GetExecutorContext()));
+
+  // SELECT * FROM table-1 where id > 1000;
+  TableInfo *table_info;
+  GetExecutorContext()->GetCatalog()->GetTable("table-1", table_info);
+  const Schema *schema = table_info->GetSchema();
+  auto col_a = MakeColumnValueExpression(*schema, 0, "id");
+  auto const1000 = MakeConstantValueExpression(Field(kTypeInt, 1000));
+  auto predicate = MakeComparisonExpression(col_a, const1000, ">");
+  auto scan_plan = make_shared<SeqScanPlanNode>(schema, table_info->GetTableName(), predicate);
+  result_set.clear();
+  GetExecutionEngine()->ExecutePlan(scan_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(0, result_set.size());
+  for (auto id : {1001, 1002, 1003}) {
+    std::vector<Field> key_fields{Field(kTypeInt, id)};
+    Row key(key_fields);
+    std::vector<RowId> rids;
+    ASSERT_NE(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, rids, GetTxn()));
+  }
+
+  // Without the duplicate the same rows go in, and all of them are reachable through the index.
+  raw_values.erase(raw_values.begin() + 2);
+  value_plan = std::make_shared<ValuesPlanNode>(nullptr, raw_values);
+  insert_plan = std::make_shared<InsertPlanNode>(nullptr, value_plan, "table-1");
+  result_set.clear();
+  ASSERT_EQ(DB_SUCCESS, GetExecutionEngine()->ExecutePlan(insert_plan, &result_set, GetTxn(), GetExecutorContext()));
+  result_set.clear();
+  GetExecutionEngine()->ExecutePlan(scan_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(3, result_set.size());
+  for (auto id : {1001, 1002, 1003}) {
+    std::vector<Field> key_fields{Field(kTypeInt, id)};
+    Row key(key_fields);
+    std::vector<RowId> rids;
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, rids, GetTxn()));
+    ASSERT_EQ(1, rids.size());
+  }
+}
+
+// SELECT * FROM table-1 WHERE id >= 100 AND id < 200 AND account > 0, over an index on (id, account)
+TEST_F(ExecutorTest, CompositeIndexScanTest) {
+  IndexInfo *index_info = nullptr;
+  std::vector<std::string> index_keys{"id", "account"};
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateIndex("table-1", "index-1", index_keys, GetTxn(),
+                                                                        index_info, "bptree"));
+  TableInfo *table_info;
+  GetExecutorContext()->GetCatalog()->GetTable("table-1", table_info);
+  const Schema *schema = table_info->GetSchema();
+  auto col_id = MakeColumnValueExpression(*schema, 0, "id");
+  auto col_account = MakeColumnValueExpression(*schema, 0, "account");
+  auto id_range = make_shared<LogicExpression>(
+      MakeComparisonExpression(col_id, MakeConstantValueExpression(Field(kTypeInt, 100)), ">="),
+      MakeComparisonExpression(col_id, MakeConstantValueExpression(Field(kTypeInt, 200)), "<"), LogicType::And);
+  auto predicate = make_shared<LogicExpression>(
+      id_range, MakeComparisonExpression(col_account, MakeConstantValueExpression(Field(kTypeFloat, 0.f)), ">"),
+      LogicType::And);
+  auto seq_plan = make_shared<SeqScanPlanNode>(schema, table_info->GetTableName(), predicate);
+  std::vector<Row> expected{};
+  GetExecutionEngine()->ExecutePlan(seq_plan, &expected, GetTxn(), GetExecutorContext());
+  ASSERT_FALSE(expected.empty());
+
+  // The range on the leading column is read from the index, the condition on account is filtered.
+  std::vector<Field> start_fields{Field(kTypeInt, 100)};
+  std::vector<Field> stop_fields{Field(kTypeInt, 200)};
+  auto index_plan = make_shared<IndexScanPlanNode>(schema, table_info->GetTableName(), index_info, Row(start_fields),
+                                                   true, Row(stop_fields), false, true, predicate);
+  std::vector<Row> result_set{};
+  GetExecutionEngine()->ExecutePlan(index_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(expected.size(), result_set.size());
+  for (size_t i = 0; i < result_set.size(); i++) {
+    ASSERT_TRUE(result_set[i].GetField(0)->CompareEquals(*expected[i].GetField(0)));
+  }
+}
+
 // UPDATE table-1 SET name = "minisql" where id = 500;
 TEST_F(ExecutorTest, SimpleUpdateTest) {
   // Construct a sequential scan of the table
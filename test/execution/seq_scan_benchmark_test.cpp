@@ -0,0 +1,80 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/instance.h"
+#include "executor/executors/seq_scan_executor.h"
+#include "gtest/gtest.h"
+#include "utils/utils.h"
+
+static const std::string bench_db_name = "seq_scan_bench.db";
+
+/**
+ * Cold-cache SeqScanExecutor over a table of a few hundred pages: without read-ahead, and with the
+ * read-ahead batches issued at queue depth 1 and at queue depth 32. The database file is reopened
+ * with O_DIRECT for every run so that no page comes from the OS page cache.
+ */
+TEST(SeqScanBenchmarkTest, ColdScanQueueDepthTest) {
+  const int row_nums = 30000;
+  // Load the table
+  {
+    DBStorageEngine engine(bench_db_name, true);
+    std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                     new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                     new Column("account", TypeId::kTypeFloat, 2, true, false)};
+    auto schema = std::make_shared<Schema>(columns);
+    TableInfo *table_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, engine.catalog_mgr_->CreateTable("bench", schema.get(), nullptr, table_info));
+    TableHeap *table_heap = table_info->GetTableHeap();
+    char characters[64];
+    for (int i = 0; i < row_nums; i++) {
+      RandomUtils::RandomString(characters, 64);
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true),
+                                Field(TypeId::kTypeFloat, RandomUtils::RandomFloat(-999.f, 999.f))};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    }
+  }
+
+  // smaller than the table, so that the pages touched while opening the catalog are gone again when the scan starts
+  const size_t buffer_pool_size = 256;
+  struct RunConfig {
+    bool read_ahead_;
+    size_t queue_depth_;
+  };
+  for (auto config : {RunConfig{false, 1}, RunConfig{true, 1}, RunConfig{true, 32}}) {
+    auto *disk_mgr = new DiskManager("./databases/" + bench_db_name, true);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_mgr, DEFAULT_BUFFER_POOL_INSTANCES);
+    bpm->SetReadAhead(config.read_ahead_);
+    bpm->SetIOQueueDepth(config.queue_depth_);
+    auto *catalog = new CatalogManager(bpm, nullptr, nullptr, false);
+    TableInfo *table_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, catalog->GetTable("bench", table_info));
+    Schema *out_schema = Schema::ShallowCopySchema(table_info->GetSchema(), {0});
+    SeqScanPlanNode plan(out_schema, "bench", nullptr);
+    ExecuteContext context(nullptr, catalog, bpm);
+
+    auto start = std::chrono::steady_clock::now();
+    SeqScanExecutor executor(&context, &plan);
+    executor.Init();
+    Row row;
+    RowId rid;
+    int count = 0;
+    while (executor.Next(&row, &rid)) {
+      count++;
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::string name = config.read_ahead_ ? "read-ahead, queue depth " + std::to_string(config.queue_depth_)
+                                          : std::string("no read-ahead");
+    std::cout << name << (disk_mgr->IsDirectIO() ? " (O_DIRECT)" : " (buffered)") << ": cold seq scan " << elapsed
+              << " ms" << std::endl;
+    EXPECT_EQ(row_nums, count);
+
+    delete out_schema;
+    delete catalog;
+    delete bpm;
+    delete disk_mgr;
+  }
+  remove(("./databases/" + bench_db_name).c_str());
+}
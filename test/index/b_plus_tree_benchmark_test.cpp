@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/instance.h"
+#include "gtest/gtest.h"
+#include "index/b_plus_tree.h"
+#include "index/b_plus_tree_index.h"
+#include "utils/utils.h"
+
+static const std::string bench_db_name = "bp_tree_bench_test.db";
+
+/**
+ * Insert and point lookup throughput of BPlusTree on shuffled keys, once on an int key and once on a
+ * composite (int, char(16)) key. Every binary search step inside the pages goes through KeyManager::CompareKeys.
+ */
+TEST(BPlusTreeBenchmarkTest, InsertLookupTest) {
+  const int n = 50000;
+  struct KeyConfig {
+    std::string name_;
+    bool composite_;
+    size_t key_size_;
+  };
+  for (const auto &config : {KeyConfig{"int key", false, 16}, KeyConfig{"(int, char(16)) key", true, 32}}) {
+    DBStorageEngine engine(bench_db_name);
+    std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+    if (config.composite_) {
+      columns.push_back(new Column("name", TypeId::kTypeChar, 16, 1, false, false));
+    }
+    Schema key_schema(columns);
+    KeyManager KP(&key_schema, config.key_size_);
+    BPlusTree tree(0, engine.bpm_, KP);
+
+    std::vector<GenericKey *> keys;
+    char name[16];
+    for (int i = 0; i < n; i++) {
+      GenericKey *key = KP.InitKey();
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i / 4)};
+      if (config.composite_) {
+        // 前缀相同的键很多，比较常常要看到第二列
+        snprintf(name, sizeof(name), "name%011d", i);
+        fields.emplace_back(TypeId::kTypeChar, name, 15, true);
+      } else {
+        fields[0] = Field(TypeId::kTypeInt, i);
+      }
+      KP.SerializeFromKey(key, Row(fields), &key_schema);
+      keys.push_back(key);
+    }
+    ShuffleArray(keys);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+      ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+    }
+    auto insert_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ShuffleArray(keys);
+    start = std::chrono::steady_clock::now();
+    std::vector<RowId> result;
+    for (int i = 0; i < n; i++) {
+      result.clear();
+      ASSERT_TRUE(tree.GetValue(keys[i], result));
+    }
+    auto lookup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << config.name_ << ": " << n << " inserts in " << insert_ms << " ms (" << n / insert_ms * 1000
+              << " ops/s), " << n << " lookups in " << lookup_ms << " ms (" << n / lookup_ms * 1000 << " ops/s)"
+              << std::endl;
+    ASSERT_TRUE(tree.Check());
+
+    for (auto key : keys) {
+      free(key);
+    }
+  }
+}
+
+/**
+ * Count the leaves of tree by walking the leaf chain from the left most leaf.
+ */
+static int CountLeaves(BPlusTree &tree, BufferPoolManager *bpm) {
+  Page *page = tree.FindLeafPage(nullptr, INVALID_PAGE_ID, true);
+  int leaves = 0;
+  while (page != nullptr) {
+    leaves++;
+    auto leaf = reinterpret_cast<BPlusTreeLeafPage *>(page->GetData());
+    page_id_t next_page_id = leaf->GetNextPageId();
+    bpm->UnpinPage(leaf->GetPageId(), false);
+    page = next_page_id == INVALID_PAGE_ID ? nullptr : bpm->FetchPage(next_page_id);
+  }
+  return leaves;
+}
+
+/**
+ * Building a tree over existing keys: one Insert per key in table order, against sorting the keys and
+ * loading them bottom-up with BPlusTree::BulkLoad.
+ */
+TEST(BPlusTreeBenchmarkTest, BulkLoadTest) {
+  const int n = 50000;
+  DBStorageEngine engine(bench_db_name);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, 16);
+  std::vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), &key_schema);
+    keys.push_back(key);
+  }
+  ShuffleArray(keys);
+
+  BPlusTree inserted(0, engine.bpm_, KP);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(inserted.Insert(keys[i], RowId(i)));
+  }
+  auto insert_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  BPlusTree loaded(1, engine.bpm_, KP);
+  start = std::chrono::steady_clock::now();
+  std::vector<std::pair<GenericKey *, RowId>> entries;
+  for (int i = 0; i < n; i++) {
+    entries.emplace_back(keys[i], RowId(i));
+  }
+  std::sort(entries.begin(), entries.end(),
+            [&KP](const auto &lhs, const auto &rhs) { return KP.CompareKeys(lhs.first, rhs.first) < 0; });
+  ASSERT_TRUE(loaded.BulkLoad(entries, DEFAULT_INDEX_FILL_FACTOR));
+  auto load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << n << " keys: inserts in " << insert_ms << " ms over " << CountLeaves(inserted, engine.bpm_)
+            << " leaves, bulk load in " << load_ms << " ms over " << CountLeaves(loaded, engine.bpm_) << " leaves"
+            << std::endl;
+  std::vector<RowId> result;
+  for (int i = 0; i < n; i++) {
+    result.clear();
+    ASSERT_TRUE(loaded.GetValue(keys[i], result));
+    ASSERT_EQ(RowId(i), result[0]);
+  }
+  ASSERT_TRUE(inserted.Check());
+  ASSERT_TRUE(loaded.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+/**
+ * Time to the first row and to the last row of a range over most of the index: collecting the whole range
+ * with ScanKey before looking at it, against pulling the rows from an IndexCursor.
+ */
+TEST(BPlusTreeBenchmarkTest, RangeCursorTest) {
+  const int n = 200000;
+  DBStorageEngine engine(bench_db_name);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+  Schema key_schema(columns);
+  BPlusTreeIndex index(0, &key_schema, 16, engine.bpm_);
+  size_t next = 0;
+  ASSERT_EQ(DB_SUCCESS, index.BulkLoad(
+                            [&next](Row &key, RowId &row_id) {
+                              if (next == n) {
+                                return false;
+                              }
+                              std::vector<Field> fields;
+                              fields.emplace_back(TypeId::kTypeInt, static_cast<int>(next));
+                              key = Row(fields);
+                              row_id = RowId(0, next++);
+                              return true;
+                            },
+                            nullptr));
+  std::vector<Field> fields;
+  fields.emplace_back(TypeId::kTypeInt, n / 10);
+  Row low(fields);
+  using Clock = std::chrono::steady_clock;
+  auto ms_since = [](Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  };
+
+  auto start = Clock::now();
+  std::vector<RowId> result;
+  index.ScanKey(low, result, nullptr, ">=");
+  double scan_first_ms = ms_since(start);
+  size_t scanned = result.size();
+
+  start = Clock::now();
+  auto cursor = index.OpenCursor(low, true, Row(), true, nullptr);
+  RowId rid;
+  ASSERT_TRUE(cursor->Next(&rid));
+  double cursor_first_ms = ms_since(start);
+  size_t pulled = 1;
+  while (cursor->Next(&rid)) {
+    pulled++;
+  }
+  double cursor_last_ms = ms_since(start);
+
+  ASSERT_EQ(scanned, pulled);
+  std::cout << pulled << " rows: ScanKey first row after " << scan_first_ms << " ms; cursor first row after "
+            << cursor_first_ms << " ms, last row after " << cursor_last_ms << " ms" << std::endl;
+}
@@ -0,0 +1,217 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "common/instance.h"
+#include "gtest/gtest.h"
+#include "index/b_plus_tree.h"
+#include "utils/utils.h"
+
+static const std::string db_name = "bp_tree_concurrent_test.db";
+
+/**
+ * Serialized int keys 0..n-1, freed with the fixture.
+ */
+class ConcurrentKeys {
+ public:
+  explicit ConcurrentKeys(int n) : key_schema_({new Column("int", TypeId::kTypeInt, 0, false, false)}) {
+    KeyManager KP(&key_schema_, 16);
+    for (int i = 0; i < n; i++) {
+      GenericKey *key = KP.InitKey();
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+      KP.SerializeFromKey(key, Row(fields), &key_schema_);
+      keys_.push_back(key);
+    }
+  }
+
+  ~ConcurrentKeys() {
+    for (auto key : keys_) {
+      free(key);
+    }
+  }
+
+  Schema key_schema_;
+  std::vector<GenericKey *> keys_;
+};
+
+template <typename F>
+static void RunThreads(int thread_num, F &&task) {
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back(task, t);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+/**
+ * Small pages make every phase split and merge all the way to the root while the other threads run.
+ */
+TEST(BPlusTreeConcurrentTest, InsertLookupRemoveTest) {
+  const int n = 20000;
+  const int thread_num = 4;
+  DBStorageEngine engine(db_name);
+  ConcurrentKeys data(n);
+  KeyManager KP(&data.key_schema_, 16);
+  BPlusTree tree(0, engine.bpm_, KP, 16, 8);
+  auto &keys = data.keys_;
+  std::atomic<int> failures{0};
+
+  // 每个线程乱序插入自己的一份键
+  RunThreads(thread_num, [&](int t) {
+    std::vector<int> mine;
+    for (int i = t; i < n; i += thread_num) {
+      mine.push_back(i);
+    }
+    ShuffleArray(mine);
+    for (int i : mine) {
+      if (!tree.Insert(keys[i], RowId(i))) {
+        failures++;
+      }
+    }
+  });
+  ASSERT_EQ(0, failures);
+  ASSERT_TRUE(tree.Check());
+
+  // 一半线程删除奇数键，另一半同时查找不会被删除的偶数键
+  RunThreads(thread_num, [&](int t) {
+    std::vector<RowId> result;
+    std::mt19937 rng(t);
+    for (int round = 0; round < n / thread_num; round++) {
+      if (t % 2 == 0) {
+        int i = (round * thread_num + t) * 2 + 1;
+        if (i < n) {
+          tree.Remove(keys[i]);
+        }
+      } else {
+        int i = static_cast<int>(rng() % (n / 2)) * 2;
+        result.clear();
+        if (!tree.GetValue(keys[i], result) || !(result[0] == RowId(i))) {
+          failures++;
+        }
+      }
+    }
+  });
+  ASSERT_EQ(0, failures);
+
+  std::vector<RowId> result;
+  for (int i = 0; i < n; i++) {
+    result.clear();
+    bool odd = (i % 2 == 1) && ((i - 1) / 2 % thread_num) % 2 == 0;
+    ASSERT_EQ(!odd, tree.GetValue(keys[i], result)) << i;
+  }
+
+  // 所有线程一起把剩下的删光
+  RunThreads(thread_num, [&](int t) {
+    for (int i = t; i < n; i += thread_num) {
+      tree.Remove(keys[i]);
+    }
+  });
+  ASSERT_TRUE(tree.IsEmpty());
+  ASSERT_TRUE(tree.Check());
+}
+
+/**
+ * Range scans resume leaf by leaf with ScanLeaf while writers insert and remove the odd keys, splitting and
+ * merging the leaves under them; every scan must still see each even key exactly once, in order.
+ */
+TEST(BPlusTreeConcurrentTest, ScanWhileWritingTest) {
+  const int n = 10000;
+  const int writer_num = 2;
+  const int reader_num = 2;
+  DBStorageEngine engine(db_name);
+  ConcurrentKeys data(n);
+  KeyManager KP(&data.key_schema_, 16);
+  BPlusTree tree(0, engine.bpm_, KP, 16, 8);
+  auto &keys = data.keys_;
+  for (int i = 0; i < n; i += 2) {
+    ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+  }
+  std::atomic<int> failures{0};
+
+  RunThreads(writer_num + reader_num, [&](int t) {
+    if (t < writer_num) {
+      // 写线程反复插入、删除自己那份奇数键
+      for (int round = 0; round < 3; round++) {
+        for (int i = 2 * t + 1; i < n; i += 2 * writer_num) {
+          tree.Insert(keys[i], RowId(i));
+        }
+        for (int i = 2 * t + 1; i < n; i += 2 * writer_num) {
+          tree.Remove(keys[i]);
+        }
+      }
+      return;
+    }
+    for (int round = 0; round < 5; round++) {
+      GenericKey *last = KP.InitKey();
+      memcpy(last, keys[0], KP.GetKeySize());
+      bool inclusive = true;
+      int expected = 0;
+      bool more = true;
+      while (more) {
+        more = tree.ScanLeaf(last, inclusive, [&](const GenericKey *key, RowId value) {
+          memcpy(last, key, KP.GetKeySize());
+          int i = static_cast<int>(value.Get());
+          if (i % 2 == 0) {
+            if (i != expected) {
+              failures++;
+            }
+            expected = i + 2;
+          }
+          return true;
+        });
+        inclusive = false;
+      }
+      if (expected != n) {
+        failures++;
+      }
+      free(last);
+    }
+  });
+  ASSERT_EQ(0, failures);
+  ASSERT_TRUE(tree.Check());
+}
+
+/**
+ * Throughput of a mixed workload (80% lookups, 10% inserts, 10% removes over a preloaded tree) as the number
+ * of threads grows.
+ */
+TEST(BPlusTreeConcurrentTest, MixedWorkloadBenchmark) {
+  const int n = 50000;
+  const int ops = 200000;
+  DBStorageEngine engine(db_name);
+  ConcurrentKeys data(n);
+  KeyManager KP(&data.key_schema_, 16);
+  auto &keys = data.keys_;
+  for (int thread_num : {1, 2, 4, 8}) {
+    BPlusTree tree(thread_num, engine.bpm_, KP);
+    for (int i = 0; i < n; i += 2) {
+      tree.Insert(keys[i], RowId(i));
+    }
+    auto start = std::chrono::steady_clock::now();
+    RunThreads(thread_num, [&](int t) {
+      std::mt19937 rng(t);
+      std::vector<RowId> result;
+      for (int op = 0; op < ops / thread_num; op++) {
+        int i = static_cast<int>(rng() % n);
+        int kind = static_cast<int>(rng() % 10);
+        if (kind == 0) {
+          tree.Insert(keys[i], RowId(i));
+        } else if (kind == 1) {
+          tree.Remove(keys[i]);
+        } else {
+          result.clear();
+          tree.GetValue(keys[i], result);
+        }
+      }
+    });
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << thread_num << " threads: " << ops << " mixed ops in " << ms << " ms (" << ops / ms * 1000
+              << " ops/s)" << std::endl;
+    ASSERT_TRUE(tree.Check());
+  }
+}
@@ -1,10 +1,12 @@
 #include "index/b_plus_tree_index.h"
 
+#include <algorithm>
 #include <string>
 
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "index/generic_key.h"
+#include "utils/utils.h"
 
 static const std::string db_name = "bp_tree_index_test.db";
 
@@ -27,7 +29,68 @@ TEST(BPlusTreeTests, BPlusTreeIndexGenericKeyTest) {
   ASSERT_EQ(0, KP.CompareKeys(k1, k2));
 }
 
+TEST(BPlusTreeTests, BPlusTreeIndexKeyOrderTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 1, true, false),
+                                   new Column("name", TypeId::kTypeChar, 8, 2, true, false)};
+  Schema key_schema(columns);
+  KeyManager KP(&key_schema, 32);
+  std::vector<Field> ints{Field(TypeId::kTypeInt), Field(TypeId::kTypeInt, INT32_MIN), Field(TypeId::kTypeInt, -1),
+                          Field(TypeId::kTypeInt, 0), Field(TypeId::kTypeInt, 1), Field(TypeId::kTypeInt, 256),
+                          Field(TypeId::kTypeInt, INT32_MAX)};
+  std::vector<Field> floats{Field(TypeId::kTypeFloat), Field(TypeId::kTypeFloat, -1e10f),
+                            Field(TypeId::kTypeFloat, -0.5f), Field(TypeId::kTypeFloat, -0.0f),
+                            Field(TypeId::kTypeFloat, 0.25f), Field(TypeId::kTypeFloat, 3e8f)};
+  std::vector<Field> chars;
+  chars.emplace_back(TypeId::kTypeChar);
+  for (const char *s : {"", "a", "ab", "ab\x01", "abc", "b", "zzzzzzzz"}) {
+    chars.emplace_back(TypeId::kTypeChar, const_cast<char *>(s), strlen(s), true);
+  }
+  // 逐列比较，NULL 排在所有值之前
+  auto compare_fields = [](const std::vector<Field> &lhs, const std::vector<Field> &rhs) {
+    for (size_t i = 0; i < lhs.size(); i++) {
+      if (lhs[i].IsNull() || rhs[i].IsNull()) {
+        if (lhs[i].IsNull() != rhs[i].IsNull()) {
+          return lhs[i].IsNull() ? -1 : 1;
+        }
+      } else if (lhs[i].CompareLessThan(rhs[i]) == CmpBool::kTrue) {
+        return -1;
+      } else if (lhs[i].CompareGreaterThan(rhs[i]) == CmpBool::kTrue) {
+        return 1;
+      }
+    }
+    return 0;
+  };
+  std::vector<std::vector<Field>> rows;
+  std::vector<GenericKey *> keys;
+  for (auto &i : ints) {
+    for (auto &f : floats) {
+      for (auto &c : chars) {
+        rows.emplace_back();
+        rows.back().emplace_back(i);
+        rows.back().emplace_back(f);
+        rows.back().emplace_back(c);
+        keys.push_back(KP.InitKey());
+        KP.SerializeFromKey(keys.back(), Row(rows.back()), &key_schema);
+        Row decoded;
+        KP.DeserializeToKey(keys.back(), decoded, &key_schema);
+        ASSERT_EQ(0, compare_fields(rows.back(), decoded.GetFields()));
+      }
+    }
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < keys.size(); j++) {
+      int cmp = KP.CompareKeys(keys[i], keys[j]);
+      ASSERT_EQ(compare_fields(rows[i], rows[j]), (cmp > 0) - (cmp < 0));
+    }
+  }
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
 TEST(BPlusTreeTests, BPlusTreeIndexSimpleTest) {
+  remove(db_name.c_str());
   auto disk_mgr_ = new DiskManager(db_name);
   auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
   page_id_t id;
@@ -78,4 +141,220 @@ TEST(BPlusTreeTests, BPlusTreeIndexSimpleTest) {
   delete index;
   delete bpm_;
   delete disk_mgr_;
-}
\ No newline at end of file
+}
+TEST(BPlusTreeTests, BPlusTreeIndexNonUniqueTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("score", TypeId::kTypeInt, 1, true, false)};
+  const TableSchema table_schema(columns);
+  std::unique_ptr<Schema> index_schema(Schema::ShallowCopySchema(&table_schema, {1}));
+  const int n = 3000;
+  auto key_of = [](int score) {
+    std::vector<Field> fields;
+    fields.emplace_back(TypeId::kTypeInt, score);
+    return Row(fields);
+  };
+  // 每个 score 有 n / 10 行，顺序打乱后插入
+  std::vector<int> ids;
+  for (int i = 0; i < n; i++) {
+    ids.push_back(i);
+  }
+  ShuffleArray(ids);
+  BPlusTreeIndex index(0, index_schema.get(), 16, engine.bpm_, false);
+  ASSERT_FALSE(index.IsUnique());
+  for (int i : ids) {
+    ASSERT_EQ(DB_SUCCESS, index.InsertEntry(key_of(i % 10), RowId(100 + i / 100, i % 100), nullptr));
+  }
+  auto scan = [&index, &key_of](int score, const std::string &op) {
+    std::vector<RowId> result;
+    index.ScanKey(key_of(score), result, nullptr, op);
+    return result;
+  };
+  std::vector<RowId> equal = scan(5, "=");
+  ASSERT_EQ(n / 10, equal.size());
+  for (size_t i = 0; i < equal.size(); i++) {
+    int id = (equal[i].GetPageId() - 100) * 100 + static_cast<int>(equal[i].GetSlotNum());
+    ASSERT_EQ(5, id % 10);
+    // 相同的键按 RowId 排列
+    ASSERT_TRUE(i == 0 || equal[i - 1].Get() < equal[i].Get());
+  }
+  ASSERT_EQ(n / 10 * 2, scan(7, ">").size());
+  ASSERT_EQ(n / 10 * 3, scan(7, ">=").size());
+  ASSERT_EQ(n / 10 * 2, scan(2, "<").size());
+  ASSERT_EQ(n / 10 * 3, scan(2, "<=").size());
+  ASSERT_EQ(n / 10 * 9, scan(3, "<>").size());
+  ASSERT_EQ(0, scan(10, "=").size());
+  ASSERT_EQ(0, scan(-1, "<").size());
+
+  // 删除时用 RowId 定位到重复键中的那一项
+  for (int i = 5; i < n; i += 20) {
+    ASSERT_EQ(DB_SUCCESS, index.RemoveEntry(key_of(5), RowId(100 + i / 100, i % 100), nullptr));
+  }
+  equal = scan(5, "=");
+  ASSERT_EQ(n / 20, equal.size());
+  for (auto &rid : equal) {
+    ASSERT_EQ(15, ((rid.GetPageId() - 100) * 100 + static_cast<int>(rid.GetSlotNum())) % 20);
+  }
+
+  // 批量建树时重复键都保留
+  BPlusTreeIndex loaded(1, index_schema.get(), 16, engine.bpm_, false);
+  size_t next = 0;
+  ASSERT_EQ(DB_SUCCESS, loaded.BulkLoad(
+                            [&](Row &key, RowId &row_id) {
+                              if (next == ids.size()) {
+                                return false;
+                              }
+                              key = key_of(ids[next] % 10);
+                              row_id = RowId(100 + ids[next] / 100, ids[next] % 100);
+                              next++;
+                              return true;
+                            },
+                            nullptr));
+  std::vector<RowId> loaded_equal;
+  ASSERT_EQ(DB_SUCCESS, loaded.ScanKey(key_of(5), loaded_equal, nullptr));
+  ASSERT_EQ(n / 10, loaded_equal.size());
+}
+
+TEST(BPlusTreeTests, BPlusTreeIndexScanRangeTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("a", TypeId::kTypeInt, 0, false, false),
+                                   new Column("b", TypeId::kTypeInt, 1, false, false)};
+  const TableSchema table_schema(columns);
+  std::unique_ptr<Schema> index_schema(Schema::ShallowCopySchema(&table_schema, {0, 1}));
+  auto key_of = [](std::initializer_list<int> values) {
+    std::vector<Field> fields;
+    for (int v : values) {
+      fields.emplace_back(TypeId::kTypeInt, v);
+    }
+    return Row(fields);
+  };
+  BPlusTreeIndex index(0, index_schema.get(), 16, engine.bpm_);
+  std::vector<int> ids;
+  for (int i = 0; i < 1000; i++) {
+    ids.push_back(i);
+  }
+  ShuffleArray(ids);
+  // 键 (i / 100, i % 100) 对应 RowId(0, i)
+  for (int i : ids) {
+    ASSERT_EQ(DB_SUCCESS, index.InsertEntry(key_of({i / 100, i % 100}), RowId(0, i), nullptr));
+  }
+  auto scan = [&index](const Row &start, bool start_inclusive, const Row &stop, bool stop_inclusive) {
+    std::vector<RowId> result;
+    index.ScanRange(start, start_inclusive, stop, stop_inclusive, result, nullptr);
+    std::vector<int> slots;
+    for (auto &rid : result) {
+      slots.push_back(static_cast<int>(rid.GetSlotNum()));
+    }
+    return slots;
+  };
+  auto interval = [](int first, int last) {
+    std::vector<int> slots;
+    for (int i = first; i <= last; i++) {
+      slots.push_back(i);
+    }
+    return slots;
+  };
+  // 只给前导列
+  ASSERT_EQ(interval(300, 399), scan(key_of({3}), true, key_of({3}), true));
+  ASSERT_EQ(interval(400, 999), scan(key_of({3}), false, key_of({}), true));
+  ASSERT_EQ(interval(0, 199), scan(key_of({}), true, key_of({2}), false));
+  // 前导列等值，下一列是范围
+  ASSERT_EQ(interval(310, 319), scan(key_of({3, 10}), true, key_of({3, 20}), false));
+  ASSERT_EQ(interval(311, 399), scan(key_of({3, 10}), false, key_of({3}), true));
+  ASSERT_EQ(interval(300, 320), scan(key_of({3}), true, key_of({3, 20}), true));
+  // 跨过前导列的边界
+  ASSERT_EQ(interval(395, 404), scan(key_of({3, 95}), true, key_of({4, 4}), true));
+  // 完整的键
+  ASSERT_EQ(interval(742, 742), scan(key_of({7, 42}), true, key_of({7, 42}), true));
+  ASSERT_TRUE(scan(key_of({7, 42}), false, key_of({7, 42}), true).empty());
+  ASSERT_TRUE(scan(key_of({10}), true, key_of({}), true).empty());
+}
+
+TEST(BPlusTreeTests, BPlusTreeIndexCursorTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("score", TypeId::kTypeInt, 0, false, false)};
+  const TableSchema table_schema(columns);
+  std::unique_ptr<Schema> index_schema(Schema::ShallowCopySchema(&table_schema, {0}));
+  auto key_of = [](int score) {
+    std::vector<Field> fields;
+    fields.emplace_back(TypeId::kTypeInt, score);
+    return Row(fields);
+  };
+  const int n = 5000;
+  BPlusTreeIndex index(0, index_schema.get(), 16, engine.bpm_, false);
+  for (int i = 0; i < n; i++) {
+    ASSERT_EQ(DB_SUCCESS, index.InsertEntry(key_of(i % 100), RowId(0, i), nullptr));
+  }
+  // 范围里的行按键、再按 RowId 的顺序逐个取出
+  auto cursor = index.OpenCursor(key_of(10), true, key_of(20), false, nullptr);
+  RowId rid;
+  int count = 0;
+  int last = -1;
+  while (cursor->Next(&rid)) {
+    int i = static_cast<int>(rid.GetSlotNum());
+    ASSERT_TRUE(i % 100 >= 10 && i % 100 < 20);
+    ASSERT_LT(last % 100 * n + last, i % 100 * n + i);
+    last = i;
+    count++;
+  }
+  ASSERT_EQ(n / 100 * 10, count);
+  ASSERT_FALSE(cursor->Next(&rid));
+
+  // 只取前几行就丢掉的游标不留下 pin
+  cursor = index.OpenCursor(key_of(50), false, Row(), true, nullptr);
+  for (int k = 0; k < 3; k++) {
+    ASSERT_TRUE(cursor->Next(&rid));
+    ASSERT_EQ(51, rid.GetSlotNum() % 100);
+  }
+  cursor.reset();
+  ASSERT_TRUE(engine.bpm_->CheckAllUnpinned());
+
+  // 游标和 ScanRange 得到同样的行
+  std::vector<RowId> scanned;
+  ASSERT_EQ(DB_SUCCESS, index.ScanRange(Row(), true, key_of(7), true, scanned, nullptr));
+  cursor = index.OpenCursor(Row(), true, key_of(7), true, nullptr);
+  for (auto &expected : scanned) {
+    ASSERT_TRUE(cursor->Next(&rid));
+    ASSERT_EQ(expected, rid);
+  }
+  ASSERT_FALSE(cursor->Next(&rid));
+}
+
+TEST(BPlusTreeTests, BPlusTreeIndexLongCharKeyTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("name", TypeId::kTypeChar, 4, 0, false, false)};
+  const TableSchema table_schema(columns);
+  std::unique_ptr<Schema> index_schema(Schema::ShallowCopySchema(&table_schema, {0}));
+  auto key_of = [](const char *s) {
+    std::vector<Field> fields;
+    fields.emplace_back(TypeId::kTypeChar, const_cast<char *>(s), strlen(s), true);
+    return Row(fields);
+  };
+  for (bool unique : {true, false}) {
+    BPlusTreeIndex index(unique ? 0 : 1, index_schema.get(), 32, engine.bpm_, unique);
+    const char *names[] = {"abc", "abcd", "abce", "b"};
+    for (uint32_t i = 0; i < 4; i++) {
+      ASSERT_EQ(DB_SUCCESS, index.InsertEntry(key_of(names[i]), RowId(0, i), nullptr));
+    }
+    // 比列长的值存不进索引
+    ASSERT_EQ(DB_KEY_TOO_LONG, index.InsertEntry(key_of("abcda"), RowId(0, 4), nullptr));
+
+    // 作为查询边界时，它排在 "abcd" 之后、"abce" 之前，且不等于任何键
+    auto scan = [&index, &key_of](const char *s, const std::string &op) {
+      std::vector<RowId> result;
+      index.ScanKey(key_of(s), result, nullptr, op);
+      std::vector<uint32_t> slots;
+      for (auto &rid : result) {
+        slots.push_back(rid.GetSlotNum());
+      }
+      std::sort(slots.begin(), slots.end());
+      return slots;
+    };
+    ASSERT_TRUE(scan("abcda", "=").empty());
+    ASSERT_EQ(std::vector<uint32_t>({0, 1}), scan("abcda", "<"));
+    ASSERT_EQ(std::vector<uint32_t>({0, 1}), scan("abcda", "<="));
+    ASSERT_EQ(std::vector<uint32_t>({2, 3}), scan("abcda", ">"));
+    ASSERT_EQ(std::vector<uint32_t>({0, 1, 2, 3}), scan("abcda", "<>"));
+    ASSERT_EQ(std::vector<uint32_t>({3}), scan("abcz", ">"));
+  }
+}
@@ -69,4 +69,129 @@ TEST(BPlusTreeTests, SampleTest) {
     ASSERT_TRUE(tree.GetValue(delete_seq[i], ans));
     ASSERT_EQ(kv_map[delete_seq[i]], ans[ans.size() - 1]);
   }
-}
\ No newline at end of file
+}
+TEST(BPlusTreeTests, BulkLoadTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 16);
+  // 页面较小，建出来有好几层
+  BPlusTree tree(0, engine.bpm_, KP, 16, 8);
+  const int n = 3000;
+  vector<GenericKey *> keys;
+  vector<std::pair<GenericKey *, RowId>> entries;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i * 2)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+    entries.emplace_back(key, RowId(i));
+  }
+  ASSERT_TRUE(tree.BulkLoad(entries, 0.75));
+  ASSERT_FALSE(tree.BulkLoad(entries, 0.75));
+  ASSERT_TRUE(tree.Check());
+  // 叶子链上的键有序且完整
+  int i = 0;
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter, ++i) {
+    ASSERT_EQ(0, KP.CompareKeys(keys[i], (*iter).first));
+    ASSERT_EQ(RowId(i), (*iter).second);
+  }
+  ASSERT_EQ(n, i);
+  // 建好的树可以继续插入和删除，插入时照常分裂
+  vector<RowId> ans;
+  for (int j = 0; j < n; j++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, j * 2 + 1)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    ASSERT_TRUE(tree.Insert(key, RowId(n + j)));
+    ASSERT_FALSE(tree.Insert(keys[j], RowId(n + j)));
+    ans.clear();
+    ASSERT_TRUE(tree.GetValue(key, ans));
+    ASSERT_EQ(RowId(n + j), ans[0]);
+    free(key);
+  }
+  for (int j = 0; j < n; j++) {
+    ans.clear();
+    ASSERT_TRUE(tree.GetValue(keys[j], ans));
+    ASSERT_EQ(RowId(j), ans[0]);
+  }
+  // 删除一半，再全部删掉，树应当一路合并到空
+  for (int j = 0; j < n; j += 2) {
+    tree.Remove(keys[j]);
+  }
+  for (int j = 0; j < n; j++) {
+    ans.clear();
+    ASSERT_EQ(j % 2 == 1, tree.GetValue(keys[j], ans));
+  }
+  for (int j = 1; j < n; j += 2) {
+    tree.Remove(keys[j]);
+  }
+  for (int j = 0; j < n; j++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, j * 2 + 1)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    tree.Remove(key);
+    free(key);
+  }
+  ASSERT_TRUE(tree.IsEmpty());
+  ASSERT_TRUE(tree.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+/**
+ * Entry counts just past one fill_factor-packed leaf: spreading them evenly over two leaves would leave both
+ * at or below the min size, so the load must use fewer, fuller leaves. 100 entries need two leaves of at most
+ * 99, which can only be 50 each.
+ */
+TEST(BPlusTreeTests, BulkLoadMinSizeTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {new Column("int", TypeId::kTypeInt, 0, false, false)};
+  Schema table_schema(columns);
+  KeyManager KP(&table_schema, 16);
+  const int leaf_max_size = 100;
+  index_id_t tree_id = 0;
+  for (int n : {90, 95, 99, 100, 180, 1000}) {
+    BPlusTree tree(tree_id++, engine.bpm_, KP, leaf_max_size, leaf_max_size);
+    vector<GenericKey *> keys;
+    vector<std::pair<GenericKey *, RowId>> entries;
+    for (int i = 0; i < n; i++) {
+      GenericKey *key = KP.InitKey();
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+      KP.SerializeFromKey(key, Row(fields), &table_schema);
+      keys.push_back(key);
+      entries.emplace_back(key, RowId(i));
+    }
+    ASSERT_TRUE(tree.BulkLoad(entries, 0.9));
+    // 除非只有一个叶子，每个叶子都不少于 min size，也不超过 max size - 1
+    std::vector<int> sizes;
+    Page *page = tree.FindLeafPage(nullptr, INVALID_PAGE_ID, true);
+    while (page != nullptr) {
+      auto leaf = reinterpret_cast<BPlusTreeLeafPage *>(page->GetData());
+      sizes.push_back(leaf->GetSize());
+      page_id_t next_page_id = leaf->GetNextPageId();
+      engine.bpm_->UnpinPage(leaf->GetPageId(), false);
+      page = next_page_id == INVALID_PAGE_ID ? nullptr : engine.bpm_->FetchPage(next_page_id);
+    }
+    for (int size : sizes) {
+      ASSERT_LT(size, leaf_max_size) << n;
+      if (sizes.size() > 1) {
+        ASSERT_GE(size, leaf_max_size / 2) << n;
+      }
+    }
+    // 容量允许时叶子多于 min size，删掉一个键不会引起合并
+    if (n != leaf_max_size) {
+      tree.Remove(keys[0]);
+      Page *first = tree.FindLeafPage(nullptr, INVALID_PAGE_ID, true);
+      ASSERT_EQ(sizes[0] - 1, reinterpret_cast<BPlusTreeLeafPage *>(first->GetData())->GetSize()) << n;
+      engine.bpm_->UnpinPage(first->GetPageId(), false);
+    }
+    ASSERT_TRUE(tree.Check());
+    for (auto key : keys) {
+      free(key);
+    }
+  }
+}
@@ -6,6 +6,7 @@
 #include "record/field.h"
 #include "record/row.h"
 #include "record/schema.h"
+#include "record/tuple_view.h"
 
 char *chars[] = {const_cast<char *>(""), const_cast<char *>("hello"), const_cast<char *>("world!"),
                  const_cast<char *>("\0")};
@@ -93,11 +94,139 @@ TEST(TupleTest, RowTest) {
   ASSERT_EQ(row.GetRowId(), first_tuple_rid);
   Row row2(row.GetRowId());
   ASSERT_TRUE(table_page.GetTuple(&row2, schema.get(), nullptr, nullptr));
-  std::vector<Field *> &row2_fields = row2.GetFields();
+  const std::vector<Field> &row2_fields = row2.GetFields();
   ASSERT_EQ(3, row2_fields.size());
   for (size_t i = 0; i < row2_fields.size(); i++) {
-    ASSERT_EQ(CmpBool::kTrue, row2_fields[i]->CompareEquals(fields[i]));
+    ASSERT_EQ(CmpBool::kTrue, row2_fields[i].CompareEquals(fields[i]));
   }
   ASSERT_TRUE(table_page.MarkDelete(row.GetRowId(), nullptr, nullptr, nullptr));
   table_page.ApplyDelete(row.GetRowId(), nullptr, nullptr);
-}
\ No newline at end of file
+}
+TEST(TupleTest, TupleViewTest) {
+  TablePage table_page;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  std::vector<Field> fields = {Field(TypeId::kTypeInt, 188),
+                               Field(TypeId::kTypeChar, const_cast<char *>("minisql"), strlen("minisql"), false),
+                               Field(TypeId::kTypeFloat, 19.99f)};
+  std::vector<Field> null_name = {Field(TypeId::kTypeInt, 189), Field(TypeId::kTypeChar),
+                                  Field(TypeId::kTypeFloat, 29.99f)};
+  Row row(fields);
+  Row row_with_null(null_name);
+  table_page.Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+  ASSERT_TRUE(table_page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+  ASSERT_TRUE(table_page.InsertTuple(row_with_null, schema.get(), nullptr, nullptr, nullptr));
+
+  // Fields read in place match the inserted ones, and columns can be read in any order
+  TupleView view;
+  view.Reset(table_page.GetTupleData(row.GetRowId().GetSlotNum()), schema.get());
+  ASSERT_TRUE(view.IsValid());
+  for (int i = 2; i >= 0; i--) {
+    ASSERT_EQ(CmpBool::kTrue, view.GetField(i).CompareEquals(fields[i]));
+  }
+  Row projected;
+  std::unique_ptr<Schema> name_schema(Schema::ShallowCopySchema(schema.get(), {1}));
+  view.Project(name_schema.get(), &projected);
+  ASSERT_EQ(1, projected.GetFieldCount());
+  ASSERT_EQ(CmpBool::kTrue, projected.GetField(0)->CompareEquals(fields[1]));
+
+  view.Reset(table_page.GetTupleData(row_with_null.GetRowId().GetSlotNum()), schema.get());
+  ASSERT_TRUE(view.IsNull(1));
+  ASSERT_TRUE(view.GetField(1).IsNull());
+  ASSERT_EQ(CmpBool::kTrue, view.GetField(2).CompareEquals(null_name[2]));
+  Row materialized(row_with_null.GetRowId());
+  view.ToRow(&materialized);
+  ASSERT_EQ(CmpBool::kTrue, materialized.GetField(0)->CompareEquals(null_name[0]));
+
+  // Deleted tuples have no bytes to view
+  ASSERT_TRUE(table_page.MarkDelete(row.GetRowId(), nullptr, nullptr, nullptr));
+  ASSERT_EQ(nullptr, table_page.GetTupleData(row.GetRowId().GetSlotNum()));
+}
+
+TEST(TupleTest, RowCopyMoveTest) {
+  std::vector<Field> fields = {Field(TypeId::kTypeInt, 188),
+                               Field(TypeId::kTypeChar, const_cast<char *>("minisql"), strlen("minisql"), true),
+                               Field(TypeId::kTypeChar, const_cast<char *>(""), 0, false), Field(TypeId::kTypeChar),
+                               Field(TypeId::kTypeFloat, 19.99f)};
+  // A copy keeps its values after the original is gone
+  auto row = std::make_unique<Row>(fields);
+  Row copy(*row);
+  row.reset();
+  ASSERT_EQ(fields.size(), copy.GetFieldCount());
+  for (size_t i = 0; i < fields.size(); i++) {
+    ASSERT_EQ(fields[i].IsNull(), copy.GetField(i)->IsNull());
+    if (!fields[i].IsNull()) {
+      ASSERT_EQ(CmpBool::kTrue, copy.GetField(i)->CompareEquals(fields[i]));
+    }
+  }
+  // Moving hands over the CHAR data instead of copying it
+  const char *data = copy.GetField(1)->GetData();
+  Row moved(std::move(copy));
+  ASSERT_EQ(data, moved.GetField(1)->GetData());
+  Row assigned;
+  assigned = std::move(moved);
+  ASSERT_EQ(data, assigned.GetField(1)->GetData());
+  ASSERT_EQ(CmpBool::kTrue, assigned.GetField(1)->CompareEquals(fields[1]));
+
+  // Key rows copy the key columns out of the row
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("empty", TypeId::kTypeChar, 64, 2, true, false),
+                                   new Column("null", TypeId::kTypeChar, 64, 3, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 4, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  std::unique_ptr<Schema> key_schema(Schema::ShallowCopySchema(schema.get(), {1, 0}));
+  Row key_row;
+  assigned.GetKeyFromRow(schema.get(), key_schema.get(), key_row);
+  assigned.destroy();
+  ASSERT_EQ(2, key_row.GetFieldCount());
+  ASSERT_EQ(CmpBool::kTrue, key_row.GetField(0)->CompareEquals(fields[1]));
+  ASSERT_EQ(CmpBool::kTrue, key_row.GetField(1)->CompareEquals(fields[0]));
+}
+
+TEST(TupleTest, RowFixedLayoutTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("code", TypeId::kTypeChar, 2, 1, true, false),
+                                   new Column("name", TypeId::kTypeChar, 8, 2, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 3, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  // bitmap (1) | id (4) | code: length (4) + 4 | name: length (4) + 8 | account (4)
+  ASSERT_EQ(1, schema->GetColumnOffset(0));
+  ASSERT_EQ(5, schema->GetColumnOffset(1));
+  ASSERT_EQ(13, schema->GetColumnOffset(2));
+  ASSERT_EQ(25, schema->GetColumnOffset(3));
+  ASSERT_EQ(29, schema->GetFixedRowSize());
+
+  // Scenario: "toolong" does not fit CHAR(2) and goes to the tail, the other columns keep their offsets.
+  std::vector<Field> fields = {Field(TypeId::kTypeInt, 188),
+                               Field(TypeId::kTypeChar, const_cast<char *>("toolong"), 7, false),
+                               Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, false),
+                               Field(TypeId::kTypeFloat, 19.99f)};
+  std::vector<Field> null_fields = {Field(TypeId::kTypeInt, 189),
+                                    Field(TypeId::kTypeChar, const_cast<char *>("a"), 1, false),
+                                    Field(TypeId::kTypeChar), Field(TypeId::kTypeFloat)};
+  char buffer[PAGE_SIZE];
+  for (auto *row_fields : {&fields, &null_fields}) {
+    Row row(*row_fields);
+    uint32_t size = row.GetSerializedSize(schema.get());
+    ASSERT_EQ(size, row.SerializeTo(buffer, schema.get()));
+    ASSERT_EQ(188 + (row_fields == &null_fields), MACH_READ_INT32(buffer + schema->GetColumnOffset(0)));
+    Row row2;
+    ASSERT_EQ(size, row2.DeserializeFrom(buffer, schema.get()));
+    TupleView view;
+    view.Reset(buffer, schema.get());
+    for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+      auto &field = row_fields->at(i);
+      ASSERT_EQ(field.IsNull(), row2.GetField(i)->IsNull());
+      ASSERT_EQ(field.IsNull(), view.IsNull(i));
+      if (!field.IsNull()) {
+        ASSERT_EQ(CmpBool::kTrue, row2.GetField(i)->CompareEquals(field));
+        ASSERT_EQ(CmpBool::kTrue, view.GetField(i).CompareEquals(field));
+      }
+    }
+  }
+  ASSERT_EQ(schema->GetFixedRowSize() + 7, Row(fields).GetSerializedSize(schema.get()));
+  ASSERT_EQ(schema->GetFixedRowSize(), Row(null_fields).GetSerializedSize(schema.get()));
+}
@@ -1,6 +1,11 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -56,4 +61,133 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(extent_nums * DiskManager::BITMAP_SIZE - 5, meta_page->GetAllocatedPages());
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
-}
\ No newline at end of file
+  // Scenario: the bitmaps are only modified in memory and must survive reopening the file.
+  disk_mgr->Close();
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(extent_nums * DiskManager::BITMAP_SIZE - 5, meta_page->GetAllocatedPages());
+  EXPECT_TRUE(disk_mgr->IsPageFree(0));
+  EXPECT_FALSE(disk_mgr->IsPageFree(1));
+  EXPECT_TRUE(disk_mgr->IsPageFree(DiskManager::BITMAP_SIZE + 2));
+  EXPECT_FALSE(disk_mgr->IsPageFree(DiskManager::BITMAP_SIZE + 3));
+  EXPECT_EQ(0, disk_mgr->AllocatePage());
+  EXPECT_EQ(DiskManager::BITMAP_SIZE - 1, disk_mgr->AllocatePage());
+  EXPECT_EQ(DiskManager::BITMAP_SIZE, disk_mgr->AllocatePage());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+TEST(DiskManagerTest, ContiguousAllocationTest) {
+  std::string db_name = "disk_extent_test.db";
+  remove(db_name.c_str());
+  DiskManager *disk_mgr = new DiskManager(db_name);
+  // Scenario: runs come out of the lowest hole that is long enough.
+  for (page_id_t i = 0; i < 10; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+  disk_mgr->DeAllocatePage(2);
+  disk_mgr->DeAllocatePage(3);
+  disk_mgr->DeAllocatePage(6);
+  disk_mgr->DeAllocatePage(7);
+  disk_mgr->DeAllocatePage(8);
+  EXPECT_EQ(6, disk_mgr->AllocatePages(3));
+  EXPECT_EQ(10, disk_mgr->AllocatePages(64));
+  EXPECT_EQ(2, disk_mgr->AllocatePages(2));
+  for (page_id_t i = 0; i < 74; i++) {
+    EXPECT_FALSE(disk_mgr->IsPageFree(i));
+  }
+  EXPECT_TRUE(disk_mgr->IsPageFree(74));
+  // Scenario: a run never straddles two extents.
+  page_id_t tail = disk_mgr->AllocatePages(DiskManager::BITMAP_SIZE - 74 - 10);
+  EXPECT_EQ(74, tail);
+  EXPECT_EQ(DiskManager::BITMAP_SIZE, disk_mgr->AllocatePages(64));
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(2, meta_page->GetExtentNums());
+  EXPECT_EQ(DiskManager::BITMAP_SIZE - 10, meta_page->GetExtentUsedPage(0));
+  EXPECT_EQ(64, meta_page->GetExtentUsedPage(1));
+  EXPECT_EQ(INVALID_PAGE_ID, disk_mgr->AllocatePages(DiskManager::BITMAP_SIZE + 1));
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, ConcurrentReadWriteTest) {
+  std::string db_name = "disk_io_test.db";
+  const int num_pages = 64;
+  const int num_threads = 4;
+  for (bool direct_io : {false, true}) {
+    remove(db_name.c_str());
+    DiskManager *disk_mgr = new DiskManager(db_name, direct_io);
+    char data[PAGE_SIZE];
+    // Scenario: a page that was never written reads back as zeros.
+    disk_mgr->ReadPage(num_pages, data);
+    for (char c : data) {
+      ASSERT_EQ(0, c);
+    }
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      memset(data, page_id + 1, PAGE_SIZE);
+      disk_mgr->WritePage(page_id, data);
+    }
+    // Scenario: readers do not share a file cursor.
+    std::vector<std::thread> readers;
+    std::vector<int> mismatches(num_threads, 0);
+    for (int t = 0; t < num_threads; t++) {
+      readers.emplace_back([&, t]() {
+        char buf[PAGE_SIZE];
+        for (int round = 0; round < 20; round++) {
+          for (page_id_t page_id = t; page_id < num_pages; page_id += 1 + t) {
+            disk_mgr->ReadPage(page_id, buf);
+            mismatches[t] += buf[0] != static_cast<char>(page_id + 1) || buf[PAGE_SIZE - 1] != buf[0];
+          }
+        }
+      });
+    }
+    for (auto &reader : readers) {
+      reader.join();
+    }
+    for (int t = 0; t < num_threads; t++) {
+      EXPECT_EQ(0, mismatches[t]);
+    }
+    disk_mgr->Close();
+    delete disk_mgr;
+    // Scenario: the pages survive reopening the file.
+    disk_mgr = new DiskManager(db_name, direct_io);
+    disk_mgr->ReadPage(num_pages - 1, data);
+    EXPECT_EQ(static_cast<char>(num_pages), data[PAGE_SIZE / 2]);
+    delete disk_mgr;
+  }
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, AsyncIOErrorTest) {
+  std::string file_name = "async_io_test.db";
+  int fd = open(file_name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+  ASSERT_GE(fd, 0);
+  char page[PAGE_SIZE];
+  memset(page, 'x', PAGE_SIZE);
+  {
+    AsyncIOEngine engine(fd, false);
+    std::vector<AsyncIOEngine::Request> requests{{0, page, true}};
+    ASSERT_TRUE(engine.Execute(requests, 1));
+  }
+  for (size_t queue_depth : {1, 4}) {
+    // Scenario: a read past the end of file is zero-filled and succeeds.
+    AsyncIOEngine engine(fd, false);
+    char pages[2][PAGE_SIZE];
+    memset(pages, 'y', sizeof(pages));
+    std::vector<AsyncIOEngine::Request> requests{{0, pages[0], false}, {PAGE_SIZE, pages[1], false}};
+    ASSERT_TRUE(engine.Execute(requests, queue_depth));
+    EXPECT_EQ('x', pages[0][PAGE_SIZE - 1]);
+    EXPECT_EQ(0, pages[1][0]);
+  }
+  close(fd);
+  // Scenario: a read that fails is reported, not taken for the end of file.
+  fd = open(file_name.c_str(), O_WRONLY);
+  ASSERT_GE(fd, 0);
+  for (size_t queue_depth : {1, 4}) {
+    AsyncIOEngine engine(fd, false);
+    std::vector<AsyncIOEngine::Request> requests{{0, page, false}};
+    EXPECT_FALSE(engine.Execute(requests, queue_depth));
+  }
+  close(fd);
+  remove(file_name.c_str());
+}
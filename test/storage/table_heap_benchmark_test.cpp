@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/instance.h"
+#include "gtest/gtest.h"
+#include "page/table_page.h"
+#include "record/field.h"
+#include "record/schema.h"
+#include "storage/table_heap.h"
+#include "utils/utils.h"
+
+static const std::string bench_db_name = "table_heap_bench_test.db";
+
+/**
+ * Parse the rows of test_data/sql_gen/account*.txt, i.e. lines of the form
+ * insert into account values(12500000, "name00000", 514.35);
+ * The test binary runs from the repository root or from the build tree, so a few relative locations are tried.
+ * @return number of files found
+ */
+static size_t LoadAccountRows(std::vector<std::vector<Row>> *batches) {
+  std::string dir;
+  for (const char *candidate : {"./test_data/sql_gen/", "../test_data/sql_gen/", "../../test_data/sql_gen/"}) {
+    if (std::ifstream(std::string(candidate) + "account00.txt").good()) {
+      dir = candidate;
+      break;
+    }
+  }
+  if (dir.empty()) {
+    return 0;
+  }
+  size_t num_files = 0;
+  for (int i = 0; i < 100; i++) {
+    char file_name[32];
+    snprintf(file_name, sizeof(file_name), "account%02d.txt", i);
+    std::ifstream in(dir + file_name);
+    if (!in.good()) {
+      break;
+    }
+    num_files++;
+    std::vector<Row> batch;
+    std::string line;
+    while (std::getline(in, line)) {
+      int id;
+      char name[17];
+      float balance;
+      if (sscanf(line.c_str(), "insert into account values(%d, \"%16[^\"]\", %f);", &id, name, &balance) != 3) {
+        continue;
+      }
+      std::vector<Field> fields{Field(TypeId::kTypeInt, id),
+                                Field(TypeId::kTypeChar, name, static_cast<uint32_t>(strlen(name)), true),
+                                Field(TypeId::kTypeFloat, balance)};
+      batch.emplace_back(fields);
+    }
+    batches->push_back(std::move(batch));
+  }
+  return num_files;
+}
+
+/**
+ * Load the account data set into an empty table heap, once row by row through InsertTuple (the path
+ * InsertExecutor takes) and once file by file through BulkInsert, and check that every reported RowId
+ * points at its row.
+ */
+TEST(TableHeapBenchmarkTest, BulkInsertAccountTest) {
+  std::vector<std::vector<Row>> batches;
+  if (LoadAccountRows(&batches) == 0) {
+    GTEST_SKIP() << "test_data/sql_gen not found";
+  }
+  size_t row_nums = 0;
+  for (auto &batch : batches) {
+    row_nums += batch.size();
+  }
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, true),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false),
+                                   new Column("balance", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+
+  for (bool bulk : {false, true}) {
+    remove(bench_db_name.c_str());
+    auto disk_mgr = new DiskManager(bench_db_name);
+    auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+    TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &batch : batches) {
+      if (bulk) {
+        ASSERT_TRUE(table_heap->BulkInsert(batch, nullptr));
+      } else {
+        for (auto &row : batch) {
+          ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+        }
+      }
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << (bulk ? "BulkInsert" : "InsertTuple") << ": " << row_nums << " rows in " << elapsed << " ms, "
+              << table_heap->GetHeapMeta().page_count_ << " pages" << std::endl;
+
+    for (auto &batch : batches) {
+      for (auto &row : batch) {
+        Row stored(row.GetRowId());
+        ASSERT_TRUE(table_heap->GetTuple(&stored, nullptr));
+        EXPECT_EQ(CmpBool::kTrue, stored.GetField(0)->CompareEquals(*row.GetField(0)));
+      }
+    }
+    size_t count = 0;
+    for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+      count++;
+    }
+    EXPECT_EQ(row_nums, count);
+
+    delete table_heap;
+    delete bpm;
+    delete disk_mgr;
+  }
+  remove(bench_db_name.c_str());
+}
+
+/**
+ * Warm-cache full scans of a table heap. The baseline walks the heap the way TableIterator used to: one
+ * FetchPage/UnpinPage pair to find each next RowId, then GetTuple fetching the same page again. It is compared
+ * with TableIterator, which keeps the page pinned and walks a copy of its live slots, once materializing every
+ * row and once reading a single column through the tuple view.
+ */
+TEST(TableHeapBenchmarkTest, IteratorScanTest) {
+  const int row_nums = 50000;
+  const int rounds = 3;
+  remove(bench_db_name.c_str());
+  auto disk_mgr = new DiskManager(bench_db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false),
+                                   new Column("balance", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<Row> rows;
+  rows.reserve(row_nums);
+  char characters[32];
+  int64_t expected_sum = 0;
+  for (int i = 0; i < row_nums; i++) {
+    RandomUtils::RandomString(characters, 32);
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 32, true),
+                              Field(TypeId::kTypeFloat, RandomUtils::RandomFloat(-999.f, 999.f))};
+    rows.emplace_back(fields);
+    expected_sum += i;
+  }
+  ASSERT_TRUE(table_heap->BulkInsert(rows, nullptr));
+  rows.clear();
+
+  auto run = [&](const std::string &name, const std::function<int64_t()> &scan) {
+    double best = 0;
+    for (int round = 0; round < rounds; round++) {
+      auto start = std::chrono::steady_clock::now();
+      EXPECT_EQ(expected_sum, scan());
+      double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      best = round == 0 ? elapsed : std::min(best, elapsed);
+    }
+    std::cout << name << ": " << row_nums << " rows in " << best << " ms, " << row_nums / best * 1000
+              << " rows/s" << std::endl;
+    return best;
+  };
+  double baseline = run("fetch per tuple", [&]() {
+    int64_t sum = 0;
+    RowId rid;
+    page_id_t page_id = table_heap->GetFirstPageId();
+    auto page = reinterpret_cast<TablePage *>(bpm->FetchPage(page_id));
+    bool found = page->GetFirstTupleRid(&rid);
+    bpm->UnpinPage(page_id, false);
+    while (found) {
+      Row row(rid);
+      table_heap->GetTuple(&row, nullptr);
+      sum += std::stoi(row.GetField(0)->toString());
+      page = reinterpret_cast<TablePage *>(bpm->FetchPage(rid.GetPageId()));
+      found = page->GetNextTupleRid(rid, &rid);
+      page_id_t next_page_id = page->GetNextPageId();
+      bpm->UnpinPage(page->GetTablePageId(), false);
+      while (!found && next_page_id != INVALID_PAGE_ID) {
+        page = reinterpret_cast<TablePage *>(bpm->FetchPage(next_page_id));
+        found = page->GetFirstTupleRid(&rid);
+        page_id = next_page_id;
+        next_page_id = page->GetNextPageId();
+        bpm->UnpinPage(page_id, false);
+      }
+    }
+    return sum;
+  });
+  double iterator = run("TableIterator, operator*", [&]() {
+    int64_t sum = 0;
+    for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+      sum += std::stoi((*iter).GetField(0)->toString());
+    }
+    return sum;
+  });
+  double view = run("TableIterator, tuple view", [&]() {
+    int64_t sum = 0;
+    for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+      sum += std::stoi(iter.GetTupleView().GetField(0).toString());
+    }
+    return sum;
+  });
+  std::cout << "speedup over fetch per tuple: operator* " << baseline / iterator << "x, tuple view "
+            << baseline / view << "x" << std::endl;
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(bench_db_name.c_str());
+}
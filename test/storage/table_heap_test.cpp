@@ -1,5 +1,6 @@
 #include "storage/table_heap.h"
 
+#include <set>
 #include <unordered_map>
 #include <vector>
 
@@ -62,3 +63,369 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  const std::string db_name = "table_heap_fsm_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  auto make_fields = [&](int i) {
+    return Fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+  };
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<RowId> rids;
+  for (int i = 0; i < 2000; i++) {
+    Fields fields = make_fields(i);
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  // Scenario: free the first page completely.
+  page_id_t freed_page_id = rids.front().GetPageId();
+  size_t freed = 0;
+  for (auto &rid : rids) {
+    if (rid.GetPageId() == freed_page_id) {
+      ASSERT_TRUE(table_heap->MarkDelete(rid, nullptr));
+      table_heap->ApplyDelete(rid, nullptr);
+      freed++;
+    }
+  }
+  ASSERT_GT(freed, 0);
+  TableHeapMeta heap_meta = table_heap->GetHeapMeta();
+  delete table_heap;
+
+  // Scenario: the reopened heap knows about the freed page without walking the chain and reuses it instead of
+  // growing the chain.
+  std::set<page_id_t> heap_pages;
+  for (auto &rid : rids) {
+    heap_pages.insert(rid.GetPageId());
+  }
+  EXPECT_EQ(heap_pages.size(), heap_meta.page_count_);
+  EXPECT_EQ(1, heap_pages.count(heap_meta.last_page_id_));
+  table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr, heap_meta);
+  TableHeapMeta opened_meta = table_heap->GetHeapMeta();
+  EXPECT_EQ(heap_meta.last_page_id_, opened_meta.last_page_id_);
+  EXPECT_EQ(heap_meta.page_count_, opened_meta.page_count_);
+  EXPECT_EQ(heap_meta.free_space_, opened_meta.free_space_);
+  size_t reused = 0;
+  for (size_t i = 0; i < freed; i++) {
+    Fields fields = make_fields(static_cast<int>(i));
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    EXPECT_EQ(1, heap_pages.count(row.GetRowId().GetPageId()));
+    reused += row.GetRowId().GetPageId() == freed_page_id;
+  }
+  EXPECT_GT(reused, 0);
+  EXPECT_EQ(heap_meta.page_count_, table_heap->GetHeapMeta().page_count_);
+  EXPECT_LT(table_heap->GetHeapMeta().free_space_, heap_meta.free_space_);
+  size_t count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+    count++;
+  }
+  EXPECT_EQ(rids.size(), count);
+  delete table_heap;
+
+  // Scenario: scanning a heap opened without a stored map neither walks the chain to build one nor allocates it.
+  table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr);
+  count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+    count++;
+  }
+  EXPECT_EQ(rids.size(), count);
+  EXPECT_EQ(INVALID_PAGE_ID, table_heap->GetHeapMeta().free_space_map_page_id_);
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, FreeSpaceMapNoBufferTest) {
+  const std::string db_name = "table_heap_fsm_no_buffer_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(2, disk_mgr);
+  FreeSpaceMap free_space_map(bpm);
+  ASSERT_TRUE(free_space_map.IsLoaded());
+  page_id_t heap_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(heap_page_id));
+  ASSERT_TRUE(free_space_map.AddPage(heap_page_id, 300));
+  // Scenario: with every frame pinned the map page cannot be fetched, so nothing changes and the caller is told.
+  page_id_t pinned_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(pinned_page_id));
+  EXPECT_FALSE(free_space_map.AddPage(pinned_page_id, 200));
+  EXPECT_EQ(1, free_space_map.GetPageCount());
+  EXPECT_FALSE(free_space_map.RemovePage(heap_page_id));
+  EXPECT_EQ(heap_page_id, free_space_map.FindPage(200));
+  EXPECT_FALSE(free_space_map.Update(heap_page_id, 50));
+  EXPECT_EQ(INVALID_PAGE_ID, free_space_map.FindPage(200));
+
+  // Scenario: once a frame is free again the stored entry catches up and the map reopens as it is in memory.
+  bpm->UnpinPage(pinned_page_id, false);
+  EXPECT_TRUE(free_space_map.Update(heap_page_id, 60));
+  bpm->UnpinPage(heap_page_id, false);
+  FreeSpaceMap reopened(bpm, free_space_map.GetFirstPageId());
+  ASSERT_TRUE(reopened.IsLoaded());
+  EXPECT_EQ(60, reopened.GetTotalFreeSpace());
+
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, TableIteratorTest) {
+  const std::string db_name = "table_heap_iterator_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  const int row_nums = 1000;
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  // Scenario: every row of the second page is deleted, the iterator has to step over the empty page.
+  page_id_t second_page_id = INVALID_PAGE_ID;
+  std::set<int> expected;
+  for (int i = 0; i < row_nums; i++) {
+    if (rids[i].GetPageId() != table_heap->GetFirstPageId() &&
+        (second_page_id == INVALID_PAGE_ID || rids[i].GetPageId() == second_page_id)) {
+      second_page_id = rids[i].GetPageId();
+      ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+      table_heap->ApplyDelete(rids[i], nullptr);
+    } else {
+      expected.insert(i);
+    }
+  }
+  ASSERT_NE(INVALID_PAGE_ID, second_page_id);
+  {
+    auto iter = table_heap->Begin(nullptr);
+    auto copy = iter;
+    for (; iter != table_heap->End(); ++iter) {
+      // the view, operator* and operator-> all see the same tuple
+      int id = std::stoi(iter->GetField(0)->toString());
+      ASSERT_EQ(1, expected.erase(id));
+      ASSERT_EQ(CmpBool::kTrue, iter.GetTupleView().GetField(0).CompareEquals(*(*iter).GetField(0)));
+      ASSERT_EQ(iter.GetRowId(), iter->GetRowId());
+    }
+    EXPECT_TRUE(expected.empty());
+    EXPECT_EQ(CmpBool::kTrue, copy->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, 0)));
+  }
+  // Scenario: iterators drop their pins when they go away.
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, VacuumTest) {
+  const std::string db_name = "table_heap_vacuum_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  const int row_nums = 3000;
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  std::set<page_id_t> heap_pages;
+  for (auto &rid : rids) {
+    heap_pages.insert(rid.GetPageId());
+  }
+  // Scenario: keep every tenth row. Half of the deletes are only marked, as DeleteExecutor leaves them.
+  std::unordered_map<int, RowId> kept;
+  for (int i = 0; i < row_nums; i++) {
+    if (i % 10 == 0) {
+      kept[i] = rids[i];
+      continue;
+    }
+    ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+    if (i % 2 == 0) {
+      table_heap->ApplyDelete(rids[i], nullptr);
+    }
+  }
+  TableHeapStats before;
+  table_heap->GetStats(&before);
+  EXPECT_EQ(heap_pages.size(), before.page_count_);
+  EXPECT_EQ(kept.size(), before.tuple_count_);
+  EXPECT_GT(before.dead_tuple_count_, 0);
+  EXPECT_GT(before.empty_slot_count_, 0);
+
+  VacuumStats vacuum_stats;
+  table_heap->Vacuum(&vacuum_stats, nullptr, [&](Row &row, const RowId &old_rid) {
+    int id = std::stoi(row.GetField(0)->toString());
+    EXPECT_EQ(old_rid.Get(), kept[id].Get());
+    kept[id] = row.GetRowId();
+  });
+  EXPECT_EQ(before.dead_tuple_count_, vacuum_stats.dead_tuples_removed_);
+  EXPECT_GT(vacuum_stats.tuples_moved_, 0);
+  EXPECT_GT(vacuum_stats.pages_freed_, 0);
+
+  // Scenario: the heap shrank, freed pages went back to the disk manager and every kept row is where the
+  // callback said it moved to.
+  TableHeapStats after;
+  table_heap->GetStats(&after);
+  EXPECT_EQ(before.page_count_ - vacuum_stats.pages_freed_, after.page_count_);
+  EXPECT_EQ(kept.size(), after.tuple_count_);
+  EXPECT_EQ(0, after.dead_tuple_count_);
+  EXPECT_LT(after.GetBloatRatio(), before.GetBloatRatio());
+  std::set<page_id_t> remaining_pages;
+  for (auto &entry : kept) {
+    Row row(entry.second);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    EXPECT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, entry.first)));
+    remaining_pages.insert(entry.second.GetPageId());
+  }
+  size_t freed_on_disk = 0;
+  for (auto page_id : heap_pages) {
+    freed_on_disk += remaining_pages.count(page_id) == 0 && bpm->IsPageFree(page_id);
+  }
+  EXPECT_EQ(vacuum_stats.pages_freed_, freed_on_disk);
+  size_t count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+    count++;
+  }
+  EXPECT_EQ(kept.size(), count);
+
+  // Scenario: the shrunk heap reopens from its metadata and accepts inserts.
+  TableHeapMeta heap_meta = table_heap->GetHeapMeta();
+  EXPECT_EQ(after.page_count_, heap_meta.page_count_);
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr, heap_meta);
+  for (int i = row_nums; i < row_nums + 100; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+    count++;
+  }
+  EXPECT_EQ(kept.size() + 100, count);
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, VacuumPinnedPageTest) {
+  const std::string db_name = "table_heap_vacuum_pinned_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<RowId> rids;
+  for (int i = 0; i < 500; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  // Scenario: only the rows of the first page are left, so every other page gets emptied.
+  std::set<page_id_t> emptied_pages;
+  for (auto &rid : rids) {
+    if (rid.GetPageId() != table_heap->GetFirstPageId()) {
+      emptied_pages.insert(rid.GetPageId());
+      ASSERT_TRUE(table_heap->MarkDelete(rid, nullptr));
+    }
+  }
+  ASSERT_GE(emptied_pages.size(), 2);
+  page_id_t pinned_page_id = *emptied_pages.rbegin();
+  ASSERT_NE(nullptr, bpm->FetchPage(pinned_page_id));
+
+  // Scenario: the pinned page leaves the chain but is neither deleted nor counted.
+  VacuumStats vacuum_stats;
+  table_heap->Vacuum(&vacuum_stats, nullptr);
+  EXPECT_EQ(emptied_pages.size() - 1, vacuum_stats.pages_freed_);
+  EXPECT_FALSE(bpm->IsPageFree(pinned_page_id));
+  TableHeapStats stats;
+  table_heap->GetStats(&stats);
+  EXPECT_EQ(1, stats.page_count_);
+
+  // Scenario: once unpinned, the next pass gives it back.
+  bpm->UnpinPage(pinned_page_id, false);
+  table_heap->Vacuum(&vacuum_stats, nullptr);
+  EXPECT_EQ(1, vacuum_stats.pages_freed_);
+  EXPECT_EQ(PAGE_SIZE, vacuum_stats.bytes_reclaimed_);
+  EXPECT_TRUE(bpm->IsPageFree(pinned_page_id));
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, BulkInsertOversizedRowTest) {
+  const std::string db_name = "table_heap_bulk_insert_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("first", TypeId::kTypeChar, 8, 1, true, false),
+                                   new Column("second", TypeId::kTypeChar, 8, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<char> characters(VARCHAR_MAX_LEN, 'a');
+  auto make_row = [&](int id, uint32_t len) {
+    Fields fields{Field(TypeId::kTypeInt, id), Field(TypeId::kTypeChar, characters.data(), len / 2, true),
+                  Field(TypeId::kTypeChar, characters.data(), len - len / 2, true)};
+    return Row(fields);
+  };
+  // 超过列长的部分放在行尾，序列化后正好比空页能放下的多一个字节
+  uint32_t len = 100;
+  len += TablePage::SIZE_MAX_ROW + 1 - make_row(0, len).GetSerializedSize(schema.get());
+  std::vector<Row> rows{make_row(0, 10), make_row(1, len)};
+  ASSERT_EQ(TablePage::SIZE_MAX_ROW + 1, rows[1].GetSerializedSize(schema.get()));
+
+  // Scenario: the batch is refused before anything is inserted or appended.
+  ASSERT_FALSE(table_heap->BulkInsert(rows, nullptr));
+  EXPECT_EQ(INVALID_PAGE_ID, rows[0].GetRowId().GetPageId());
+  TableHeapStats stats;
+  table_heap->GetStats(&stats);
+  EXPECT_EQ(1, stats.page_count_);
+  EXPECT_EQ(0, stats.tuple_count_);
+
+  // Scenario: a row of exactly the largest size fits an empty page.
+  rows = {make_row(0, 10), make_row(1, len - 1)};
+  ASSERT_TRUE(table_heap->BulkInsert(rows, nullptr));
+  table_heap->GetStats(&stats);
+  EXPECT_EQ(2, stats.page_count_);
+  EXPECT_EQ(2, stats.tuple_count_);
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}